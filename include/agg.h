@@ -0,0 +1,89 @@
+// ---------------------- include/agg.h ----------------------
+#ifndef AGG_H
+#define AGG_H
+
+#include <stdint.h>
+#include <pbc/pbc.h>
+#include "pool.h"
+#include "ptau.h"
+
+/**
+ * Aggregation of N proofs that share one verifying tail (g2, g2^{τ^i}, IC),
+ * e.g. the files of one `prover --batch` run (SnarkPack-style).
+ *
+ * Each proof satisfies e(A_i, B_i) = e(C_i + X_i, g2)·e(H_i, g2^{Z(τ)}),
+ * X_i = Σ_j x_ij·IC_j its public-input term (ic.h). With a challenge r the
+ * N checks fold into
+ *   Z = ∏ e(A_i, B_i)^{r^i} = e(Σ r^i C_i + Σ_j s_j·IC_j, g2)·e(Σ r^i H_i, g2^{Z(τ)}),
+ * s_j = Σ_i r^i x_ij (the verifier computes these from the recorded
+ * statements in O(N·l) field operations), and Z is proven with an
+ * inner-pairing-product argument (GIPA).
+ *
+ * The vectors are committed under two independent SRSs, the powers-of-tau
+ * files of separate ceremonies with secrets a and b. Keys k = 1, 2 are
+ *   v_k,i = h_k^{a_k^i} ∈ G2,  w_k,i = g_k^{a_k^{n+i}} ∈ G1     (i < n)
+ * and every commitment is the pair over both keys:
+ *   T_AB = ∏ e(A_i, v_k,i)·e(w_k,i, B_i), T_C = ∏ e(C_i, v_k,i), T_H = ∏ e(H_i, v_k,i).
+ * A single key is not binding: anyone holding g^a, h^a can move weight
+ * between neighbouring entries without changing the product. Two keys
+ * with unrelated secrets, and w shifted past the powers v uses, close that
+ * as in SnarkPack; each powers file needs degree ≥ 2n − 1.
+ *
+ * The vectors are halved log2 n times (n = N rounded up to a power of two,
+ * padded with identities) with Fiat–Shamir challenges x_j. The folded keys
+ * v*, w* are polynomials in a_k evaluated on the SRS; one KZG opening per
+ * key shows they were folded honestly. Verification is O(log N) GT/G1
+ * exponentiations and 17 pairings, whatever N, plus the O(N·l) statement
+ * fold.
+ *
+ * File (framing as in io.h; [2] is key 1 then key 2):
+ *   "G16A" | u32 version | u32 n_proofs | u32 rounds (log2 n) | u32 m | u32 l
+ *   g2 | g2^{τ^0} … g2^{τ^m} | IC_1 … IC_l | x_ij (Zr, proof-major)
+ *   T_AB[2] | T_C[2] | T_H[2] (GT) | Σ r^i C_i | Σ r^i H_i (G1)
+ *   rounds × agg_round_t, in field order
+ *   A* (G1) | B* (G2) | C* | H* (G1) | v*[2] (G2) | w*[2] (G1) | π_v[2] (G2) | π_w[2] (G1)
+ */
+#define AGG_MAGIC "G16A"
+#define AGG_VERSION 3
+
+// One halving: *l terms enter the fold with x, *r terms with x^{-1}.
+typedef struct {
+    element_t zl, zr;         // ∏ e(A_R, B_L), ∏ e(A_L, B_R)
+    element_t abl[2], abr[2]; // ∏ e(A_R, v_L)·e(w_R, B_L), ∏ e(A_L, v_R)·e(w_L, B_R)
+    element_t cl[2], cr[2];   // ∏ e(C_R, v_L), ∏ e(C_L, v_R)
+    element_t hl[2], hr[2];   // ∏ e(H_R, v_L), ∏ e(H_L, v_R)
+    element_t zcl, zcr;       // Σ b_L·C_R, Σ b_R·C_L (G1)
+    element_t zhl, zhr;       // Σ b_L·H_R, Σ b_R·H_L (G1)
+} agg_round_t;
+
+typedef struct {
+    int n_proofs, rounds;
+    element_t g2;           // shared verifying tail
+    int m;
+    element_t *g2_tau;      // m + 1
+    int l;                  // public inputs per proof
+    element_t *ic;          // l
+    element_t *x;           // n_proofs × l statements
+    element_t TAB[2], TC[2], TH[2];
+    element_t ZC, ZH;
+    agg_round_t *round;
+    element_t A, B, C, H;   // folded proof vectors
+    element_t v[2], w[2];   // folded commitment keys
+    element_t pv[2], pw[2]; // KZG openings of v, w
+} agg_t;
+
+// Aggregate the proof files (same tail, IC included) into out_path; srs are
+// the two powers files, of different ceremonies and degree ≥ 2n − 1.
+int agg_create(const char *out_path, char **proof_paths, int n_proofs, ptau_t *srs[2],
+               pool_t *pool, pairing_t pairing);
+
+// Initializes every element of a. Returns 0 on success; non-canonical
+// encodings and points off the curve or outside G1/G2 are rejected.
+int agg_read(const char *path, agg_t *a, pairing_t pairing);
+void agg_clear(agg_t *a);
+
+// 1 if a proves that all aggregated proofs satisfy the Groth16 check under
+// (g2, g2Z), 0 if not; srs must be the powers files a was made with.
+int agg_verify(agg_t *a, element_t g2Z, ptau_t *srs[2], pairing_t pairing);
+
+#endif // AGG_H
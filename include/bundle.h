@@ -0,0 +1,79 @@
+// ---------------------- include/bundle.h ----------------------
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/uio.h>
+#include "io.h"
+
+/**
+ * Proof bundle: many proofs in one file, with an index at the end.
+ *
+ *   "G16B" | u32 version
+ *   tails and records, in the order they were added
+ *   t × { u64 offset | u64 length | circuit id (32) }                      tail table
+ *   n × { u64 offset | u64 length | circuit id (32) | SHA-256 of the record (32) }
+ *   u64 tail table offset | u32 t | u64 index offset | u32 n | "G16X"
+ *
+ * A tail is a verifying tail (g2 | m | g2^{τ^0..τ^m} | l | IC_1..IC_l) and
+ * its circuit id is its SHA-256. Each distinct tail is stored once. A
+ * record is only a proof head (piA | piB | piC | piH | l | x_1..x_l): the
+ * head followed by the tail of its circuit id is byte-for-byte a proof
+ * file (see prover). Integers are big-endian as in io.h.
+ *
+ * The writer collects records as iovecs and issues one writev per
+ * BUNDLE_IOV parts. The caller's buffers must stay valid until
+ * bundle_finish. The reader maps the file and hands out pointers into the
+ * mapping, with sequential readahead.
+ */
+#define BUNDLE_MAGIC "G16B"
+#define BUNDLE_END "G16X"
+#define BUNDLE_VERSION 2
+#define BUNDLE_IOV 256
+#define BUNDLE_ENTRY 80      // index entry bytes
+#define BUNDLE_TAIL_ENTRY 48 // tail table entry bytes
+#define BUNDLE_TRAILER 28
+
+typedef struct {
+    uint64_t offset, length;
+    unsigned char id[32], hash[32];
+} bundle_entry_t;
+
+typedef struct {
+    int fd;
+    uint64_t off; // bytes written or queued
+    int n, cap;
+    bundle_entry_t *idx;
+    int n_tails, tails_cap;
+    bundle_entry_t *tails; // hash unused
+    struct iovec iov[BUNDLE_IOV];
+    int niov;
+} bundle_writer_t;
+
+int bundle_create(bundle_writer_t *w, const char *path);
+// Set id to the circuit id of tail and append the tail unless a tail with
+// that id is already in the bundle.
+int bundle_add_tail(bundle_writer_t *w, const void *tail, size_t len, unsigned char id[32]);
+// Append one record (a proof head) made of parts[0..nparts) under circuit
+// id, whose tail must have been added.
+int bundle_add(bundle_writer_t *w, const struct iovec *parts, int nparts,
+               const unsigned char id[32]);
+// Write the index and close; the writer is unusable afterwards.
+int bundle_finish(bundle_writer_t *w);
+
+typedef struct {
+    io_map_t map;
+    int n, n_tails;
+    const unsigned char *index, *tails;
+} bundle_t;
+
+int bundle_open(bundle_t *b, const char *path);
+void bundle_close(bundle_t *b);
+// Entry i; *rec points into the mapping.
+void bundle_get(const bundle_t *b, int i, bundle_entry_t *e, const unsigned char **rec);
+// The tail stored under circuit id (not yet checked against it), or -1.
+int bundle_find_tail(const bundle_t *b, const unsigned char id[32],
+                     const unsigned char **tail, size_t *len);
+
+#endif // BUNDLE_H
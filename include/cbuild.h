@@ -0,0 +1,71 @@
+// ---------------------- include/cbuild.h ----------------------
+#ifndef CBUILD_H
+#define CBUILD_H
+
+#include <stdio.h>
+#include <pbc/pbc.h>
+#include "circuit.h"
+
+/**
+ * Arithmetic-circuit builder compiling to R1CS.
+ *
+ * Values are handles (cb_ref) to linear combinations over the wires; wire 0
+ * is the constant 1. Constants, additions and scalings only fold the linear
+ * combinations, so they cost nothing. A product of two non-constant values
+ * allocates a wire w and emits a·b = w; assert_eq emits (a − b)·1 = 0.
+ *
+ * The builder also records the witness program: inputs fill their wires in
+ * declaration order and every product wire is computed from earlier wires,
+ * so cb_witness is a single forward pass.
+ */
+typedef int cb_ref;
+typedef struct cb_s cb_t;
+
+cb_t *cb_new(pairing_t pairing);
+void cb_free(cb_t *cb);
+
+cb_ref cb_zero(cb_t *cb);
+cb_ref cb_one(cb_t *cb);
+cb_ref cb_const(cb_t *cb, element_t c);
+cb_ref cb_const_si(cb_t *cb, long c);
+cb_ref cb_input(cb_t *cb, const char *name);
+
+cb_ref cb_add(cb_t *cb, cb_ref a, cb_ref b);
+cb_ref cb_sub(cb_t *cb, cb_ref a, cb_ref b);
+cb_ref cb_scale(cb_t *cb, cb_ref a, element_t k);
+cb_ref cb_mul(cb_t *cb, cb_ref a, cb_ref b);
+void cb_assert_eq(cb_t *cb, cb_ref a, cb_ref b);
+
+int cb_n_wires(cb_t *cb);
+int cb_n_cons(cb_t *cb);
+int cb_n_inputs(cb_t *cb);
+const char *cb_input_name(cb_t *cb, int i);
+
+// Dense A/B/C of the recorded constraints (at least one row: an empty
+// system gets the trivial 0·0 = 0).
+void cb_to_r1cs(cb_t *cb, r1cs_t *r);
+
+// Run the witness program: inputs[i] belongs to the i-th declared input.
+// *wires gets n_wires initialized elements.
+void cb_witness(cb_t *cb, element_t *inputs, element_t **wires);
+
+// Human-readable witness program, one line per wire.
+void cb_print_program(cb_t *cb, FILE *f);
+
+/**
+ * Text front end. One statement per line, '#' starts a comment:
+ *
+ *   input x, y            declare witness inputs
+ *   t = x^2 + 3*x*y - 7   name a value (+ - * ^k, parentheses, integers)
+ *   assert t == 5         constrain two values to be equal
+ *
+ * Returns NULL (after printing "path:line: message") on a syntax error.
+ */
+cb_t *cb_parse_file(const char *path, pairing_t pairing);
+
+// Parse path, bind inputs from name=value arguments, and produce the
+// constraint system and its witness. Returns 0 on success.
+int cb_load(const char *path, int argc, char **argv, pairing_t pairing,
+            r1cs_t *r, element_t **wires);
+
+#endif // CBUILD_H
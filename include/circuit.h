@@ -11,12 +11,34 @@ typedef struct {
     // stored as lists of (index,value)
     // For simplicity: dense matrix
     element_t **A, **B, **C; // dimensions [n_cons][n_vars]
+    // the last n_pub wires are public inputs: their A and B columns are
+    // zero, so a verifier can add their C part from the statement (IC table)
+    int n_pub;
 } r1cs_t;
 
+// build_r1cs's public inputs x and y are wires r1cs_pub(d) and r1cs_pub(d) + 1
+#define CIRCUIT_N_PUB 2
+int r1cs_pub(int d);
+
 // Build R1CS for polynomial evaluation: y = \sum_{i=0}^d a_i x^i
 // Inputs: degree d; coeffs a[0..d]; evaluation point x; claimed y
 // Outputs: r1cs struct, wire vector w (length n_vars)
 void build_r1cs(int d, element_t *coeffs, element_t x, element_t y,
                 r1cs_t *r1cs, element_t **wires, pairing_t pairing);
 
+// Sizes of the system build_r1cs would produce for degree d.
+void r1cs_shape(int d, int *n_vars, int *n_cons);
+
+// Only the witness of build_r1cs (O(d), no matrices); the public y wire
+// gets s_d = f(x).
+void build_witness(int d, element_t *coeffs, element_t x,
+                   element_t **wires, pairing_t pairing);
+
+// Matrix-free QAP columns of build_r1cs's system: given the Lagrange values
+// L[k] = L_k(τ) of the m-point domain, valX[j] = X_j(τ) for every wire j.
+// valA/valB/valC have n_vars slots; elements are initialized here.
+void eval_r1cs_columns(int d, element_t *coeffs, element_t *L,
+                       element_t *valA, element_t *valB, element_t *valC,
+                       pairing_t pairing);
+
 #endif // CIRCUIT_H
\ No newline at end of file
@@ -18,6 +18,9 @@ void fmt_kv_s(const char *k, const char *v);
 void fmt_kv_i(const char *k, long long v);
 void fmt_kv_e(const char *k, element_t e); // pretty-print a field/group element
 
+// symmetric/asymmetric and the G1/G2 encoding sizes of the loaded params
+void fmt_pairing(pairing_t pairing);
+
 /* Print a vector of elements with indices:
  * title: printed once above the list.
  */
@@ -0,0 +1,31 @@
+// ---------------------- include/ic.h ----------------------
+#ifndef IC_H
+#define IC_H
+
+#include <pbc/pbc.h>
+#include "pctx.h"
+
+/**
+ * Public-input query of a verifying key: IC_i = g1^{C_i(τ)} for each
+ * public wire i (see r1cs_t.n_pub). The prover leaves those wires out of
+ * piC. The verifier puts them back from the statement x as
+ * vk_x = Σ x_i·IC_i, and the check becomes
+ *   e(piA, piB) = e(piC + vk_x, g2)·e(piH, g2^{Z(τ)}).
+ *
+ * When many statements are checked under one key, the table keeps a
+ * fixed-base window table per IC_i (pctx.h). vk_x then costs about
+ * bits(r)/FB_WINDOW group additions per input instead of a double-and-add
+ * ladder. Building the tables costs about as much as FB_DIGITS such
+ * ladders, so a single proof is better served by msm().
+ */
+typedef struct {
+    int l;
+    fb_table_t *t;
+} ic_table_t;
+
+void ic_table_init(ic_table_t *t, element_t *ic, int l, pairing_t pairing);
+void ic_table_clear(ic_table_t *t);
+// out (G1, initialized) = Σ x_i·IC_i
+void ic_table_eval(element_t out, const ic_table_t *t, element_t *x);
+
+#endif // IC_H
@@ -0,0 +1,65 @@
+// ---------------------- include/io.h ----------------------
+#ifndef IO_H
+#define IO_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <pbc/pbc.h>
+
+/**
+ * On-disk framing shared by proofs, keys and powers-of-tau files:
+ *   u32 values are big-endian,
+ *   elements are [u32 length][element_to_bytes payload].
+ * All helpers return 0 on success and -1 on error.
+ */
+int write_exact(FILE *f, const void *p, size_t n);
+int write_u32(FILE *f, uint32_t v_host);
+int write_elem(FILE *f, element_t e);
+
+int read_exact(FILE *f, void *p, size_t n);
+int read_u32(FILE *f, uint32_t *out_host);
+// read an element into a fresh G1 / G2 / Zr element (initialized here)
+int read_elem_G1(FILE *f, pairing_t pairing, element_t out);
+int read_elem_G2(FILE *f, pairing_t pairing, element_t out);
+int read_elem_Zr(FILE *f, pairing_t pairing, element_t out);
+// 1 if n framed elements of len bytes each fit in the rest of f: bounds a
+// count from an untrusted header before anything is allocated for it
+int io_fits(FILE *f, uint64_t n, int len);
+// 1 if e is the identity or an affine point with y² = x³ + ax + b. The
+// readers above reject points that fail this or whose encoding is not
+// canonical; subgroup membership is left to ptcheck.h, which batches it.
+int elem_on_curve(element_t e);
+// The same checks on a framed G1/G2 element at *p in memory (out already
+// initialized; a Zr element only needs a canonical encoding); advances *p
+// past it. Nothing is copied besides the decode.
+int io_get_point(element_t out, const unsigned char **p, const unsigned char *end);
+
+// Initialize the pairing from a PBC parameter file or a pairing snapshot
+// (pctx.h); the file is mapped rather than read.
+int load_pairing(const char *path, pairing_t pairing);
+
+// NUL-terminated parameter text of either kind of file (malloc'd); *len
+// counts the NUL.
+char *io_read_params(const char *path, size_t *len);
+int io_is_snapshot(const char *path);
+
+// Read-only memory mapping of a whole file.
+typedef struct {
+    unsigned char *base;
+    size_t size;
+} io_map_t;
+
+int io_map_open(io_map_t *mp, const char *path);
+void io_map_close(io_map_t *mp);
+
+// big-endian u32 at p
+uint32_t io_get_u32(const unsigned char *p);
+
+// Little-endian variants for the circom-compatible .r1cs/.wtns files.
+int write_u32le(FILE *f, uint32_t v);
+int write_u64le(FILE *f, uint64_t v);
+uint32_t io_get_u32le(const unsigned char *p);
+uint64_t io_get_u64le(const unsigned char *p);
+
+#endif // IO_H
@@ -2,24 +2,73 @@
 #ifndef KEYS_H
 #define KEYS_H
 
+#include <stdint.h>
 #include <pbc/pbc.h>
 #include "circuit.h"
 
 // Proving and verifying key structures
 typedef struct {
-    element_t *A_query; // G1 elements length = n_vars
-    element_t *B_query; // G2 elements length = n_vars
-    element_t *C_query; // G1 elements length = n_vars
+    int n_vars, n_cons; // full circuit size
+    int lo, hi;         // columns held here: [lo, hi) (a shard), or [0, n_vars)
+    element_t g1, g2;   // bases
+    element_t *A_query; // G1 elements length = hi - lo
+    element_t *B_query; // G2 elements length = hi - lo
+    element_t *C_query; // G1 elements length = hi - lo
+    // witness-weighted aggregates over [lo, hi): Σ w_j·A_query[j] (G1),
+    // Σ w_j·B_query[j] (G2), Σ w_j·C_query[j] (G1); shards add up to
+    // g1^{A(τ)}, g2^{B(τ)}, g1^{C(τ)}
+    element_t A_agg, B_agg, C_agg;
+    // fingerprint of the circuit the queries came from (NULL if absent):
+    // FNV-1a digest of each column's A/B/C entries and the wire value used
+    // in the aggregates, so `keygen --update` can recompute only what changed
+    uint64_t *col_digest; // length hi - lo
+    element_t *wires;     // Zr, length hi - lo
 } pk_t;
 
 typedef struct {
+    int m;                // g2_tau holds m+1 powers; 0 if this file has none
     element_t *g2_tau;    // G2^{τ^i}
     element_t g2_gamma;   // G2^{γ}
     element_t g2;         // base
+    int l;                // public inputs
+    element_t *ic;        // IC_i = G1^{C_i(τ)} of the public wires (ic.h)
 } vk_t;
 
 // Generate keys from R1CS and tau-powers
 void keygen(const r1cs_t *r1cs, int deg, pairing_t pairing,
             pk_t *pk, vk_t *vk);
 
-#endif // KEYS_H
\ No newline at end of file
+/**
+ * Key file (framing as in io.h):
+ *   "G16K" | u32 version | u32 n_vars | u32 n_cons | u32 lo | u32 hi | u32 flags
+ *   g1 | g2 | A_query[lo..hi) | B_query[lo..hi) | C_query[lo..hi)
+ *   A_agg | B_agg | C_agg
+ *   g2^{τ^0} … g2^{τ^{n_cons}} | u32 l | IC_1 … IC_l   (flags & KEYS_HAS_VK)
+ *   (u32 digest_hi | u32 digest_lo | wire)[lo..hi)   (flags & KEYS_HAS_CIRCUIT)
+ * A shard is the same file with [lo, hi) a sub-range; `keygen --merge`
+ * concatenates shards into one covering [0, n_vars). A verifying key on
+ * its own is a key file with no columns (lo = hi = 0).
+ *
+ * The verifier section serialized as a proof's tail, g2 | u32 m |
+ * g2^{τ^0..τ^m} | u32 l | IC_1..IC_l, hashes to the circuit id that
+ * bundles and aggregates are keyed by (bundle.h).
+ */
+#define KEYS_MAGIC "G16K"
+#define KEYS_VERSION 2
+#define KEYS_HAS_VK 1u
+#define KEYS_HAS_CIRCUIT 2u
+
+// vk may be NULL or have m == 0 (no verifier section). Returns 0 on success.
+int keys_write(const char *path, pk_t *pk, vk_t *vk);
+// A verifying key alone, for a setup of n_vars × n_cons with base g1.
+int keys_write_vk(const char *path, int n_vars, int n_cons, element_t g1, vk_t *vk);
+// Circuit id of vk (m > 0): SHA-256 of its proof-tail serialization
+void keys_vk_id(vk_t *vk, unsigned char id[32]);
+// Digest of column j of A, B and C (nonzero entries with their rows)
+uint64_t keys_column_digest(const r1cs_t *r, int j);
+
+// Initializes every element of pk (and vk, if non-NULL). Returns 0 on success.
+int keys_read(const char *path, pk_t *pk, vk_t *vk, pairing_t pairing);
+void keys_clear(pk_t *pk, vk_t *vk);
+
+#endif // KEYS_H
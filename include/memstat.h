@@ -0,0 +1,32 @@
+// ---------------------- include/memstat.h ----------------------
+#ifndef MEMSTAT_H
+#define MEMSTAT_H
+
+/**
+ * Opt-in memory accounting (GROTH16_MEMSTAT set and not "0").
+ *
+ * memstat_init() routes GMP and PBC allocations through counting wrappers
+ * (mp_set_memory_functions, pbc_set_memory_functions). That covers the
+ * payload of every element_t and mpz_t: the bulk of r1cs_t matrices, QAP
+ * columns, queries and g2^{τ^i} tails. The element_t arrays themselves
+ * (16 bytes a slot, plain malloc) are not counted. Each block carries a
+ * small header with its size and the stage that allocated it. Per stage
+ * there are live bytes, allocations, frees, total bytes and a high-water
+ * mark of its live bytes.
+ *
+ * The table goes to stderr at exit and on SIGUSR1 (e.g. `kill -USR1 pid`
+ * during a long keygen), with the process's peak and current RSS.
+ */
+#define MEMSTAT_STAGES 32
+
+// Call first in main, before anything touches GMP or PBC.
+void memstat_init(void);
+
+// Later allocations count against this stage (a string literal); no-op
+// when accounting is off.
+void memstat_stage(const char *name);
+
+// Write the table to fd; async-signal-safe.
+void memstat_dump(int fd);
+
+#endif // MEMSTAT_H
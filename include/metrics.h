@@ -0,0 +1,67 @@
+// ---------------------- include/metrics.h ----------------------
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+
+/**
+ * Opt-in latency metrics for prover and verifier (GROTH16_METRICS set and
+ * not "0").
+ *
+ * Every request (one proof made or checked) and each of its phases feeds a
+ * log-linear histogram of nanoseconds, HdrHistogram-style: 8 sub-buckets
+ * per power of two, so a quantile read back is within 12.5% of the true
+ * value. There are counters for requests, accepted and rejected proofs and
+ * proof bytes, and a queue-depth gauge for the instances of a batch or
+ * bundle still to go. All of it is relaxed atomics, safe from pool workers.
+ *
+ * The snapshot is Prometheus text format. GROTH16_METRICS says where it
+ * goes:
+ *   path        written at exit and on `kill -USR2 <pid>`, through a
+ *               temporary file and rename (node_exporter textfile collector)
+ *   unix:path   a stats socket; every connection gets the current snapshot
+ *               (`nc -U path`, `curl --unix-socket path http://x/metrics`)
+ *   tcp:port    the same on 127.0.0.1:port, for a scraper
+ * A background thread serves the socket or waits for SIGUSR2.
+ */
+enum {
+    METRICS_DECODE,    // reading and checking a proof or the inputs
+    METRICS_WITNESS,   // wires (and matrices on the dense path)
+    METRICS_QAP,       // column values at τ, aggregates, H(τ)
+    METRICS_MSM,       // group exponentiations and multi-exponentiations
+    METRICS_PAIRING,
+    METRICS_SERIALIZE, // proof file or bundle record
+    METRICS_REQUEST,   // one proof end to end
+    METRICS_PHASES
+};
+
+enum {
+    METRICS_REQUESTS,
+    METRICS_ACCEPTED,
+    METRICS_REJECTED,
+    METRICS_BYTES,
+    METRICS_COUNTERS
+};
+
+// Call early in main, before the thread pool exists; prog labels the series.
+void metrics_init(const char *prog);
+
+// Monotonic clock in ns; 0 when metrics are off.
+uint64_t metrics_now(void);
+
+// Record now − t0 (t0 from metrics_now) as one sample of phase.
+void metrics_since(int phase, uint64_t t0);
+
+// Record n samples of ns each, e.g. a batch step amortized over its instances.
+void metrics_record(int phase, uint64_t ns, int n);
+
+void metrics_add(int counter, long long v);
+
+// Queue depth: set, or move by delta.
+void metrics_queue(long long depth);
+void metrics_queue_add(long long delta);
+
+// Write the snapshot to fd.
+void metrics_dump(int fd);
+
+#endif // METRICS_H
@@ -0,0 +1,44 @@
+// ---------------------- include/msm.h ----------------------
+#ifndef MSM_H
+#define MSM_H
+
+#include <stddef.h>
+#include <pbc/pbc.h>
+
+/**
+ * Multi-scalar multiplication  out = Σ_i scalars[i] · bases[i]
+ * (written additively; in PBC's multiplicative notation ∏ bases[i]^{scalars[i]}).
+ *
+ * Pippenger's bucket method with c-bit windows: each window costs n
+ * bucket additions plus 2·2^c to fold the buckets, instead of one full
+ * exponentiation per term. bases are G1 or G2 elements, scalars are Zr;
+ * out must already be initialized in the bases' group.
+ * Bucket additions are queued per window and applied MSM_BATCH at a time
+ * with element_multi_add, which shares one field inversion across the
+ * batch instead of paying one per affine addition.
+ * Thread-safe: all scratch is local to the call.
+ */
+void msm(element_t out, element_t *bases, element_t *scalars, int n);
+
+/**
+ * Out-of-core variant for bases that stay in a mapped file: base i is
+ * the element encoded at data + i·stride (a powers-of-tau or key table,
+ * with stride covering each element's length prefix).
+ *
+ * Each base is decoded once, added to its bucket in every window in the
+ * same pass and dropped, so memory is O(windows·2^c) whatever n (c is
+ * capped at MSM_STREAM_MAX_C). The mapping is advised sequential, and the
+ * next MSM_STREAM_CHUNK bases are prefetched (MADV_WILLNEED) while the
+ * current chunk is accumulated, so reads overlap the group additions.
+ */
+#define MSM_STREAM_CHUNK 4096
+#define MSM_STREAM_MAX_C 12
+
+typedef struct {
+    const unsigned char *data; // encoding of base 0
+    size_t stride;
+} msm_src_t;
+
+void msm_stream(element_t out, const msm_src_t *src, element_t *scalars, int n);
+
+#endif // MSM_H
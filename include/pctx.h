@@ -0,0 +1,51 @@
+// ---------------------- include/pctx.h ----------------------
+#ifndef PCTX_H
+#define PCTX_H
+
+#include <pbc/pbc.h>
+#include "io.h"
+
+/**
+ * Pairing context: the pairing, a pair of bases g1 ∈ G1, g2 ∈ G2 and
+ * fixed-base window tables for both, so g^e costs one group operation per
+ * FB_WINDOW bits of e instead of a square-and-multiply ladder.
+ *
+ * `pot --snapshot` stores all of it in one file that every binary accepts
+ * in place of a .param file:
+ *
+ *   "G16S" | u32 version | u32 params_len | params text (NUL-terminated)
+ *   g1 | g2 | g1 table | g2 table   (framed elements, see io.h)
+ *
+ * A context opened from plain params samples random bases and builds the
+ * tables in memory instead.
+ */
+#define PCTX_MAGIC "G16S"
+#define PCTX_VERSION 1
+#define FB_WINDOW 4
+#define FB_DIGITS ((1 << FB_WINDOW) - 1)
+
+typedef struct {
+    int windows;  // ceil(bits(r) / FB_WINDOW)
+    element_t *t; // t[i·FB_DIGITS + k − 1] = base^{k·2^{FB_WINDOW·i}}
+} fb_table_t;
+
+void fb_table_init(fb_table_t *t, element_t base, pairing_t pairing);
+void fb_table_clear(fb_table_t *t);
+// out (initialized, same group as the base) = base^e; tables are read-only,
+// so concurrent calls are fine.
+void fb_pow(element_t out, const fb_table_t *t, element_t e);
+
+typedef struct {
+    int snapshot; // loaded from a snapshot file
+    element_t g1, g2;
+    fb_table_t t1, t2;
+} pctx_t;
+
+// Initializes pairing and ctx from a .param file or a snapshot.
+int pctx_open(pctx_t *c, const char *path, pairing_t pairing);
+void pctx_close(pctx_t *c);
+
+// Snapshot of c (with the params text of params_path) to out_path.
+int pctx_write(const char *out_path, const char *params_path, pctx_t *c);
+
+#endif // PCTX_H
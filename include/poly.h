@@ -4,6 +4,15 @@
 
 #include <pbc/pbc.h>
 
+/**
+ * Small domains. A polynomial circuit of degree ≤ 32 has at most
+ * 2·32 + 2 constraints; up to POLY_SMALL points the QAP kernels
+ * (qap_lagrange_at, qap_eval_columns, subprod_Z_range) keep their scratch
+ * in fixed-size stack arrays, reuse per-size constants and skip the
+ * subproduct tree. Larger domains take the general paths.
+ */
+#define POLY_SMALL 66
+
 // Given m points (tau_i, eval_i), compute coeffs of polynomial deg<m
 // via naive Lagrange interpolation
 // allocates out[0..m-1]
@@ -29,4 +38,45 @@
 void lagrange_interpolation(element_t *out, element_t *tau, element_t *eval,
                             int m, pairing_t pairing);
 
+// ---- dense polynomial arithmetic over Zr (coefficients low → high) ----
+
+// Horner evaluation: out = coeffs[0] + coeffs[1]·t + … + coeffs[m-1]·t^{m-1}
+void poly_eval(element_t out, element_t *coeffs, int m, element_t t);
+
+// Allocate n Zr elements, all set to 0. Release with poly_free.
+element_t *poly_alloc(int n, pairing_t pairing);
+void poly_free(element_t *p, int n);
+
+/**
+ * res[0..na+nb-2] = a · b.
+ * res must hold na+nb-1 initialized elements; it may alias a or b.
+ * Uses an NTT when Zr has a large enough 2-power root of unity
+ * (type A: r−1 is divisible by 2^107), Karatsuba otherwise, and
+ * schoolbook for short operands.
+ */
+void poly_mul(element_t *res, element_t *a, int na, element_t *b, int nb,
+              pairing_t pairing);
+
+/**
+ * Newton iteration for the power-series inverse:
+ *   out[0..k-1] such that a · out ≡ 1 (mod x^k).
+ * Requires a[0] != 0; out holds k initialized elements.
+ */
+void poly_inv_series(element_t *out, element_t *a, int na, int k,
+                     pairing_t pairing);
+
+/**
+ * Division with remainder a = q·b + r, with deg r < deg b.
+ * q holds na-nb+1 initialized elements (skipped if na < nb),
+ * r holds nb-1 initialized elements. b[nb-1] must be nonzero.
+ * Long quotients go through the reversed-polynomial Newton inverse,
+ * so the cost is that of two multiplications.
+ */
+void poly_divrem(element_t *q, element_t *r, element_t *a, int na,
+                 element_t *b, int nb, pairing_t pairing);
+
+// out[i] = 1 / in[i] with a single field inversion (Montgomery's trick).
+// out must hold n initialized elements; in[i] must all be nonzero.
+void poly_batch_invert(element_t *out, element_t *in, int n, pairing_t pairing);
+
 #endif // POLY_H
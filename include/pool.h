@@ -0,0 +1,32 @@
+// ---------------------- include/pool.h ----------------------
+#ifndef POOL_H
+#define POOL_H
+
+/**
+ * Fixed-size thread pool running parallel-for jobs.
+ *
+ * Tasks 0..n-1 are split into one contiguous range per worker; a worker
+ * that runs dry steals the upper half of another worker's remaining range.
+ * The calling thread is worker 0, so a 1-thread pool spawns nothing and
+ * runs tasks in order.
+ *
+ * fn(task, worker, ctx) gets the worker index in [0, pool_size) so
+ * callers can keep per-thread PBC scratch (element_t buffers) without
+ * locking. Tasks must not call element_random: it draws from the process
+ * generator (rng.h), which is not locked.
+ */
+typedef void (*pool_task_fn)(int task, int worker, void *ctx);
+
+typedef struct pool_s pool_t;
+
+// GROTH16_THREADS if set, otherwise the number of online CPUs
+int pool_default_threads(void);
+
+pool_t *pool_create(int nthreads);
+void pool_destroy(pool_t *p);
+int pool_size(pool_t *p);
+
+// Run fn for every task in [0, n_tasks); returns when all have finished.
+void pool_for(pool_t *p, int n_tasks, pool_task_fn fn, void *ctx);
+
+#endif // POOL_H
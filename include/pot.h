@@ -3,9 +3,11 @@
 #define POT_H
 
 #include <pbc/pbc.h>
+#include "pctx.h"
 
-// Compute and print powers of tau up to degree 'deg'
-// tau is random in Zr
-void generate_pot(int deg, pairing_t pairing);
+// Compute and print powers of tau up to degree 'deg' over the context's
+// bases. tau is random in Zr. If out_path is non-NULL the G1/G2 powers are
+// also written there in the binary format of ptau.h. Returns 0 on success.
+int generate_pot(int deg, pctx_t *ctx, pairing_t pairing, const char *out_path);
 
 #endif // POT_H
\ No newline at end of file
@@ -0,0 +1,52 @@
+// ---------------------- include/ptau.h ----------------------
+#ifndef PTAU_H
+#define PTAU_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <pbc/pbc.h>
+#include "io.h"
+
+/**
+ * Binary powers-of-tau file written by `pot`:
+ *
+ *   "G16P" | u32 version | u32 deg
+ *   g1^{τ^0} … g1^{τ^deg}   (framed elements, see io.h)
+ *   g2^{τ^0} … g2^{τ^deg}
+ *   u32 n | n × (g1^{τ_k}, g2^{s_k})   (version 2: contribution transcript)
+ *
+ * τ_k = s_1·…·s_k is the secret after contribution k (pot's own τ is s_1),
+ * so consecutive records satisfy e(g1^{τ_k}, g2) = e(g1^{τ_{k−1}}, g2^{s_k})
+ * and the last g1^{τ_n} is the table's g1^{τ^1}. Version 1 files have no
+ * transcript.
+ *
+ * Every element of a group has the same encoded length, so the tables
+ * have a fixed stride and readers index straight into an mmapped file.
+ */
+#define PTAU_MAGIC "G16P"
+#define PTAU_VERSION 2
+
+typedef struct {
+    io_map_t map;
+    int deg;
+    unsigned char *g1, *g2; // first record of each table
+    size_t g1_stride;       // 4-byte length prefix + element bytes
+    size_t g2_stride;
+    int n_contrib;          // transcript records (0 for version 1)
+    unsigned char *contrib; // first record
+} ptau_t;
+
+int ptau_write_header(FILE *f, int deg);
+
+// Map and validate a powers file against the pairing's element sizes.
+int ptau_open(ptau_t *pt, const char *path, pairing_t pairing);
+void ptau_close(ptau_t *pt);
+
+// out (already initialized in G1 / G2) = g^{τ^i}, decoded from the mapping
+void ptau_get_g1(element_t out, ptau_t *pt, int i);
+void ptau_get_g2(element_t out, ptau_t *pt, int i);
+
+// g1tau = g1^{τ_k}, s2 = g2^{s_k} of contribution record k (both initialized)
+void ptau_get_contrib(element_t g1tau, element_t s2, ptau_t *pt, int k);
+
+#endif // PTAU_H
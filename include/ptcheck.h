@@ -0,0 +1,55 @@
+// ---------------------- include/ptcheck.h ----------------------
+#ifndef PTCHECK_H
+#define PTCHECK_H
+
+#include <pbc/pbc.h>
+#include "rng.h"
+
+/**
+ * Batched subgroup check for points decoded from untrusted files.
+ *
+ * A point on the curve lies in the order-r group G iff r·P = O, which is a
+ * full scalar multiplication per point. Where the curve has cofactor 1 the
+ * queued points of the group are folded as S = Σ ρ_i·P_i with random
+ * PTCHECK_BITS-bit ρ_i (one MSM) and only r·S is checked: every point off
+ * G then has a component of order r, which survives the fold with
+ * probability 2^-PTCHECK_BITS. With a cofactor h > 1 a component of order
+ * ℓ | h would survive with probability 1/ℓ, and ℓ = 2 for the type A
+ * params (h is a multiple of 12), so those groups check r·P = O per point.
+ *
+ * Curve membership costs a few field operations and is checked per point,
+ * by ptcheck_add and by the io.h readers. Those readers also reject
+ * non-canonical encodings.
+ */
+#define PTCHECK_BITS 128
+
+typedef struct {
+    pairing_ptr pairing;
+    int n[2], cap[2]; // G1, G2 (one group if symmetric)
+    element_t *pt[2]; // copies of the queued points
+    int fold[2];      // ptcheck_folds of G1, G2
+    int bad;          // a queued element was not a curve point
+} ptcheck_t;
+
+void ptcheck_init(ptcheck_t *c, pairing_t pairing);
+void ptcheck_clear(ptcheck_t *c);
+
+// Queue a G1 or G2 element for the subgroup check; anything else, or a
+// point off the curve, fails the next ptcheck_run.
+void ptcheck_add(ptcheck_t *c, element_t e);
+void ptcheck_add_vec(ptcheck_t *c, element_t *v, int n);
+
+// 1 if every queued point passed (up to the error above); empties the queue.
+int ptcheck_run(ptcheck_t *c, rng_t *r);
+
+// 1 if r·e = O. Per point, or for sums that already fold many points with
+// random coefficients (such as the ones pot --verify computes) where
+// ptcheck_folds holds.
+int ptcheck_one(element_t e);
+
+// 1 if group g (G1 or G2) has cofactor 1, so a folded check is sound. By
+// the Hasse bound the curve over a field of Q elements has at most
+// Q + 1 + 2√Q points, which is below 2r only when G is all of it.
+int ptcheck_folds(field_ptr g);
+
+#endif // PTCHECK_H
@@ -0,0 +1,46 @@
+// ---------------------- include/qap.h ----------------------
+#ifndef QAP_H
+#define QAP_H
+
+#include <pbc/pbc.h>
+#include "circuit.h"
+#include "subprod.h"
+#include "pool.h"
+
+/**
+ * Column-wise R1CS → QAP reduction. Column j of A (resp. B, C) holds the
+ * evaluations of A_j(x) on the tree's domain; every column is independent,
+ * so all three matrices are processed as 3·n pool tasks.
+ */
+
+// valA[j] = A_j(τ), valB[j] = B_j(τ), valC[j] = C_j(τ) for j = 0..n-1.
+// valA/valB/valC are allocated with n slots; elements are initialized here.
+// Up to POLY_SMALL constraints the columns are summed against L_k(τ) with
+// no interpolation and tree is not used (it may be NULL).
+void qap_eval_columns(pool_t *pool, const r1cs_t *r, subprod_tree_t *tree,
+                      element_t tau, element_t *valA, element_t *valB,
+                      element_t *valC, pairing_t pairing);
+
+// Coefficients of A_j, B_j, C_j for j in [j0, j1): polyX[j-j0] points to an
+// allocated row of m slots; elements are initialized here.
+void qap_interp_columns(pool_t *pool, const r1cs_t *r, subprod_tree_t *tree,
+                        int j0, int j1, element_t **polyA, element_t **polyB,
+                        element_t **polyC);
+
+// Same for an arbitrary list of columns: polyX[i] belongs to column cols[i].
+void qap_interp_column_list(pool_t *pool, const r1cs_t *r, subprod_tree_t *tree,
+                            const int *cols, int ncols, element_t **polyA,
+                            element_t **polyB, element_t **polyC);
+
+// L[k] = L_k(τ), the Lagrange basis of the domain {1..m} evaluated at τ, in
+// O(m) with a single inversion (none for m ≤ POLY_SMALL after the first
+// call of that size). L has m slots; elements are initialized here.
+void qap_lagrange_at(element_t *L, int m, element_t tau, pairing_t pairing);
+
+// out = Σ_j a[j]·b[j]. Partial sums are taken over fixed-size chunks and
+// combined in chunk order, so the result is independent of the thread count.
+// out must be initialized.
+void qap_inner_product(pool_t *pool, element_t out, element_t *a, element_t *b,
+                       int n, pairing_t pairing);
+
+#endif // QAP_H
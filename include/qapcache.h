@@ -0,0 +1,66 @@
+// ---------------------- include/qapcache.h ----------------------
+#ifndef QAPCACHE_H
+#define QAPCACHE_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <pbc/pbc.h>
+#include "circuit.h"
+#include "io.h"
+#include "pool.h"
+
+/**
+ * Content-addressed QAP artifacts, written by `interpolate` and reused by
+ * keygen and prover instead of interpolating every column again:
+ *
+ *   "G16Q" | u32 version | u32 n | u32 m | u32 elem | 32-byte key
+ *   for j = 0..n-1:  A_j[0..m) | B_j[0..m) | C_j[0..m)
+ *
+ * Coefficients are raw Zr encodings of elem bytes each, so a column is a
+ * fixed offset into the mapped file. The key is the SHA-256 of Zr's order,
+ * the domain size and every nonzero entry of A, B and C; files are named
+ * <key>.qap under $GROTH16_QAP_CACHE (default .qap-cache; an empty value
+ * disables the cache).
+ */
+#define QAP_CACHE_MAGIC "G16Q"
+#define QAP_CACHE_VERSION 1
+
+typedef struct {
+    io_map_t map;
+    int n, m;
+    size_t elem;
+    const unsigned char *data;
+} qap_cache_t;
+
+void qap_circuit_hash(unsigned char out[32], const r1cs_t *r, pairing_t pairing);
+
+// Cache file for key (malloc'd), or NULL when the cache is disabled.
+char *qap_cache_path(const unsigned char key[32]);
+
+// 0 on a hit; a miss is silent.
+int qap_cache_open(qap_cache_t *c, const r1cs_t *r, pairing_t pairing);
+void qap_cache_close(qap_cache_t *c);
+
+// out[0..m) (initialized here) = coefficients of column j of A/B/C (which = 0/1/2)
+void qap_cache_column(element_t *out, const qap_cache_t *c, int j, int which,
+                      pairing_t pairing);
+
+// Same contract as qap_eval_columns, but Horner-evaluates the cached
+// coefficients instead of interpolating: no subproduct tree is needed.
+void qap_cache_eval(pool_t *pool, const qap_cache_t *c, element_t tau,
+                    element_t *valA, element_t *valB, element_t *valC,
+                    pairing_t pairing);
+
+// Streaming writer: columns are appended in order 0..n-1 into a temporary
+// file that qap_cache_finish renames into place.
+typedef struct {
+    FILE *f;
+    char *path, *tmp;
+    int n, m, next, err;
+} qap_cache_writer_t;
+
+int qap_cache_begin(qap_cache_writer_t *w, const r1cs_t *r, pairing_t pairing);
+void qap_cache_append(qap_cache_writer_t *w, element_t *A, element_t *B, element_t *C);
+int qap_cache_finish(qap_cache_writer_t *w);
+
+#endif // QAPCACHE_H
@@ -0,0 +1,47 @@
+// ---------------------- include/r1cs_opt.h ----------------------
+#ifndef R1CS_OPT_H
+#define R1CS_OPT_H
+
+#include <pbc/pbc.h>
+#include "circuit.h"
+
+/**
+ * Constraint-system optimizer for any r1cs_t whose wire 0 is the constant 1.
+ *
+ * 1) A constraint with a constant A or B row (only wire 0 set) is linear,
+ *    L·w = 0. It is removed by solving for one of its wires and substituting
+ *    that wire everywhere else (Gaussian elimination, sparsest pivot first).
+ *    At least one constraint is always kept.
+ * 2) Empty and duplicate constraints are dropped.
+ * 3) Wires whose column is zero in A, B and C are dropped; wires with
+ *    identical columns always appear together and are merged into one.
+ *
+ * Wire 0 stays wire 0 and the public wires stay last: they are never
+ * dropped or merged, and linear constraints that mention them are kept, so
+ * their columns stay C-only. The old witness maps onto the new one through map:
+ * new_w[k] = Σ_{j : map[j] = k} old_w[j] (map[j] = -1 for dropped wires).
+ */
+typedef struct {
+    int cons_in, cons_out;
+    int vars_in, vars_out;
+    int linear;     // linear constraints substituted away
+    int dup_cons;   // empty or duplicate constraints dropped
+    int dead_wires; // zero columns dropped (includes substituted wires)
+    int merged;     // wires folded into an identical column
+} r1cs_opt_stats_t;
+
+// GROTH16_R1CS_OPT set to anything but "0"
+int r1cs_opt_requested(void);
+
+// Optimize r in place. map (may be NULL) gets malloc'd int[old n_vars].
+void r1cs_optimize(r1cs_t *r, int **map, r1cs_opt_stats_t *st, pairing_t pairing);
+
+// out[k] = Σ_{map[j] = k} in[j]; out has n_out slots, initialized here.
+void r1cs_remap_witness(element_t *out, int n_out, const int *map,
+                        element_t *in, int n_in, pairing_t pairing);
+
+// Convenience for the build_r1cs call sites: optimize and remap *wires
+// in place when r1cs_opt_requested().
+void r1cs_maybe_optimize(r1cs_t *r, element_t **wires, pairing_t pairing);
+
+#endif // R1CS_OPT_H
@@ -0,0 +1,87 @@
+// ---------------------- include/r1csfile.h ----------------------
+#ifndef R1CSFILE_H
+#define R1CSFILE_H
+
+#include <stdint.h>
+#include <pbc/pbc.h>
+#include "circuit.h"
+#include "io.h"
+
+/**
+ * circom/snarkjs-compatible binary constraint systems and witnesses.
+ * All integers are little-endian; field elements are n8-byte little-endian
+ * integers in [0, r), n8 = the modulus size rounded up to 8 bytes.
+ *
+ * .r1cs: "r1cs" | u32 version 1 | u32 n_sections, then sections
+ *        [u32 type][u64 size][payload]:
+ *   1 header:      u32 n8 | prime | u32 n_wires | u32 n_pub_out |
+ *                  u32 n_pub_in | u32 n_prv_in | u64 n_labels | u32 m
+ *   2 constraints: m × (A, B, C), each LC = u32 n_terms | n_terms ×
+ *                  (u32 wire | coeff)
+ *   3 wire→label:  n_wires × u64
+ * .wtns: "wtns" | u32 version 2 | u32 2 |
+ *   1 header:      u32 n8 | prime | u32 n_witness
+ *   2 values:      n_witness × n8 bytes
+ *
+ * Public wires are circom's 1..n_pub_out + n_pub_in and an r1cs_t's last
+ * n_pub (circuit.h); writing and r1cs_file_to_dense/r1cs_load_files map
+ * one order onto the other, and the writer counts them as public inputs.
+ * r1cs_file_lc and r1cs_lc_wire give circom's numbering.
+ *
+ * Readers map the file and decode on access; the only allocation is an
+ * m-entry index of constraint offsets built while validating the file.
+ * Validation rejects empty systems (no constraints or no wires), values
+ * outside [0, r), public wires in an A or B column (their C part is what
+ * the verifier adds back) and witnesses whose wire 0 is not 1.
+ */
+typedef struct {
+    io_map_t map;
+    uint32_t n8;
+    uint32_t n_wires, n_pub_out, n_pub_in, n_prv_in;
+    uint32_t n_pub; // n_pub_out + n_pub_in
+    uint32_t n_cons;
+    const unsigned char *cons; // constraints section payload
+    uint64_t *row;             // byte offset of constraint k in cons
+} r1cs_file_t;
+
+// one linear combination inside the mapping
+typedef struct {
+    uint32_t n;
+    uint32_t n8;
+    const unsigned char *terms;
+} r1cs_lc_view_t;
+
+typedef struct {
+    io_map_t map;
+    uint32_t n8;
+    uint32_t n;
+    const unsigned char *values;
+} wtns_file_t;
+
+// Open and validate; the header prime must be the pairing's group order.
+int r1cs_file_open(r1cs_file_t *f, const char *path, pairing_t pairing);
+void r1cs_file_close(r1cs_file_t *f);
+
+// LC of constraint k; which = 0 (A), 1 (B), 2 (C)
+void r1cs_file_lc(const r1cs_file_t *f, int k, int which, r1cs_lc_view_t *lc);
+uint32_t r1cs_lc_wire(const r1cs_lc_view_t *lc, int t);
+// out must be an initialized Zr element
+void r1cs_lc_coef(element_t out, const r1cs_lc_view_t *lc, int t);
+
+// Dense copy for the stages that work on r1cs_t.
+void r1cs_file_to_dense(const r1cs_file_t *f, r1cs_t *r, pairing_t pairing);
+
+int wtns_file_open(wtns_file_t *w, const char *path, pairing_t pairing);
+void wtns_file_close(wtns_file_t *w);
+// out must be an initialized Zr element
+void wtns_file_get(element_t out, const wtns_file_t *w, int i);
+
+int r1cs_file_write(const char *path, const r1cs_t *r, pairing_t pairing);
+// wires in r1cs_t order, the last n_pub public
+int wtns_file_write(const char *path, element_t *wires, int n, int n_pub, pairing_t pairing);
+
+// Load both files, checking that the witness covers every wire.
+int r1cs_load_files(const char *r1cs_path, const char *wtns_path, pairing_t pairing,
+                    r1cs_t *r, element_t **wires);
+
+#endif // R1CSFILE_H
@@ -0,0 +1,50 @@
+// ---------------------- include/rng.h ----------------------
+#ifndef RNG_H
+#define RNG_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <gmp.h>
+#include <pbc/pbc.h>
+
+/**
+ * ChaCha20 CSPRNG with fast key erasure: every refill runs RNG_BLOCKS
+ * blocks under the current key, the first 32 output bytes replace the key
+ * and the rest are handed out. Earlier outputs cannot be recovered from a
+ * later state.
+ *
+ * rng_install() seeds one process-wide generator and routes PBC's
+ * element_random through it, so τ, the bases and blinding factors no longer
+ * read the OS entropy device per call. GROTH16_SEED=<string> seeds it
+ * deterministically from SHA-256 of the string instead, for reproducible
+ * benchmark and test runs; such runs are not secure.
+ *
+ * A generator is not locked. Pool tasks that need randomness get their own
+ * rng_t, seeded with rng_bytes from the process one.
+ */
+#define RNG_BLOCKS 16
+
+typedef struct {
+    uint32_t key[8];
+    unsigned char buf[64 * RNG_BLOCKS];
+    size_t pos; // next unused byte of buf
+} rng_t;
+
+void rng_seed(rng_t *r, const unsigned char seed[32]);
+// 32 bytes from getrandom (or /dev/urandom); -1 if neither works
+int rng_seed_os(rng_t *r);
+void rng_wipe(rng_t *r);
+
+void rng_bytes(rng_t *r, void *out, size_t n);
+// z uniform in [0, limit), by rejection
+void rng_mpz(rng_t *r, mpz_t z, mpz_t limit);
+// n initialized Zr elements, uniform in the field
+void rng_scalars(rng_t *r, element_t *out, int n);
+
+// Seed the process generator and hook it into PBC; idempotent.
+int rng_install(void);
+rng_t *rng_process(void);
+// human-readable seed source, for the banner
+const char *rng_source(void);
+
+#endif // RNG_H
@@ -0,0 +1,20 @@
+// ---------------------- include/sha256.h ----------------------
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// FIPS 180-4 SHA-256, incremental.
+typedef struct {
+    uint32_t h[8];
+    uint64_t len; // bytes absorbed
+    unsigned char buf[64];
+    size_t fill;
+} sha256_t;
+
+void sha256_init(sha256_t *s);
+void sha256_update(sha256_t *s, const void *data, size_t n);
+void sha256_final(sha256_t *s, unsigned char out[32]);
+
+#endif // SHA256_H
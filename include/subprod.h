@@ -0,0 +1,47 @@
+// ---------------------- include/subprod.h ----------------------
+#ifndef SUBPROD_H
+#define SUBPROD_H
+
+#include <pbc/pbc.h>
+
+/**
+ * Subproduct tree over m distinct points τ_0..τ_{m-1}.
+ *
+ * Node i covers a contiguous range of points and stores
+ *   ∏_{k in range} (x − τ_k)
+ * with children 2i and 2i+1 splitting the range in half; node 1 is
+ * Z(x) = ∏_k (x − τ_k). Built in O(m log² m) with fast multiplication,
+ * after which multipoint evaluation and interpolation over the same
+ * points also cost O(m log² m) instead of O(m²) / O(m³).
+ *
+ * Works for any point set, so the demo domain τ_k = k+1 needs no change:
+ * results are identical to lagrange_interpolation / the schoolbook Z(x).
+ * A built tree is read-only and may be shared between threads.
+ */
+typedef struct {
+    int m;
+    element_t **node; // node[i][0..len[i]-1], heap-indexed, i ≥ 1
+    int *len;
+    element_t *pts;   // copy of τ_0..τ_{m-1}
+    element_t *inv_w; // 1 / Z'(τ_k), barycentric weights for interpolation
+    pairing_ptr pairing;
+} subprod_tree_t;
+
+void subprod_tree_init(subprod_tree_t *t, element_t *pts, int m, pairing_t pairing);
+void subprod_tree_clear(subprod_tree_t *t);
+
+// out[0..m] = coefficients of Z(x); out is allocated, elements are initialized here
+void subprod_Z(element_t *out, subprod_tree_t *t);
+
+// Same for the domain {1..m} without a caller-built tree. Up to POLY_SMALL
+// points the product is multiplied out over the integers, with no tree.
+void subprod_Z_range(element_t *out, int m, pairing_t pairing);
+
+// out[k] = P(τ_k) for P = coeffs[0..n-1]; out (length m) is initialized here
+void subprod_multi_eval(element_t *out, element_t *coeffs, int n, subprod_tree_t *t);
+
+// Drop-in for lagrange_interpolation over the tree's points:
+// out[0..m-1] (initialized here) with P(τ_k) = eval[k]
+void subprod_interpolate(element_t *out, element_t *eval, subprod_tree_t *t);
+
+#endif // SUBPROD_H
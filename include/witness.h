@@ -0,0 +1,25 @@
+// ---------------------- include/witness.h ----------------------
+#ifndef WITNESS_H
+#define WITNESS_H
+
+#include <pbc/pbc.h>
+#include "pool.h"
+
+/**
+ * Parallel witness generation for build_r1cs's circuit (same layout and
+ * values as build_witness, public x and y included). The powers w_i = x^i and the partial sums
+ * s_i = s_{i-1} + a_i·w_i are scans: the index range is cut into blocks,
+ * each block seeds its powers with x^lo (one exponentiation) and its sums
+ * with 0, then the block totals are prefix-summed and added back as carries.
+ * Small degrees fall back to the serial build_witness.
+ */
+void witness_build(pool_t *pool, int d, element_t *coeffs, element_t x,
+                   element_t **wires, pairing_t pairing);
+
+// wires[k] (allocated here) for every xs[k]: parallel across instances
+// when there are at least as many as threads, otherwise one blocked scan
+// per instance.
+void witness_build_batch(pool_t *pool, int d, element_t *coeffs, element_t *xs,
+                         int nx, element_t **wires, pairing_t pairing);
+
+#endif // WITNESS_H
@@ -0,0 +1,1116 @@
+// src/agg.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pbc/pbc.h>
+#include "../include/agg.h"
+#include "../include/msm.h"
+#include "../include/sha256.h"
+#include "../include/rng.h"
+#include "../include/ptcheck.h"
+
+#define AGG_CHUNK 64     // vector entries per pool task
+#define AGG_MAX_ROUNDS 24
+#define AGG_MAX_M (1u << 26)
+#define AGG_MAX_PUB (1u << 16)
+
+// --- Fiat–Shamir transcript ---
+
+static void tr_u32(sha256_t *s, uint32_t v)
+{
+    unsigned char b[4] = {(unsigned char)(v >> 24), (unsigned char)(v >> 16),
+                          (unsigned char)(v >> 8), (unsigned char)v};
+    sha256_update(s, b, 4);
+}
+
+static void tr_elem(sha256_t *s, element_t e)
+{
+    int len = element_length_in_bytes(e);
+    unsigned char *buf = malloc(len);
+    element_to_bytes(buf, e);
+    tr_u32(s, (uint32_t)len);
+    sha256_update(s, buf, len);
+    free(buf);
+}
+
+// next challenge in Zr; its digest is absorbed so challenges chain
+static void tr_challenge(sha256_t *s, element_t out)
+{
+    sha256_t t = *s;
+    unsigned char h[32];
+    sha256_final(&t, h);
+    element_from_hash(out, h, 32);
+    sha256_update(s, h, 32);
+}
+
+// everything the first challenge r depends on: sizes, both SRSs, the shared
+// verifying tail, the statements and the commitments
+static void tr_head(sha256_t *s, agg_t *a, ptau_t *srs[2], pairing_t pairing)
+{
+    sha256_init(s);
+    sha256_update(s, AGG_MAGIC, 4);
+    tr_u32(s, AGG_VERSION);
+    tr_u32(s, (uint32_t)a->n_proofs);
+    tr_u32(s, (uint32_t)a->rounds);
+    element_t g1, g2;
+    element_init_G1(g1, pairing);
+    element_init_G2(g2, pairing);
+    for (int k = 0; k < 2; k++)
+        for (int i = 0; i < 2; i++)
+        {
+            ptau_get_g1(g1, srs[k], i);
+            ptau_get_g2(g2, srs[k], i);
+            tr_elem(s, g1);
+            tr_elem(s, g2);
+        }
+    element_clear(g1);
+    element_clear(g2);
+    tr_u32(s, (uint32_t)a->m);
+    tr_elem(s, a->g2);
+    for (int i = 0; i <= a->m; i++)
+        tr_elem(s, a->g2_tau[i]);
+    tr_u32(s, (uint32_t)a->l);
+    for (int j = 0; j < a->l; j++)
+        tr_elem(s, a->ic[j]);
+    for (int i = 0; i < a->n_proofs * a->l; i++)
+        tr_elem(s, a->x[i]);
+    for (int k = 0; k < 2; k++)
+    {
+        tr_elem(s, a->TAB[k]);
+        tr_elem(s, a->TC[k]);
+        tr_elem(s, a->TH[k]);
+    }
+}
+
+#define ROUND_GT 14
+#define ROUND_G1 4
+
+static void round_elems(agg_round_t *rd, element_ptr gt[ROUND_GT], element_ptr g1[ROUND_G1])
+{
+    element_ptr t[ROUND_GT] = {rd->zl,     rd->zr,     rd->abl[0], rd->abr[0], rd->abl[1],
+                               rd->abr[1], rd->cl[0],  rd->cr[0],  rd->cl[1],  rd->cr[1],
+                               rd->hl[0],  rd->hr[0],  rd->hl[1],  rd->hr[1]};
+    element_ptr u[ROUND_G1] = {rd->zcl, rd->zcr, rd->zhl, rd->zhr};
+    memcpy(gt, t, sizeof t);
+    memcpy(g1, u, sizeof u);
+}
+
+static void tr_round(sha256_t *s, agg_round_t *rd)
+{
+    element_ptr gt[ROUND_GT], g1[ROUND_G1];
+    round_elems(rd, gt, g1);
+    for (int k = 0; k < ROUND_GT; k++)
+        tr_elem(s, gt[k]);
+    for (int k = 0; k < ROUND_G1; k++)
+        tr_elem(s, g1[k]);
+}
+
+static void tr_final(sha256_t *s, agg_t *a)
+{
+    tr_elem(s, a->A);
+    tr_elem(s, a->B);
+    tr_elem(s, a->C);
+    tr_elem(s, a->H);
+    for (int k = 0; k < 2; k++)
+    {
+        tr_elem(s, a->v[k]);
+        tr_elem(s, a->w[k]);
+    }
+}
+
+// --- folded commitment keys ---
+
+// Round j halves the vectors at index weight 2^{rounds-1-j}, so the folded
+// keys are v* = h^{f_v(a)}, w* = g^{a^n·f_w(a)} with
+//   f_v(X) = ∏_p (1 + sv_p·X^{2^p}),  sv_p = x_j^{-1}·r^{-2^p}
+//   f_w(X) = ∏_p (1 + sw_p·X^{2^p}),  sw_p = x_j          (j = rounds−1−p)
+// (v was rescaled by r^{-i} before folding). Initializes sv, sw.
+static void key_scalars(element_t *sv, element_t *sw, element_t *x, element_t *xi,
+                        element_t r, int rounds, pairing_t pairing)
+{
+    element_t rp;
+    element_init_Zr(rp, pairing);
+    element_invert(rp, r);
+    for (int p = 0; p < rounds; p++)
+    {
+        element_init_Zr(sv[p], pairing);
+        element_init_Zr(sw[p], pairing);
+        element_mul(sv[p], xi[rounds - 1 - p], rp);
+        element_set(sw[p], x[rounds - 1 - p]);
+        element_square(rp, rp);
+    }
+    element_clear(rp);
+}
+
+
+// f(z) for f(X) = ∏_p (1 + s_p·X^{2^p})
+static void key_eval(element_t out, element_t *s, int rounds, element_t z)
+{
+    element_t zp, t, one;
+    element_init_same_as(zp, z);
+    element_init_same_as(t, z);
+    element_init_same_as(one, z);
+    element_set(zp, z);
+    element_set1(one);
+    element_set1(out);
+    for (int p = 0; p < rounds; p++)
+    {
+        element_mul(t, s[p], zp);
+        element_add(t, t, one);
+        element_mul(out, out, t);
+        element_square(zp, zp);
+    }
+    element_clear(zp);
+    element_clear(t);
+    element_clear(one);
+}
+
+// the n = 2^rounds coefficients of f (initialized here)
+static void key_coeffs(element_t *c, element_t *s, int rounds, pairing_t pairing)
+{
+    element_init_Zr(c[0], pairing);
+    element_set1(c[0]);
+    for (int p = 0; p < rounds; p++)
+        for (int i = 0; i < (1 << p); i++)
+        {
+            element_init_Zr(c[i + (1 << p)], pairing);
+            element_mul(c[i + (1 << p)], c[i], s[p]);
+        }
+}
+
+// KZG opening π = Σ q_i·powers[i] of q = (f − f(z)) / (X − z), f given by
+// its n coefficients (synthetic division from the top)
+static void kzg_open(element_t pi, element_t *c, int n, element_t z, element_t *powers,
+                     pairing_t pairing)
+{
+    element_t *q = malloc(sizeof(element_t) * (n > 1 ? n - 1 : 1));
+    for (int i = 0; i < n - 1; i++)
+        element_init_Zr(q[i], pairing);
+    if (n > 1)
+        element_set(q[n - 2], c[n - 1]);
+    for (int i = n - 2; i > 0; i--)
+    {
+        element_mul(q[i - 1], q[i], z);
+        element_add(q[i - 1], q[i - 1], c[i]);
+    }
+    msm(pi, powers, q, n - 1);
+    for (int i = 0; i < n - 1; i++)
+        element_clear(q[i]);
+    free(q);
+}
+
+// --- parallel vector kernels (prover) ---
+
+#define MAX_TERMS (ROUND_GT + 4) // the e(w, B) halves of T_AB go separately
+
+typedef struct {
+    int n_terms, len;
+    element_t *p[MAX_TERMS], *q[MAX_TERMS]; // term t: ∏_{i<len} e(p[t][i], q[t][i])
+    element_t **acc;                        // [worker][term]
+    pairing_ptr pairing;
+} pprod_job_t;
+
+static void pprod_task(int c, int worker, void *ctx)
+{
+    pprod_job_t *job = (pprod_job_t *)ctx;
+    int lo = c * AGG_CHUNK, hi = (lo + AGG_CHUNK < job->len ? lo + AGG_CHUNK : job->len);
+    element_t e;
+    element_init_GT(e, job->pairing);
+    for (int t = 0; t < job->n_terms; t++)
+        for (int i = lo; i < hi; i++)
+        {
+            pairing_apply(e, job->p[t][i], job->q[t][i], job->pairing);
+            element_mul(job->acc[worker][t], job->acc[worker][t], e);
+        }
+    element_clear(e);
+}
+
+// out[t] (initialized, GT) = ∏_{i<len} e(p[t][i], q[t][i])
+static void pair_products(pool_t *pool, element_ptr *out, element_t **p, element_t **q,
+                          int n_terms, int len, pairing_t pairing)
+{
+    int nw = pool_size(pool);
+    pprod_job_t job = {.n_terms = n_terms, .len = len, .pairing = pairing};
+    memcpy(job.p, p, sizeof(element_t *) * n_terms);
+    memcpy(job.q, q, sizeof(element_t *) * n_terms);
+    job.acc = malloc(sizeof(element_t *) * nw);
+    for (int w = 0; w < nw; w++)
+    {
+        job.acc[w] = malloc(sizeof(element_t) * n_terms);
+        for (int t = 0; t < n_terms; t++)
+        {
+            element_init_GT(job.acc[w][t], pairing);
+            element_set1(job.acc[w][t]);
+        }
+    }
+    pool_for(pool, (len + AGG_CHUNK - 1) / AGG_CHUNK, pprod_task, &job);
+    for (int t = 0; t < n_terms; t++)
+    {
+        element_set1(out[t]);
+        for (int w = 0; w < nw; w++)
+            element_mul(out[t], out[t], job.acc[w][t]);
+    }
+    for (int w = 0; w < nw; w++)
+    {
+        for (int t = 0; t < n_terms; t++)
+            element_clear(job.acc[w][t]);
+        free(job.acc[w]);
+    }
+    free(job.acc);
+}
+
+// g[k][i] ← g[k][i]^{r^i} for the proof vectors, v[k][i] ← v[k][i]^{r^{-i}}
+typedef struct {
+    int n;
+    element_t *g[3], *v[2];
+    element_ptr r, rinv;
+} scale_job_t;
+
+static void scale_task(int c, int worker, void *ctx)
+{
+    (void)worker;
+    scale_job_t *job = (scale_job_t *)ctx;
+    int lo = c * AGG_CHUNK, hi = (lo + AGG_CHUNK < job->n ? lo + AGG_CHUNK : job->n);
+    element_t e, rp, rq;
+    element_init_same_as(e, job->r);
+    element_init_same_as(rp, job->r);
+    element_init_same_as(rq, job->r);
+    element_set_si(e, lo);
+    element_pow_zn(rp, job->r, e);
+    element_pow_zn(rq, job->rinv, e);
+    for (int i = lo; i < hi; i++)
+    {
+        for (int k = 0; k < 3; k++)
+            element_pow_zn(job->g[k][i], job->g[k][i], rp);
+        for (int k = 0; k < 2; k++)
+            element_pow_zn(job->v[k][i], job->v[k][i], rq);
+        element_mul(rp, rp, job->r);
+        element_mul(rq, rq, job->rinv);
+    }
+    element_clear(e);
+    element_clear(rp);
+    element_clear(rq);
+}
+
+// one halving: left[i] ← left[i]·right[i]^x (A, C, H, w) or ^{x^{-1}} (B, v)
+typedef struct {
+    int half;
+    element_t *gx[5], *gxi[3];
+    element_ptr x, xi;
+} fold_job_t;
+
+static void fold_vec(element_t *g, int lo, int hi, int half, element_t s)
+{
+    element_t t;
+    element_init_same_as(t, g[0]);
+    for (int i = lo; i < hi; i++)
+    {
+        element_pow_zn(t, g[i + half], s);
+        element_mul(g[i], g[i], t);
+    }
+    element_clear(t);
+}
+
+static void fold_task(int c, int worker, void *ctx)
+{
+    (void)worker;
+    fold_job_t *job = (fold_job_t *)ctx;
+    int lo = c * AGG_CHUNK, hi = (lo + AGG_CHUNK < job->half ? lo + AGG_CHUNK : job->half);
+    for (int k = 0; k < 5; k++)
+        fold_vec(job->gx[k], lo, hi, job->half, job->x);
+    for (int k = 0; k < 3; k++)
+        fold_vec(job->gxi[k], lo, hi, job->half, job->xi);
+}
+
+// --- file I/O ---
+
+// initialize every element of a (n_proofs, rounds, m, l already set)
+static void agg_init(agg_t *a, pairing_t pairing)
+{
+    element_init_G2(a->g2, pairing);
+    a->g2_tau = malloc(sizeof(element_t) * (a->m + 1));
+    for (int i = 0; i <= a->m; i++)
+        element_init_G2(a->g2_tau[i], pairing);
+    a->ic = malloc(sizeof(element_t) * (a->l > 0 ? a->l : 1));
+    for (int j = 0; j < a->l; j++)
+        element_init_G1(a->ic[j], pairing);
+    a->x = malloc(sizeof(element_t) * (a->n_proofs * a->l > 0 ? a->n_proofs * a->l : 1));
+    for (int i = 0; i < a->n_proofs * a->l; i++)
+        element_init_Zr(a->x[i], pairing);
+    for (int k = 0; k < 2; k++)
+    {
+        element_init_GT(a->TAB[k], pairing);
+        element_init_GT(a->TC[k], pairing);
+        element_init_GT(a->TH[k], pairing);
+    }
+    element_init_G1(a->ZC, pairing);
+    element_init_G1(a->ZH, pairing);
+    a->round = malloc(sizeof(agg_round_t) * (a->rounds > 0 ? a->rounds : 1));
+    for (int j = 0; j < a->rounds; j++)
+    {
+        element_ptr gt[ROUND_GT], g1[ROUND_G1];
+        round_elems(&a->round[j], gt, g1);
+        for (int k = 0; k < ROUND_GT; k++)
+            element_init_GT(gt[k], pairing);
+        for (int k = 0; k < ROUND_G1; k++)
+            element_init_G1(g1[k], pairing);
+    }
+    element_init_G1(a->A, pairing);
+    element_init_G2(a->B, pairing);
+    element_init_G1(a->C, pairing);
+    element_init_G1(a->H, pairing);
+    for (int k = 0; k < 2; k++)
+    {
+        element_init_G2(a->v[k], pairing);
+        element_init_G1(a->w[k], pairing);
+        element_init_G2(a->pv[k], pairing);
+        element_init_G1(a->pw[k], pairing);
+    }
+}
+
+void agg_clear(agg_t *a)
+{
+    element_clear(a->g2);
+    for (int i = 0; i <= a->m; i++)
+        element_clear(a->g2_tau[i]);
+    free(a->g2_tau);
+    for (int j = 0; j < a->l; j++)
+        element_clear(a->ic[j]);
+    free(a->ic);
+    for (int i = 0; i < a->n_proofs * a->l; i++)
+        element_clear(a->x[i]);
+    free(a->x);
+    for (int k = 0; k < 2; k++)
+    {
+        element_clear(a->TAB[k]);
+        element_clear(a->TC[k]);
+        element_clear(a->TH[k]);
+    }
+    element_clear(a->ZC);
+    element_clear(a->ZH);
+    for (int j = 0; j < a->rounds; j++)
+    {
+        element_ptr gt[ROUND_GT], g1[ROUND_G1];
+        round_elems(&a->round[j], gt, g1);
+        for (int k = 0; k < ROUND_GT; k++)
+            element_clear(gt[k]);
+        for (int k = 0; k < ROUND_G1; k++)
+            element_clear(g1[k]);
+    }
+    free(a->round);
+    element_clear(a->A);
+    element_clear(a->B);
+    element_clear(a->C);
+    element_clear(a->H);
+    for (int k = 0; k < 2; k++)
+    {
+        element_clear(a->v[k]);
+        element_clear(a->w[k]);
+        element_clear(a->pv[k]);
+        element_clear(a->pw[k]);
+    }
+}
+
+// every element of a in file order, for reading and writing alike
+static int agg_elems(agg_t *a, element_ptr **out)
+{
+    int nx = a->n_proofs * a->l;
+    int n = 1 + (a->m + 1) + a->l + nx + 8 + a->rounds * (ROUND_GT + ROUND_G1) + 12, k = 0;
+    element_ptr *e = malloc(sizeof(element_ptr) * n);
+    e[k++] = a->g2;
+    for (int i = 0; i <= a->m; i++)
+        e[k++] = a->g2_tau[i];
+    for (int j = 0; j < a->l; j++)
+        e[k++] = a->ic[j];
+    for (int i = 0; i < nx; i++)
+        e[k++] = a->x[i];
+    element_ptr head[8] = {a->TAB[0], a->TAB[1], a->TC[0], a->TC[1],
+                           a->TH[0],  a->TH[1],  a->ZC,    a->ZH};
+    for (int i = 0; i < 8; i++)
+        e[k++] = head[i];
+    for (int j = 0; j < a->rounds; j++)
+    {
+        round_elems(&a->round[j], e + k, e + k + ROUND_GT);
+        k += ROUND_GT + ROUND_G1;
+    }
+    element_ptr tail[12] = {a->A,    a->B,    a->C,     a->H,     a->v[0],  a->v[1],
+                            a->w[0], a->w[1], a->pv[0], a->pv[1], a->pw[0], a->pw[1]};
+    for (int i = 0; i < 12; i++)
+        e[k++] = tail[i];
+    *out = e;
+    return n;
+}
+
+static int agg_write(const char *path, agg_t *a)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f)
+    {
+        fprintf(stderr, "Error opening '%s' for write: %s\n", path, strerror(errno));
+        return -1;
+    }
+    int err = write_exact(f, AGG_MAGIC, 4) || write_u32(f, AGG_VERSION) ||
+              write_u32(f, (uint32_t)a->n_proofs) || write_u32(f, (uint32_t)a->rounds) ||
+              write_u32(f, (uint32_t)a->m) || write_u32(f, (uint32_t)a->l);
+    element_ptr *e;
+    int n = agg_elems(a, &e);
+    for (int k = 0; k < n && !err; k++)
+        err = write_elem(f, e[k]);
+    free(e);
+    if (fclose(f) != 0)
+        err = 1;
+    if (err)
+        fprintf(stderr, "Error writing '%s'\n", path);
+    return err ? -1 : 0;
+}
+
+int agg_read(const char *path, agg_t *a, pairing_t pairing)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "Error opening '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    char magic[4];
+    uint32_t ver, np, rounds, m, l;
+    if (read_exact(f, magic, 4) || memcmp(magic, AGG_MAGIC, 4) != 0 || read_u32(f, &ver) ||
+        ver != AGG_VERSION || read_u32(f, &np) || read_u32(f, &rounds) || read_u32(f, &m) ||
+        read_u32(f, &l) || rounds > AGG_MAX_ROUNDS || np > (1u << rounds) ||
+        np <= (1u << rounds) / 2 || m > AGG_MAX_M || l > AGG_MAX_PUB ||
+        (uint64_t)np * l > AGG_MAX_M)
+    {
+        fprintf(stderr, "Error: '%s' is not an aggregate proof\n", path);
+        fclose(f);
+        return -1;
+    }
+    a->n_proofs = (int)np;
+    a->rounds = (int)rounds;
+    a->m = (int)m;
+    a->l = (int)l;
+    agg_init(a, pairing);
+
+    element_ptr *e;
+    int n = agg_elems(a, &e), err = 0, bad = 0;
+    unsigned char *buf = NULL;
+    ptcheck_t chk;
+    ptcheck_init(&chk, pairing);
+    for (int k = 0; k < n && !err; k++)
+    {
+        uint32_t len;
+        err = read_u32(f, &len) || len != (uint32_t)element_length_in_bytes(e[k]);
+        if (!err)
+        {
+            buf = realloc(buf, 2 * (size_t)len);
+            err = read_exact(f, buf, len) != 0;
+        }
+        if (!err)
+        {
+            // non-canonical encodings decode modulo q; points go to the batch
+            element_from_bytes(e[k], buf);
+            element_to_bytes(buf + len, e[k]);
+            bad = bad || memcmp(buf, buf + len, len) != 0;
+            if (e[k]->field == pairing->G1 || e[k]->field == pairing->G2)
+                ptcheck_add(&chk, e[k]);
+        }
+    }
+    free(buf);
+    free(e);
+    if (!err && fgetc(f) != EOF)
+        err = 1;
+    fclose(f);
+    if (!err && !bad)
+        bad = rng_install() != 0 || !ptcheck_run(&chk, rng_process());
+    ptcheck_clear(&chk);
+    if (err || bad)
+    {
+        if (err)
+            fprintf(stderr, "Error: '%s' is truncated or was made with other pairing params\n", path);
+        else
+            fprintf(stderr, "Error: '%s' holds invalid or non-canonical group elements\n", path);
+        agg_clear(a);
+        return -1;
+    }
+    return 0;
+}
+
+// --- prover ---
+
+// piA, piB, piC, piH, the public inputs x and the verifying tail (g2,
+// g2^{τ^i}, IC) of a proof file (all initialized here; nothing is left
+// initialized on failure)
+static int read_proof(const char *path, element_t A, element_t B, element_t C, element_t H,
+                      element_t g2, int *m, element_t **g2_tau, int *l, element_t **x,
+                      element_t **ic, pairing_t pairing)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "Error opening '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    element_ptr g[5] = {A, B, C, H, g2};
+    int k = 0, err = 0;
+    for (; k < 4 && !err; k++)
+        err = (k == 1) ? read_elem_G2(f, pairing, g[k]) : read_elem_G1(f, pairing, g[k]);
+    if (err)
+        k--; // g[k - 1] failed and is not initialized
+    uint32_t nl = 0, nl2 = 0, mm = 0;
+    element_t *xs = NULL, *tau = NULL, *ics = NULL;
+    int nx = 0, i = 0, nic = 0;
+    if (!err)
+        err = read_u32(f, &nl) != 0 || nl > AGG_MAX_PUB;
+    if (!err)
+    {
+        xs = malloc(sizeof(element_t) * (nl > 0 ? nl : 1));
+        for (; nx < (int)nl && !err; nx++)
+            err = read_elem_Zr(f, pairing, xs[nx]);
+        if (err)
+            nx--;
+    }
+    if (!err)
+    {
+        err = read_elem_G2(f, pairing, g2);
+        k += !err;
+    }
+    if (!err)
+        err = read_u32(f, &mm) != 0 || mm > AGG_MAX_M;
+    if (!err)
+    {
+        tau = malloc(sizeof(element_t) * (mm + 1));
+        for (; i <= (int)mm && !err; i++)
+            err = read_elem_G2(f, pairing, tau[i]);
+        if (err)
+            i--;
+    }
+    if (!err)
+        err = read_u32(f, &nl2) != 0 || nl2 != nl;
+    if (!err)
+    {
+        ics = malloc(sizeof(element_t) * (nl > 0 ? nl : 1));
+        for (; nic < (int)nl && !err; nic++)
+            err = read_elem_G1(f, pairing, ics[nic]);
+        if (err)
+            nic--;
+    }
+    fclose(f);
+    if (err)
+    {
+        fprintf(stderr, "Error: '%s' is not a proof file for these params\n", path);
+        while (k > 0)
+            element_clear(g[--k]);
+        while (nx > 0)
+            element_clear(xs[--nx]);
+        while (i > 0)
+            element_clear(tau[--i]);
+        while (nic > 0)
+            element_clear(ics[--nic]);
+        free(xs);
+        free(tau);
+        free(ics);
+        return -1;
+    }
+    *m = (int)mm;
+    *g2_tau = tau;
+    *l = (int)nl;
+    *x = xs;
+    *ic = ics;
+    return 0;
+}
+
+static void vec_clear(element_t *v, int n)
+{
+    for (int i = 0; i < n; i++)
+        element_clear(v[i]);
+    free(v);
+}
+
+// The two SRSs reach degree 2n − 1 (w_i = g^{a^{n+i}}) and do not share a
+// secret: equal τ, or a common first contribution (one file was derived
+// from the other with `pot --contribute`), would make one key of the other.
+static int srs_check(ptau_t *srs[2], int n_proofs, int n)
+{
+    for (int k = 0; k < 2; k++)
+        if (srs[k]->deg < 2 * n - 1)
+        {
+            fprintf(stderr, "Error: %d proofs need powers files of degree >= %d (have %d)\n",
+                    n_proofs, 2 * n - 1, srs[k]->deg);
+            return -1;
+        }
+    size_t len = srs[0]->g1_stride;
+    int same = memcmp(srs[0]->g1 + len, srs[1]->g1 + len, len) == 0;
+    if (srs[0]->n_contrib > 0 && srs[1]->n_contrib > 0)
+        same = same || memcmp(srs[0]->contrib, srs[1]->contrib, len) == 0;
+    if (same)
+    {
+        fprintf(stderr, "Error: the two powers files share a secret; aggregation needs two "
+                        "independent ceremonies\n");
+        return -1;
+    }
+    return 0;
+}
+
+int agg_create(const char *out_path, char **proof_paths, int n_proofs, ptau_t *srs[2],
+               pool_t *pool, pairing_t pairing)
+{
+    agg_t a = {.n_proofs = n_proofs};
+    while ((1 << a.rounds) < n_proofs)
+        a.rounds++;
+    int n = 1 << a.rounds;
+    if (n_proofs < 1 || a.rounds > AGG_MAX_ROUNDS)
+    {
+        fprintf(stderr, "Error: cannot aggregate %d proofs\n", n_proofs);
+        return -1;
+    }
+    if (srs_check(srs, n_proofs, n) != 0)
+        return -1;
+
+    // 1) proof vectors, padded to n with identities; all proofs must share
+    //    the verifying tail the aggregate records once, statements go along
+    element_t *A = malloc(sizeof(element_t) * n), *B = malloc(sizeof(element_t) * n);
+    element_t *C = malloc(sizeof(element_t) * n), *H = malloc(sizeof(element_t) * n);
+    int got = 0, err = 0;
+    while (got < n_proofs && !err)
+    {
+        element_t g2, *tau, *xs, *ic;
+        int m, l;
+        if (read_proof(proof_paths[got], A[got], B[got], C[got], H[got], g2, &m, &tau,
+                       &l, &xs, &ic, pairing) != 0)
+        {
+            err = 1;
+            break;
+        }
+        if (got++ == 0)
+        {
+            a.m = m;
+            a.l = l;
+            agg_init(&a, pairing);
+            element_set(a.g2, g2);
+            for (int i = 0; i <= m; i++)
+                element_set(a.g2_tau[i], tau[i]);
+            for (int j = 0; j < l; j++)
+                element_set(a.ic[j], ic[j]);
+        }
+        else
+        {
+            int same = (m == a.m && l == a.l && element_cmp(g2, a.g2) == 0);
+            for (int i = 0; i <= m && same; i++)
+                same = (element_cmp(tau[i], a.g2_tau[i]) == 0);
+            for (int j = 0; j < l && same; j++)
+                same = (element_cmp(ic[j], a.ic[j]) == 0);
+            if (!same)
+            {
+                fprintf(stderr, "Error: '%s' was proved under another key than '%s'\n",
+                        proof_paths[got - 1], proof_paths[0]);
+                err = 1;
+            }
+        }
+        for (int j = 0; j < l && !err; j++)
+            element_set(a.x[(got - 1) * a.l + j], xs[j]);
+        element_clear(g2);
+        vec_clear(tau, m + 1);
+        vec_clear(xs, l);
+        vec_clear(ic, l);
+    }
+    if (err)
+    {
+        vec_clear(A, got);
+        vec_clear(B, got);
+        vec_clear(C, got);
+        vec_clear(H, got);
+        if (got > 0)
+            agg_clear(&a);
+        return -1;
+    }
+    element_t *v[2], *w[2];
+    for (int k = 0; k < 2; k++)
+    {
+        v[k] = malloc(sizeof(element_t) * n);
+        w[k] = malloc(sizeof(element_t) * (2 * n - 1)); // room for the KZG powers
+    }
+    for (int i = 0; i < n; i++)
+    {
+        if (i >= n_proofs)
+        {
+            element_init_G1(A[i], pairing);
+            element_init_G2(B[i], pairing);
+            element_init_G1(C[i], pairing);
+            element_init_G1(H[i], pairing);
+            element_set0(A[i]);
+            element_set0(B[i]);
+            element_set0(C[i]);
+            element_set0(H[i]);
+        }
+        for (int k = 0; k < 2; k++)
+        {
+            element_init_G2(v[k][i], pairing);
+            element_init_G1(w[k][i], pairing);
+            ptau_get_g2(v[k][i], srs[k], i);
+            ptau_get_g1(w[k][i], srs[k], n + i);
+        }
+    }
+
+    // 2) commitments T_AB, T_C, T_H under both keys and the challenge r
+    element_t eb[2];
+    element_init_GT(eb[0], pairing);
+    element_init_GT(eb[1], pairing);
+    element_ptr com[8] = {a.TAB[0], a.TAB[1], a.TC[0], a.TC[1], a.TH[0], a.TH[1], eb[0], eb[1]};
+    element_t *cp[8] = {A, A, C, C, H, H, w[0], w[1]};
+    element_t *cq[8] = {v[0], v[1], v[0], v[1], v[0], v[1], B, B};
+    pair_products(pool, com, cp, cq, 8, n, pairing);
+    for (int k = 0; k < 2; k++)
+        element_mul(a.TAB[k], a.TAB[k], eb[k]);
+    sha256_t tr;
+    tr_head(&tr, &a, srs, pairing);
+    element_t r, rinv, t;
+    element_init_Zr(r, pairing);
+    element_init_Zr(rinv, pairing);
+    element_init_Zr(t, pairing);
+    tr_challenge(&tr, r);
+    element_invert(rinv, r);
+
+    // 3) A_i, C_i, H_i ← ·r^i and v_i ← ·r^{-i}: the commitments are unchanged
+    //    and Z = ∏ e(A_i, B_i) is the r-weighted product to prove
+    scale_job_t sj = {.n = n, .g = {A, C, H}, .v = {v[0], v[1]}, .r = r, .rinv = rinv};
+    pool_for(pool, (n + AGG_CHUNK - 1) / AGG_CHUNK, scale_task, &sj);
+    element_set0(a.ZC);
+    element_set0(a.ZH);
+    for (int i = 0; i < n_proofs; i++)
+    {
+        element_mul(a.ZC, a.ZC, C[i]);
+        element_mul(a.ZH, a.ZH, H[i]);
+    }
+    tr_elem(&tr, a.ZC);
+    tr_elem(&tr, a.ZH);
+
+    // 4) GIPA: halve every vector per round; b carries the scalar side of
+    //    the Σ C_i, Σ H_i arguments (all ones to start)
+    element_t *b = malloc(sizeof(element_t) * n);
+    for (int i = 0; i < n; i++)
+    {
+        element_init_Zr(b[i], pairing);
+        element_set1(b[i]);
+    }
+    int nr = a.rounds > 0 ? a.rounds : 1;
+    element_t *x = malloc(sizeof(element_t) * nr), *xi = malloc(sizeof(element_t) * nr);
+    for (int j = 0; j < a.rounds; j++)
+    {
+        int half = n >> (j + 1);
+        agg_round_t *rd = &a.round[j];
+        element_ptr gt[MAX_TERMS], g1[ROUND_G1];
+        element_t ebl[2], ebr[2];
+        round_elems(rd, gt, g1);
+        for (int k = 0; k < 2; k++)
+        {
+            element_init_GT(ebl[k], pairing);
+            element_init_GT(ebr[k], pairing);
+            gt[ROUND_GT + 2 * k] = ebl[k];
+            gt[ROUND_GT + 2 * k + 1] = ebr[k];
+        }
+        element_t *v0 = v[0], *v1 = v[1], *w0 = w[0], *w1 = w[1];
+        element_t *p[MAX_TERMS] = {A + half, A, A + half, A, A + half, A,
+                                   C + half, C, C + half, C, H + half, H,
+                                   H + half, H, w0 + half, w0, w1 + half, w1};
+        element_t *q[MAX_TERMS] = {B,  B + half,  v0, v0 + half, v1, v1 + half,
+                                   v0, v0 + half, v1, v1 + half, v0, v0 + half,
+                                   v1, v1 + half, B,  B + half,  B,  B + half};
+        pair_products(pool, gt, p, q, MAX_TERMS, half, pairing);
+        for (int k = 0; k < 2; k++)
+        {
+            element_mul(rd->abl[k], rd->abl[k], ebl[k]);
+            element_mul(rd->abr[k], rd->abr[k], ebr[k]);
+            element_clear(ebl[k]);
+            element_clear(ebr[k]);
+        }
+        msm(rd->zcl, C + half, b, half);
+        msm(rd->zcr, C, b + half, half);
+        msm(rd->zhl, H + half, b, half);
+        msm(rd->zhr, H, b + half, half);
+        tr_round(&tr, rd);
+
+        element_init_Zr(x[j], pairing);
+        element_init_Zr(xi[j], pairing);
+        tr_challenge(&tr, x[j]);
+        element_invert(xi[j], x[j]);
+        fold_job_t fj = {.half = half, .gx = {A, C, H, w[0], w[1]}, .gxi = {B, v[0], v[1]},
+                         .x = x[j], .xi = xi[j]};
+        pool_for(pool, (half + AGG_CHUNK - 1) / AGG_CHUNK, fold_task, &fj);
+        for (int i = 0; i < half; i++)
+        {
+            element_mul(t, xi[j], b[i + half]);
+            element_add(b[i], b[i], t);
+        }
+    }
+    element_set(a.A, A[0]);
+    element_set(a.B, B[0]);
+    element_set(a.C, C[0]);
+    element_set(a.H, H[0]);
+    for (int k = 0; k < 2; k++)
+    {
+        element_set(a.v[k], v[k][0]);
+        element_set(a.w[k], w[k][0]);
+    }
+
+    // 5) KZG openings of the folded keys at z: f_v on powers 0..n−2 of G2,
+    //    X^n·f_w on powers 0..2n−2 of G1 (w is reloaded at double length)
+    element_t z;
+    element_init_Zr(z, pairing);
+    tr_final(&tr, &a);
+    tr_challenge(&tr, z);
+    element_t *sv = malloc(sizeof(element_t) * nr), *sw = malloc(sizeof(element_t) * nr);
+    element_t *cv = malloc(sizeof(element_t) * n), *cw = malloc(sizeof(element_t) * 2 * n);
+    key_scalars(sv, sw, x, xi, r, a.rounds, pairing);
+    key_coeffs(cv, sv, a.rounds, pairing);
+    key_coeffs(cw + n, sw, a.rounds, pairing);
+    for (int i = 0; i < n; i++)
+    {
+        element_init_Zr(cw[i], pairing);
+        element_set0(cw[i]);
+    }
+    for (int k = 0; k < 2; k++)
+    {
+        for (int i = 0; i < 2 * n - 1; i++)
+        {
+            if (i >= n)
+                element_init_G1(w[k][i], pairing);
+            ptau_get_g1(w[k][i], srs[k], i);
+        }
+        for (int i = 0; i < n - 1; i++)
+            ptau_get_g2(v[k][i], srs[k], i);
+        kzg_open(a.pv[k], cv, n, z, v[k], pairing);
+        kzg_open(a.pw[k], cw, 2 * n, z, w[k], pairing);
+    }
+
+    int rc = agg_write(out_path, &a);
+
+    vec_clear(cv, n);
+    vec_clear(cw, 2 * n);
+    vec_clear(sv, a.rounds);
+    vec_clear(sw, a.rounds);
+    vec_clear(x, a.rounds);
+    vec_clear(xi, a.rounds);
+    vec_clear(b, n);
+    vec_clear(A, n);
+    vec_clear(B, n);
+    vec_clear(C, n);
+    vec_clear(H, n);
+    for (int k = 0; k < 2; k++)
+    {
+        vec_clear(v[k], n);
+        vec_clear(w[k], 2 * n - 1);
+    }
+    element_clear(eb[0]);
+    element_clear(eb[1]);
+    element_clear(r);
+    element_clear(rinv);
+    element_clear(t);
+    element_clear(z);
+    agg_clear(&a);
+    return rc;
+}
+
+// --- verifier ---
+
+// acc ← acc·l^x·r^{x^{-1}}
+static void fold_acc(element_t acc, element_t l, element_t r, element_t x, element_t xi)
+{
+    element_t t;
+    element_init_same_as(t, acc);
+    element_pow_zn(t, l, x);
+    element_mul(acc, acc, t);
+    element_pow_zn(t, r, xi);
+    element_mul(acc, acc, t);
+    element_clear(t);
+}
+
+// e(p1, q1) == e(p2, q2)
+static int pairs_equal(element_t p1, element_t q1, element_t p2, element_t q2, pairing_t pairing)
+{
+    element_t l, r;
+    element_init_GT(l, pairing);
+    element_init_GT(r, pairing);
+    pairing_apply(l, p1, q1, pairing);
+    pairing_apply(r, p2, q2, pairing);
+    int eq = (element_cmp(l, r) == 0);
+    element_clear(l);
+    element_clear(r);
+    return eq;
+}
+
+int agg_verify(agg_t *a, element_t g2Z, ptau_t *srs[2], pairing_t pairing)
+{
+    int n = 1 << a->rounds;
+    if (srs_check(srs, a->n_proofs, n) != 0)
+        return 0;
+    sha256_t tr;
+    element_t r, z;
+    element_init_Zr(r, pairing);
+    element_init_Zr(z, pairing);
+    tr_head(&tr, a, srs, pairing);
+    tr_challenge(&tr, r);
+    tr_elem(&tr, a->ZC);
+    tr_elem(&tr, a->ZH);
+
+    // public-input term Σ_j s_j·IC_j, s_j = Σ_i r^i x_ij
+    element_t *s = malloc(sizeof(element_t) * (a->l > 0 ? a->l : 1));
+    element_t ri, t, cx;
+    element_init_Zr(ri, pairing);
+    element_init_Zr(t, pairing);
+    element_init_G1(cx, pairing);
+    for (int j = 0; j < a->l; j++)
+    {
+        element_init_Zr(s[j], pairing);
+        element_set0(s[j]);
+    }
+    element_set1(ri);
+    for (int i = 0; i < a->n_proofs; i++)
+    {
+        for (int j = 0; j < a->l; j++)
+        {
+            element_mul(t, ri, a->x[i * a->l + j]);
+            element_add(s[j], s[j], t);
+        }
+        element_mul(ri, ri, r);
+    }
+    msm(cx, a->ic, s, a->l);
+    element_mul(cx, cx, a->ZC);
+    vec_clear(s, a->l);
+    element_clear(ri);
+
+    // the r-weighted product the GIPA must reach, from the claimed sums;
+    // acc holds Z, then T_AB, T_C, T_H for key 1 and key 2
+    element_t Z, acc[6], zc, zh, e, e2;
+    element_init_GT(Z, pairing);
+    element_init_GT(e, pairing);
+    element_init_GT(e2, pairing);
+    pairing_apply(Z, cx, a->g2, pairing);
+    pairing_apply(e, a->ZH, g2Z, pairing);
+    element_mul(Z, Z, e);
+    for (int k = 0; k < 2; k++)
+    {
+        element_ptr com[3] = {a->TAB[k], a->TC[k], a->TH[k]};
+        for (int c = 0; c < 3; c++)
+        {
+            element_init_GT(acc[3 * k + c], pairing);
+            element_set(acc[3 * k + c], com[c]);
+        }
+    }
+    element_init_same_as(zc, a->ZC);
+    element_init_same_as(zh, a->ZH);
+    element_set(zc, a->ZC);
+    element_set(zh, a->ZH);
+
+    int nr = a->rounds > 0 ? a->rounds : 1;
+    element_t *x = malloc(sizeof(element_t) * nr), *xi = malloc(sizeof(element_t) * nr);
+    element_t bs;
+    element_init_Zr(bs, pairing);
+    element_set1(bs);
+    for (int j = 0; j < a->rounds; j++)
+    {
+        agg_round_t *rd = &a->round[j];
+        tr_round(&tr, rd);
+        element_init_Zr(x[j], pairing);
+        element_init_Zr(xi[j], pairing);
+        tr_challenge(&tr, x[j]);
+        element_invert(xi[j], x[j]);
+        fold_acc(Z, rd->zl, rd->zr, x[j], xi[j]);
+        for (int k = 0; k < 2; k++)
+        {
+            fold_acc(acc[3 * k], rd->abl[k], rd->abr[k], x[j], xi[j]);
+            fold_acc(acc[3 * k + 1], rd->cl[k], rd->cr[k], x[j], xi[j]);
+            fold_acc(acc[3 * k + 2], rd->hl[k], rd->hr[k], x[j], xi[j]);
+        }
+        fold_acc(zc, rd->zcl, rd->zcr, x[j], xi[j]);
+        fold_acc(zh, rd->zhl, rd->zhr, x[j], xi[j]);
+        element_set1(t);
+        element_add(t, t, xi[j]);
+        element_mul(bs, bs, t); // b* = ∏ (1 + x_j^{-1})
+    }
+    tr_final(&tr, a);
+    tr_challenge(&tr, z);
+
+    // length-1 relations on the folded vectors
+    element_t g1e;
+    element_init_G1(g1e, pairing);
+    pairing_apply(e, a->A, a->B, pairing);
+    int ok = (element_cmp(e, Z) == 0);
+    for (int k = 0; k < 2; k++)
+    {
+        pairing_apply(e, a->A, a->v[k], pairing);
+        pairing_apply(e2, a->w[k], a->B, pairing);
+        element_mul(e, e, e2);
+        ok = ok && element_cmp(e, acc[3 * k]) == 0;
+        pairing_apply(e, a->C, a->v[k], pairing);
+        ok = ok && element_cmp(e, acc[3 * k + 1]) == 0;
+        pairing_apply(e, a->H, a->v[k], pairing);
+        ok = ok && element_cmp(e, acc[3 * k + 2]) == 0;
+    }
+    element_pow_zn(g1e, a->C, bs);
+    ok = ok && element_cmp(g1e, zc) == 0;
+    element_pow_zn(g1e, a->H, bs);
+    ok = ok && element_cmp(g1e, zh) == 0;
+
+    // KZG per key: e(g^{a−z}, π_v) = e(g, v*·h^{−f_v(z)}),
+    // e(π_w, h^{a−z}) = e(w*·g^{−z^n·f_w(z)}, h)
+    element_t *sv = malloc(sizeof(element_t) * nr), *sw = malloc(sizeof(element_t) * nr);
+    key_scalars(sv, sw, x, xi, r, a->rounds, pairing);
+    element_t g1, g1a, g2, g2a, g2e, fz, zn;
+    element_init_G1(g1, pairing);
+    element_init_G1(g1a, pairing);
+    element_init_G2(g2, pairing);
+    element_init_G2(g2a, pairing);
+    element_init_G2(g2e, pairing);
+    element_init_Zr(fz, pairing);
+    element_init_Zr(zn, pairing);
+    element_set_si(fz, n);
+    element_pow_zn(zn, z, fz);
+    for (int k = 0; k < 2 && ok; k++)
+    {
+        ptau_get_g1(g1, srs[k], 0);
+        ptau_get_g1(g1a, srs[k], 1);
+        ptau_get_g2(g2, srs[k], 0);
+        ptau_get_g2(g2a, srs[k], 1);
+
+        key_eval(fz, sv, a->rounds, z);
+        element_pow_zn(g1e, g1, z);
+        element_div(g1e, g1a, g1e);
+        element_pow_zn(g2e, g2, fz);
+        element_div(g2e, a->v[k], g2e);
+        ok = ok && pairs_equal(g1e, a->pv[k], g1, g2e, pairing);
+
+        key_eval(fz, sw, a->rounds, z);
+        element_mul(fz, fz, zn);
+        element_pow_zn(g2e, g2, z);
+        element_div(g2e, g2a, g2e);
+        element_pow_zn(g1e, g1, fz);
+        element_div(g1e, a->w[k], g1e);
+        ok = ok && pairs_equal(a->pw[k], g2e, g1e, g2, pairing);
+    }
+
+    vec_clear(sv, a->rounds);
+    vec_clear(sw, a->rounds);
+    vec_clear(x, a->rounds);
+    vec_clear(xi, a->rounds);
+    for (int c = 0; c < 6; c++)
+        element_clear(acc[c]);
+    element_clear(g1);
+    element_clear(g1a);
+    element_clear(g2);
+    element_clear(g2a);
+    element_clear(g2e);
+    element_clear(g1e);
+    element_clear(fz);
+    element_clear(zn);
+    element_clear(bs);
+    element_clear(t);
+    element_clear(cx);
+    element_clear(Z);
+    element_clear(zc);
+    element_clear(zh);
+    element_clear(e);
+    element_clear(e2);
+    element_clear(r);
+    element_clear(z);
+    return ok;
+}
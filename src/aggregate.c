@@ -0,0 +1,62 @@
+// src/aggregate.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <pbc/pbc.h>
+#include "../include/fmt.h"
+#include "../include/io.h"
+#include "../include/ptau.h"
+#include "../include/pool.h"
+#include "../include/agg.h"
+#include "../include/memstat.h"
+
+int main(int argc, char **argv)
+{
+    memstat_init();
+    if (argc < 6)
+    {
+        fprintf(stderr,
+                "Usage: %s pairing.params pot1.ptau pot2.ptau out.agg proof1.bin … proofN.bin\n",
+                argv[0]);
+        return 1;
+    }
+    fmt_init(1, stdout);
+    fmt_banner("Aggregate proofs");
+
+    pairing_t pairing;
+    if (load_pairing(argv[1], pairing) != 0)
+        return 1;
+    fmt_pairing(pairing);
+    // two powers files of independent ceremonies: the commitment keys
+    ptau_t pt[2], *srs[2] = {&pt[0], &pt[1]};
+    if (ptau_open(&pt[0], argv[2], pairing) != 0)
+        return 1;
+    if (ptau_open(&pt[1], argv[3], pairing) != 0)
+    {
+        ptau_close(&pt[0]);
+        return 1;
+    }
+
+    int n_proofs = argc - 5, rounds = 0;
+    while ((1 << rounds) < n_proofs)
+        rounds++;
+    fmt_kv_i("proofs", n_proofs);
+    fmt_kv_i("rounds", rounds);
+    fmt_kv_i("powers degree", pt[0].deg < pt[1].deg ? pt[0].deg : pt[1].deg);
+
+    pool_t *pool = pool_create(pool_default_threads());
+    fmt_kv_i("threads", pool_size(pool));
+    memstat_stage("aggregate");
+    int rc = agg_create(argv[4], argv + 5, n_proofs, srs, pool, pairing);
+    pool_destroy(pool);
+    ptau_close(&pt[0]);
+    ptau_close(&pt[1]);
+    if (rc != 0)
+        return 1;
+
+    struct stat st;
+    fmt_kv_s("aggregate file", argv[4]);
+    if (stat(argv[4], &st) == 0)
+        fmt_kv_i("aggregate bytes", (long long)st.st_size);
+    return 0;
+}
@@ -1,9 +1,14 @@
 // ---------------------- src/build_circuit.c ----------------------
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pbc/pbc.h>
 #include "../include/circuit.h"
+#include "../include/r1cs_opt.h"
+#include "../include/r1csfile.h"
+#include "../include/io.h"
 #include "../include/fmt.h"
+#include "../include/memstat.h"
 
 /*
 void build_r1cs(int d, element_t *coeffs, element_t x, element_t y,
@@ -78,48 +83,28 @@ void build_r1cs(int d, element_t *coeffs, element_t x, element_t y,
 
 int main(int argc, char **argv)
 {
+    memstat_init();
     if (argc < 5)
     {
         fprintf(stderr,
-                "Usage: %s a.param d x y a0 a1 … ad\n"
+                "Usage: %s a.param d x y a0 a1 … ad [-o base]\n"
                 "  a.param : PBC parameter file (any path)\n"
                 "  d              : degree of the polynomial\n"
                 "  x              : evaluation point (in Zr)\n"
                 "  y              : claimed result y = ∑ a_i·x^i\n"
-                "  a0…ad          : coefficients in Zr\n",
+                "  a0…ad          : coefficients in Zr\n"
+                "  -o base        : also write base.r1cs and base.wtns\n",
                 argv[0]);
         return 1;
     }
     fmt_init(1, stdout);
     fmt_banner("R1CS / Wire Assignment");
 
-    // 1) Load the params file into a buffer
+    // 1) Init the pairing from the params file (or a pairing snapshot)
     const char *params_path = argv[1];
-    FILE *fp = fopen(params_path, "r");
-    if (!fp)
-    {
-        perror("fopen a.param");
-        return 1;
-    }
-    fseek(fp, 0, SEEK_END);
-    long sz = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-    char *param_buf = malloc(sz + 1);
-    if (fread(param_buf, 1, sz, fp) != sz)
-    {
-        perror("fread a.param");
-        return 1;
-    }
-    param_buf[sz] = '\0';
-    fclose(fp);
-
-    // 2) Init PBC param and pairing
-    pbc_param_t params;
-    pbc_param_init_set_buf(params, param_buf, sz + 1);
-    free(param_buf);
-
     pairing_t pairing;
-    pairing_init_pbc_param(pairing, params);
+    if (load_pairing(params_path, pairing) != 0)
+        return 1;
 
     // 3) Parse degree, x, y
     int argi = 2;
@@ -142,12 +127,28 @@ int main(int argc, char **argv)
     r1cs_t r1cs;
     element_t *wires;
     build_r1cs(d, coeffs, x, y, &r1cs, &wires, pairing);
+    r1cs_maybe_optimize(&r1cs, &wires, pairing);
 
     // 6) Print all wire values
     fmt_kv_i("variables", r1cs.n_vars);
     fmt_kv_i("constraints", r1cs.n_cons);
     fmt_vec_e("wires", wires, r1cs.n_vars);
 
+    // 7) Optionally save the system and witness for the other stages
+    if (argi + 1 < argc && strcmp(argv[argi], "-o") == 0)
+    {
+        char *path = malloc(strlen(argv[argi + 1]) + 6);
+        sprintf(path, "%s.r1cs", argv[argi + 1]);
+        if (r1cs_file_write(path, &r1cs, pairing) != 0)
+            return 1;
+        fmt_kv_s("r1cs file", path);
+        sprintf(path, "%s.wtns", argv[argi + 1]);
+        if (wtns_file_write(path, wires, r1cs.n_vars, r1cs.n_pub, pairing) != 0)
+            return 1;
+        fmt_kv_s("witness file", path);
+        free(path);
+    }
+
     // Cleanup omitted for brevity
     return 0;
 }
\ No newline at end of file
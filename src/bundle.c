@@ -0,0 +1,247 @@
+// src/bundle.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "../include/sha256.h"
+#include "../include/bundle.h"
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static void put_u64(unsigned char *p, uint64_t v)
+{
+    put_u32(p, (uint32_t)(v >> 32));
+    put_u32(p + 4, (uint32_t)v);
+}
+
+static uint64_t get_u64(const unsigned char *p)
+{
+    return (uint64_t)io_get_u32(p) << 32 | io_get_u32(p + 4);
+}
+
+// write all queued parts, resuming after short writes
+static int flush(bundle_writer_t *w)
+{
+    struct iovec *v = w->iov;
+    int n = w->niov;
+    while (n > 0)
+    {
+        ssize_t k = writev(w->fd, v, n);
+        if (k < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        while (n > 0 && (size_t)k >= v->iov_len)
+        {
+            k -= (ssize_t)v->iov_len;
+            v++;
+            n--;
+        }
+        if (n > 0)
+        {
+            v->iov_base = (char *)v->iov_base + k;
+            v->iov_len -= (size_t)k;
+        }
+    }
+    w->niov = 0;
+    return 0;
+}
+
+static int queue(bundle_writer_t *w, const void *p, size_t len)
+{
+    if (w->niov == BUNDLE_IOV && flush(w) != 0)
+        return -1;
+    w->iov[w->niov].iov_base = (void *)p;
+    w->iov[w->niov++].iov_len = len;
+    w->off += len;
+    return 0;
+}
+
+int bundle_create(bundle_writer_t *w, const char *path)
+{
+    static unsigned char head[8] = {'G', '1', '6', 'B', 0, 0, 0, BUNDLE_VERSION};
+    memset(w, 0, sizeof *w);
+    w->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (w->fd < 0)
+    {
+        fprintf(stderr, "Error opening '%s' for write: %s\n", path, strerror(errno));
+        return -1;
+    }
+    return queue(w, head, sizeof head);
+}
+
+static bundle_entry_t *find(bundle_entry_t *t, int n, const unsigned char id[32])
+{
+    for (int i = 0; i < n; i++)
+        if (memcmp(t[i].id, id, 32) == 0)
+            return &t[i];
+    return NULL;
+}
+
+int bundle_add_tail(bundle_writer_t *w, const void *tail, size_t len, unsigned char id[32])
+{
+    sha256_t sh;
+    sha256_init(&sh);
+    sha256_update(&sh, tail, len);
+    sha256_final(&sh, id);
+    if (find(w->tails, w->n_tails, id))
+        return 0;
+    if (w->n_tails == w->tails_cap)
+    {
+        w->tails_cap = w->tails_cap ? 2 * w->tails_cap : 4;
+        w->tails = realloc(w->tails, sizeof(bundle_entry_t) * w->tails_cap);
+    }
+    bundle_entry_t *e = &w->tails[w->n_tails++];
+    e->offset = w->off;
+    e->length = len;
+    memcpy(e->id, id, 32);
+    return queue(w, tail, len);
+}
+
+int bundle_add(bundle_writer_t *w, const struct iovec *parts, int nparts,
+               const unsigned char id[32])
+{
+    if (!find(w->tails, w->n_tails, id))
+    {
+        fprintf(stderr, "Error: bundle record for a circuit id without a tail\n");
+        return -1;
+    }
+    if (w->n == w->cap)
+    {
+        w->cap = w->cap ? 2 * w->cap : 64;
+        w->idx = realloc(w->idx, sizeof(bundle_entry_t) * w->cap);
+    }
+    bundle_entry_t *e = &w->idx[w->n++];
+    e->offset = w->off;
+    memcpy(e->id, id, 32);
+    sha256_t sh;
+    sha256_init(&sh);
+    for (int i = 0; i < nparts; i++)
+    {
+        sha256_update(&sh, parts[i].iov_base, parts[i].iov_len);
+        if (queue(w, parts[i].iov_base, parts[i].iov_len) != 0)
+            return -1;
+    }
+    sha256_final(&sh, e->hash);
+    e->length = w->off - e->offset;
+    return 0;
+}
+
+int bundle_finish(bundle_writer_t *w)
+{
+    size_t size = (size_t)w->n_tails * BUNDLE_TAIL_ENTRY + (size_t)w->n * BUNDLE_ENTRY + BUNDLE_TRAILER;
+    unsigned char *index = malloc(size);
+    unsigned char *p = index;
+    uint64_t tat = w->off, at = tat + (uint64_t)w->n_tails * BUNDLE_TAIL_ENTRY;
+    for (int i = 0; i < w->n_tails; i++, p += BUNDLE_TAIL_ENTRY)
+    {
+        put_u64(p, w->tails[i].offset);
+        put_u64(p + 8, w->tails[i].length);
+        memcpy(p + 16, w->tails[i].id, 32);
+    }
+    for (int i = 0; i < w->n; i++, p += BUNDLE_ENTRY)
+    {
+        put_u64(p, w->idx[i].offset);
+        put_u64(p + 8, w->idx[i].length);
+        memcpy(p + 16, w->idx[i].id, 32);
+        memcpy(p + 48, w->idx[i].hash, 32);
+    }
+    put_u64(p, tat);
+    put_u32(p + 8, (uint32_t)w->n_tails);
+    put_u64(p + 12, at);
+    put_u32(p + 20, (uint32_t)w->n);
+    memcpy(p + 24, BUNDLE_END, 4);
+    int err = queue(w, index, size) != 0 || flush(w) != 0;
+    err = (close(w->fd) != 0) || err;
+    free(index);
+    free(w->idx);
+    free(w->tails);
+    w->idx = NULL;
+    w->tails = NULL;
+    return err ? -1 : 0;
+}
+
+int bundle_open(bundle_t *b, const char *path)
+{
+    if (io_map_open(&b->map, path) != 0)
+        return -1;
+    const unsigned char *base = b->map.base;
+    size_t size = b->map.size;
+    int ok = size >= 8 + BUNDLE_TRAILER && memcmp(base, BUNDLE_MAGIC, 4) == 0 &&
+             io_get_u32(base + 4) == BUNDLE_VERSION && memcmp(base + size - 4, BUNDLE_END, 4) == 0;
+    if (ok)
+    {
+        const unsigned char *tr = base + size - BUNDLE_TRAILER;
+        uint64_t tat = get_u64(tr), at = get_u64(tr + 12);
+        uint32_t t = io_get_u32(tr + 8), n = io_get_u32(tr + 20);
+        ok = tat >= 8 && tat <= at && at <= size - BUNDLE_TRAILER &&
+             (at - tat) == (uint64_t)t * BUNDLE_TAIL_ENTRY &&
+             (size - BUNDLE_TRAILER - at) == (uint64_t)n * BUNDLE_ENTRY;
+        b->n = (int)n;
+        b->n_tails = (int)t;
+        b->index = base + at;
+        b->tails = base + tat;
+        for (uint32_t i = 0; ok && i < t; i++)
+        {
+            uint64_t off = get_u64(b->tails + (size_t)i * BUNDLE_TAIL_ENTRY);
+            uint64_t len = get_u64(b->tails + (size_t)i * BUNDLE_TAIL_ENTRY + 8);
+            ok = off >= 8 && off <= tat && len <= tat - off;
+        }
+        for (uint32_t i = 0; ok && i < n; i++)
+        {
+            uint64_t off = get_u64(b->index + (size_t)i * BUNDLE_ENTRY);
+            uint64_t len = get_u64(b->index + (size_t)i * BUNDLE_ENTRY + 8);
+            ok = off >= 8 && off <= tat && len <= tat - off;
+        }
+    }
+    if (!ok)
+    {
+        fprintf(stderr, "Error: '%s' is not a proof bundle or its index is damaged\n", path);
+        io_map_close(&b->map);
+        return -1;
+    }
+    (void)madvise(b->map.base, b->map.size, MADV_SEQUENTIAL);
+    return 0;
+}
+
+void bundle_close(bundle_t *b)
+{
+    io_map_close(&b->map);
+}
+
+void bundle_get(const bundle_t *b, int i, bundle_entry_t *e, const unsigned char **rec)
+{
+    const unsigned char *p = b->index + (size_t)i * BUNDLE_ENTRY;
+    e->offset = get_u64(p);
+    e->length = get_u64(p + 8);
+    memcpy(e->id, p + 16, 32);
+    memcpy(e->hash, p + 48, 32);
+    *rec = b->map.base + e->offset;
+}
+
+int bundle_find_tail(const bundle_t *b, const unsigned char id[32],
+                     const unsigned char **tail, size_t *len)
+{
+    for (int i = 0; i < b->n_tails; i++)
+    {
+        const unsigned char *p = b->tails + (size_t)i * BUNDLE_TAIL_ENTRY;
+        if (memcmp(p + 16, id, 32) == 0)
+        {
+            *tail = b->map.base + get_u64(p);
+            *len = (size_t)get_u64(p + 8);
+            return 0;
+        }
+    }
+    return -1;
+}
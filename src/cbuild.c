@@ -0,0 +1,407 @@
+// src/cbuild.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pbc/pbc.h>
+#include "../include/cbuild.h"
+
+// sparse linear combination, sorted by wire
+typedef struct {
+    int n;
+    int *wire;
+    element_t *coef;
+} lc_t;
+
+enum { OP_INPUT, OP_MUL };
+
+typedef struct {
+    int kind;
+    int input;    // OP_INPUT: index into the inputs
+    cb_ref a, b;  // OP_MUL
+} op_t;
+
+typedef struct {
+    cb_ref a, b, c;
+} cons_t;
+
+typedef struct {
+    cb_ref a, b, w; // w = -1: empty slot
+} memo_t;
+
+struct cb_s {
+    pairing_ptr pairing;
+    lc_t *lc;
+    int n_lc, cap_lc;
+    op_t *op; // op[k] computes wire k+1
+    int n_op, cap_op;
+    cons_t *cons;
+    int n_cons, cap_cons;
+    char **input;
+    int n_inputs, cap_inputs;
+    cb_ref zero, one;
+    // products already emitted, keyed by operand pair (open addressing)
+    memo_t *memo;
+    int n_memo, cap_memo;
+};
+
+#define GROW(p, n, cap)                                  \
+    do                                                   \
+    {                                                    \
+        if ((n) == (cap))                                \
+        {                                                \
+            (cap) = (cap) ? 2 * (cap) : 16;              \
+            (p) = realloc((p), sizeof(*(p)) * (cap));    \
+        }                                                \
+    } while (0)
+
+// new empty LC with room for n terms
+static cb_ref lc_new(cb_t *cb, int n)
+{
+    GROW(cb->lc, cb->n_lc, cb->cap_lc);
+    lc_t *l = &cb->lc[cb->n_lc];
+    l->n = 0;
+    l->wire = (int *)malloc(sizeof(int) * (n > 0 ? n : 1));
+    l->coef = (element_t *)malloc(sizeof(element_t) * (n > 0 ? n : 1));
+    return cb->n_lc++;
+}
+
+static void lc_push(cb_t *cb, cb_ref r, int wire, element_t c)
+{
+    lc_t *l = &cb->lc[r];
+    if (element_is0(c))
+        return;
+    l->wire[l->n] = wire;
+    element_init_Zr(l->coef[l->n], cb->pairing);
+    element_set(l->coef[l->n], c);
+    l->n++;
+}
+
+static cb_ref lc_wire(cb_t *cb, int wire)
+{
+    element_t one;
+    element_init_Zr(one, cb->pairing);
+    element_set1(one);
+    cb_ref r = lc_new(cb, 1);
+    lc_push(cb, r, wire, one);
+    element_clear(one);
+    return r;
+}
+
+// constant part if the LC only touches wire 0, else NULL
+static element_ptr lc_const(cb_t *cb, cb_ref r)
+{
+    lc_t *l = &cb->lc[r];
+    return (l->n == 1 && l->wire[0] == 0) ? l->coef[0] : NULL;
+}
+
+static int lc_is_zero(cb_t *cb, cb_ref r) { return cb->lc[r].n == 0; }
+
+cb_t *cb_new(pairing_t pairing)
+{
+    cb_t *cb = (cb_t *)calloc(1, sizeof(cb_t));
+    cb->pairing = pairing;
+    cb->zero = lc_new(cb, 0);
+    cb->one = lc_wire(cb, 0);
+    return cb;
+}
+
+void cb_free(cb_t *cb)
+{
+    for (int i = 0; i < cb->n_lc; i++)
+    {
+        for (int t = 0; t < cb->lc[i].n; t++)
+            element_clear(cb->lc[i].coef[t]);
+        free(cb->lc[i].wire);
+        free(cb->lc[i].coef);
+    }
+    for (int i = 0; i < cb->n_inputs; i++)
+        free(cb->input[i]);
+    free(cb->lc);
+    free(cb->op);
+    free(cb->cons);
+    free(cb->input);
+    free(cb->memo);
+    free(cb);
+}
+
+cb_ref cb_zero(cb_t *cb) { return cb->zero; }
+cb_ref cb_one(cb_t *cb) { return cb->one; }
+
+cb_ref cb_const(cb_t *cb, element_t c)
+{
+    cb_ref r = lc_new(cb, 1);
+    lc_push(cb, r, 0, c);
+    return r;
+}
+
+cb_ref cb_const_si(cb_t *cb, long c)
+{
+    element_t e;
+    element_init_Zr(e, cb->pairing);
+    element_set_si(e, c);
+    cb_ref r = cb_const(cb, e);
+    element_clear(e);
+    return r;
+}
+
+static int new_wire(cb_t *cb, op_t op)
+{
+    GROW(cb->op, cb->n_op, cb->cap_op);
+    cb->op[cb->n_op] = op;
+    return ++cb->n_op;
+}
+
+cb_ref cb_input(cb_t *cb, const char *name)
+{
+    GROW(cb->input, cb->n_inputs, cb->cap_inputs);
+    cb->input[cb->n_inputs] = strdup(name);
+    op_t op = {.kind = OP_INPUT, .input = cb->n_inputs++};
+    return lc_wire(cb, new_wire(cb, op));
+}
+
+// a + k·b (k NULL means 1), merging the sorted term lists
+static cb_ref lc_axpy(cb_t *cb, cb_ref a, element_ptr k, cb_ref b)
+{
+    cb_ref r = lc_new(cb, cb->lc[a].n + cb->lc[b].n);
+    lc_t *la = &cb->lc[a], *lb = &cb->lc[b]; // after lc_new: table may move
+    element_t t;
+    element_init_Zr(t, cb->pairing);
+    int i = 0, j = 0;
+    while (i < la->n || j < lb->n)
+    {
+        int wa = i < la->n ? la->wire[i] : -1;
+        int wb = j < lb->n ? lb->wire[j] : -1;
+        if (wb < 0 || (wa >= 0 && wa < wb))
+        {
+            lc_push(cb, r, wa, la->coef[i++]);
+            continue;
+        }
+        if (k)
+            element_mul(t, lb->coef[j], k);
+        else
+            element_set(t, lb->coef[j]);
+        if (wa == wb)
+            element_add(t, t, la->coef[i++]);
+        lc_push(cb, r, wb, t);
+        j++;
+    }
+    element_clear(t);
+    return r;
+}
+
+cb_ref cb_add(cb_t *cb, cb_ref a, cb_ref b) { return lc_axpy(cb, a, NULL, b); }
+
+cb_ref cb_sub(cb_t *cb, cb_ref a, cb_ref b)
+{
+    element_t m1;
+    element_init_Zr(m1, cb->pairing);
+    element_set_si(m1, -1);
+    cb_ref r = lc_axpy(cb, a, m1, b);
+    element_clear(m1);
+    return r;
+}
+
+cb_ref cb_scale(cb_t *cb, cb_ref a, element_t k)
+{
+    return lc_axpy(cb, cb->zero, k, a);
+}
+
+static unsigned memo_hash(cb_ref a, cb_ref b, int cap)
+{
+    return ((unsigned)a * 2654435761u ^ (unsigned)b * 40503u) & (unsigned)(cap - 1);
+}
+
+// slot for (a, b): holds the product wire's ref, or -1 if not emitted yet
+static cb_ref *memo_slot(cb_t *cb, cb_ref a, cb_ref b)
+{
+    if (2 * (cb->n_memo + 1) > cb->cap_memo)
+    {
+        int old = cb->cap_memo;
+        memo_t *prev = cb->memo;
+        cb->cap_memo = old ? 2 * old : 64;
+        cb->memo = (memo_t *)malloc(sizeof(memo_t) * cb->cap_memo);
+        for (int i = 0; i < cb->cap_memo; i++)
+            cb->memo[i].w = -1;
+        for (int i = 0; i < old; i++)
+        {
+            memo_t *e = &prev[i];
+            if (e->w < 0)
+                continue;
+            unsigned h = memo_hash(e->a, e->b, cb->cap_memo);
+            while (cb->memo[h].w >= 0)
+                h = (h + 1) & (cb->cap_memo - 1);
+            cb->memo[h] = *e;
+        }
+        free(prev);
+    }
+    unsigned h = memo_hash(a, b, cb->cap_memo);
+    while (cb->memo[h].w >= 0 && (cb->memo[h].a != a || cb->memo[h].b != b))
+        h = (h + 1) & (cb->cap_memo - 1);
+    if (cb->memo[h].w < 0)
+    {
+        cb->memo[h].a = a;
+        cb->memo[h].b = b;
+        cb->n_memo++;
+    }
+    return &cb->memo[h].w;
+}
+
+cb_ref cb_mul(cb_t *cb, cb_ref a, cb_ref b)
+{
+    if (lc_is_zero(cb, a) || lc_is_zero(cb, b))
+        return cb->zero;
+    element_ptr ka = lc_const(cb, a), kb = lc_const(cb, b);
+    if (ka)
+        return cb_scale(cb, b, ka);
+    if (kb)
+        return cb_scale(cb, a, kb);
+
+    if (a > b)
+    {
+        cb_ref t = a;
+        a = b;
+        b = t;
+    }
+    cb_ref *slot = memo_slot(cb, a, b);
+    if (*slot >= 0)
+        return *slot;
+
+    op_t op = {.kind = OP_MUL, .a = a, .b = b};
+    cb_ref w = lc_wire(cb, new_wire(cb, op));
+    GROW(cb->cons, cb->n_cons, cb->cap_cons);
+    cb->cons[cb->n_cons++] = (cons_t){a, b, w};
+    *slot = w;
+    return w;
+}
+
+void cb_assert_eq(cb_t *cb, cb_ref a, cb_ref b)
+{
+    GROW(cb->cons, cb->n_cons, cb->cap_cons);
+    cb->cons[cb->n_cons++] = (cons_t){cb_sub(cb, a, b), cb->one, cb->zero};
+}
+
+int cb_n_wires(cb_t *cb) { return cb->n_op + 1; }
+int cb_n_cons(cb_t *cb) { return cb->n_cons; }
+int cb_n_inputs(cb_t *cb) { return cb->n_inputs; }
+const char *cb_input_name(cb_t *cb, int i) { return cb->input[i]; }
+
+static void fill_row(cb_t *cb, element_t *row, cb_ref r)
+{
+    lc_t *l = &cb->lc[r];
+    for (int t = 0; t < l->n; t++)
+        element_set(row[l->wire[t]], l->coef[t]);
+}
+
+void cb_to_r1cs(cb_t *cb, r1cs_t *r)
+{
+    int m = cb->n_cons > 0 ? cb->n_cons : 1;
+    int n = cb_n_wires(cb);
+    r->n_vars = n;
+    r->n_cons = m;
+    r->n_pub = 0;
+    r->A = malloc(sizeof(element_t *) * m);
+    r->B = malloc(sizeof(element_t *) * m);
+    r->C = malloc(sizeof(element_t *) * m);
+    for (int c = 0; c < m; c++)
+    {
+        r->A[c] = malloc(sizeof(element_t) * n);
+        r->B[c] = malloc(sizeof(element_t) * n);
+        r->C[c] = malloc(sizeof(element_t) * n);
+        for (int v = 0; v < n; v++)
+        {
+            element_init_Zr(r->A[c][v], cb->pairing);
+            element_set0(r->A[c][v]);
+            element_init_Zr(r->B[c][v], cb->pairing);
+            element_set0(r->B[c][v]);
+            element_init_Zr(r->C[c][v], cb->pairing);
+            element_set0(r->C[c][v]);
+        }
+    }
+    for (int c = 0; c < cb->n_cons; c++)
+    {
+        fill_row(cb, r->A[c], cb->cons[c].a);
+        fill_row(cb, r->B[c], cb->cons[c].b);
+        fill_row(cb, r->C[c], cb->cons[c].c);
+    }
+}
+
+static void lc_eval(cb_t *cb, element_t out, cb_ref r, element_t *w, element_t t)
+{
+    lc_t *l = &cb->lc[r];
+    element_set0(out);
+    for (int i = 0; i < l->n; i++)
+    {
+        element_mul(t, l->coef[i], w[l->wire[i]]);
+        element_add(out, out, t);
+    }
+}
+
+void cb_witness(cb_t *cb, element_t *inputs, element_t **wires)
+{
+    int n = cb_n_wires(cb);
+    element_t *w = malloc(sizeof(element_t) * n);
+    for (int i = 0; i < n; i++)
+        element_init_Zr(w[i], cb->pairing);
+    element_set1(w[0]);
+
+    element_t a, b, t;
+    element_init_Zr(a, cb->pairing);
+    element_init_Zr(b, cb->pairing);
+    element_init_Zr(t, cb->pairing);
+    for (int k = 0; k < cb->n_op; k++)
+    {
+        op_t *op = &cb->op[k];
+        if (op->kind == OP_INPUT)
+        {
+            element_set(w[k + 1], inputs[op->input]);
+            continue;
+        }
+        lc_eval(cb, a, op->a, w, t);
+        lc_eval(cb, b, op->b, w, t);
+        element_mul(w[k + 1], a, b);
+    }
+    element_clear(a);
+    element_clear(b);
+    element_clear(t);
+    *wires = w;
+}
+
+static void print_lc(cb_t *cb, FILE *f, cb_ref r)
+{
+    lc_t *l = &cb->lc[r];
+    if (l->n == 0)
+    {
+        fprintf(f, "0");
+        return;
+    }
+    for (int i = 0; i < l->n; i++)
+    {
+        if (i)
+            fprintf(f, " + ");
+        if (l->wire[i] == 0)
+            element_fprintf(f, "%B", l->coef[i]);
+        else if (element_is1(l->coef[i]))
+            fprintf(f, "w%d", l->wire[i]);
+        else
+            element_fprintf(f, "%B·w%d", l->coef[i], l->wire[i]);
+    }
+}
+
+void cb_print_program(cb_t *cb, FILE *f)
+{
+    fprintf(f, "  w0 = 1\n");
+    for (int k = 0; k < cb->n_op; k++)
+    {
+        op_t *op = &cb->op[k];
+        if (op->kind == OP_INPUT)
+        {
+            fprintf(f, "  w%d = input %s\n", k + 1, cb->input[op->input]);
+            continue;
+        }
+        fprintf(f, "  w%d = (", k + 1);
+        print_lc(cb, f, op->a);
+        fprintf(f, ") * (");
+        print_lc(cb, f, op->b);
+        fprintf(f, ")\n");
+    }
+}
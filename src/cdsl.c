@@ -0,0 +1,334 @@
+// src/cdsl.c — text front end for the circuit builder
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <gmp.h>
+#include <pbc/pbc.h>
+#include "../include/cbuild.h"
+
+#define MAX_NAME 64
+
+typedef struct {
+    char name[MAX_NAME];
+    cb_ref val;
+} sym_t;
+
+typedef struct {
+    cb_t *cb;
+    pairing_ptr pairing;
+    const char *path;
+    int line;
+    const char *s; // cursor in the current line
+    int err;
+    sym_t *sym;
+    int n_sym, cap_sym;
+} parser_t;
+
+static void perr(parser_t *p, const char *msg, const char *arg)
+{
+    if (!p->err)
+        fprintf(stderr, "%s:%d: %s%s%s\n", p->path, p->line, msg,
+                arg ? " " : "", arg ? arg : "");
+    p->err = 1;
+}
+
+static void skip_ws(parser_t *p)
+{
+    while (*p->s == ' ' || *p->s == '\t' || *p->s == '\r')
+        p->s++;
+}
+
+static int accept(parser_t *p, const char *tok)
+{
+    skip_ws(p);
+    size_t n = strlen(tok);
+    if (strncmp(p->s, tok, n) != 0)
+        return 0;
+    p->s += n;
+    return 1;
+}
+
+static int read_name(parser_t *p, char *out)
+{
+    skip_ws(p);
+    if (!isalpha((unsigned char)*p->s) && *p->s != '_')
+        return 0;
+    int n = 0;
+    while (isalnum((unsigned char)*p->s) || *p->s == '_')
+    {
+        if (n == MAX_NAME - 1)
+        {
+            // truncating would let two long names alias
+            out[n] = '\0';
+            perr(p, "name longer than 63 characters:", out);
+            return 0;
+        }
+        out[n++] = *p->s++;
+    }
+    out[n] = '\0';
+    return 1;
+}
+
+static sym_t *lookup(parser_t *p, const char *name)
+{
+    for (int i = p->n_sym - 1; i >= 0; i--)
+        if (strcmp(p->sym[i].name, name) == 0)
+            return &p->sym[i];
+    return NULL;
+}
+
+static void bind(parser_t *p, const char *name, cb_ref v)
+{
+    sym_t *s = lookup(p, name);
+    if (!s)
+    {
+        if (p->n_sym == p->cap_sym)
+        {
+            p->cap_sym = p->cap_sym ? 2 * p->cap_sym : 16;
+            p->sym = realloc(p->sym, sizeof(sym_t) * p->cap_sym);
+        }
+        s = &p->sym[p->n_sym++];
+        strcpy(s->name, name);
+    }
+    s->val = v;
+}
+
+static cb_ref expr(parser_t *p);
+
+// atom := NUMBER | NAME | '(' expr ')'
+static cb_ref atom(parser_t *p)
+{
+    char name[MAX_NAME];
+    skip_ws(p);
+    if (isdigit((unsigned char)*p->s))
+    {
+        const char *start = p->s;
+        while (isdigit((unsigned char)*p->s))
+            p->s++;
+        char *num = strndup(start, p->s - start);
+        element_t c;
+        element_init_Zr(c, p->pairing);
+        element_set_str(c, num, 10);
+        cb_ref r = cb_const(p->cb, c);
+        element_clear(c);
+        free(num);
+        return r;
+    }
+    if (read_name(p, name))
+    {
+        sym_t *s = lookup(p, name);
+        if (!s)
+        {
+            perr(p, "undefined name", name);
+            return cb_zero(p->cb);
+        }
+        return s->val;
+    }
+    if (accept(p, "("))
+    {
+        cb_ref r = expr(p);
+        if (!accept(p, ")"))
+            perr(p, "expected ')'", NULL);
+        return r;
+    }
+    perr(p, "expected a number, name or '('", NULL);
+    return cb_zero(p->cb);
+}
+
+// power := atom ('^' NUMBER)?   — square-and-multiply, log2(k) products
+static cb_ref power(parser_t *p)
+{
+    cb_ref base = atom(p);
+    if (!accept(p, "^"))
+        return base;
+    skip_ws(p);
+    if (!isdigit((unsigned char)*p->s))
+    {
+        perr(p, "exponent must be a non-negative integer", NULL);
+        return base;
+    }
+    long k = strtol(p->s, (char **)&p->s, 10);
+    cb_ref acc = cb_one(p->cb);
+    while (k > 0)
+    {
+        if (k & 1)
+            acc = cb_mul(p->cb, acc, base);
+        k >>= 1;
+        if (k)
+            base = cb_mul(p->cb, base, base);
+    }
+    return acc;
+}
+
+// unary := '-' unary | power
+static cb_ref unary(parser_t *p)
+{
+    if (accept(p, "-"))
+        return cb_sub(p->cb, cb_zero(p->cb), unary(p));
+    return power(p);
+}
+
+// term := unary ('*' unary)*
+static cb_ref term(parser_t *p)
+{
+    cb_ref r = unary(p);
+    while (!p->err && accept(p, "*"))
+        r = cb_mul(p->cb, r, unary(p));
+    return r;
+}
+
+// expr := term (('+' | '-') term)*
+static cb_ref expr(parser_t *p)
+{
+    cb_ref r = term(p);
+    while (!p->err)
+    {
+        if (accept(p, "+"))
+            r = cb_add(p->cb, r, term(p));
+        else if (accept(p, "-"))
+            r = cb_sub(p->cb, r, term(p));
+        else
+            break;
+    }
+    return r;
+}
+
+static int at_end(parser_t *p)
+{
+    skip_ws(p);
+    return *p->s == '\0' || *p->s == '#' || *p->s == '\n';
+}
+
+static void statement(parser_t *p)
+{
+    char name[MAX_NAME] = "";
+    if (at_end(p))
+        return;
+    const char *save = p->s;
+    if (read_name(p, name) && strcmp(name, "input") == 0)
+    {
+        do
+        {
+            if (!read_name(p, name))
+            {
+                perr(p, "expected an input name", NULL);
+                return;
+            }
+            if (lookup(p, name))
+            {
+                perr(p, "redefinition of", name);
+                return;
+            }
+            bind(p, name, cb_input(p->cb, name));
+        } while (accept(p, ","));
+    }
+    else if (strcmp(name, "assert") == 0)
+    {
+        cb_ref a = expr(p);
+        if (!accept(p, "=="))
+        {
+            perr(p, "expected '=='", NULL);
+            return;
+        }
+        cb_ref b = expr(p);
+        cb_assert_eq(p->cb, a, b);
+    }
+    else
+    {
+        p->s = save;
+        if (!read_name(p, name) || !accept(p, "=") || *p->s == '=')
+        {
+            perr(p, "expected 'input', 'assert' or 'name = expr'", NULL);
+            return;
+        }
+        bind(p, name, expr(p));
+    }
+    if (!p->err && !at_end(p))
+        perr(p, "unexpected text:", p->s);
+}
+
+cb_t *cb_parse_file(const char *path, pairing_t pairing)
+{
+    FILE *f = fopen(path, "r");
+    if (!f)
+    {
+        perror(path);
+        return NULL;
+    }
+    parser_t p = {.cb = cb_new(pairing), .pairing = pairing, .path = path};
+    char *buf = NULL;
+    size_t cap = 0;
+    while (!p.err && getline(&buf, &cap, f) >= 0)
+    {
+        p.line++;
+        p.s = buf;
+        statement(&p);
+    }
+    free(buf);
+    free(p.sym);
+    fclose(f);
+    if (p.err)
+    {
+        cb_free(p.cb);
+        return NULL;
+    }
+    return p.cb;
+}
+
+// e = s for a decimal integer s (optional '-'), reduced mod r; -1 otherwise
+static int parse_value(element_t e, const char *s, pairing_t pairing)
+{
+    const char *d = s + (*s == '-');
+    if (!*d || strspn(d, "0123456789") != strlen(d))
+        return -1;
+    mpz_t z;
+    mpz_init(z);
+    mpz_set_str(z, s, 10);
+    mpz_mod(z, z, pairing->r);
+    element_set_mpz(e, z);
+    mpz_clear(z);
+    return 0;
+}
+
+int cb_load(const char *path, int argc, char **argv, pairing_t pairing,
+            r1cs_t *r, element_t **wires)
+{
+    cb_t *cb = cb_parse_file(path, pairing);
+    if (!cb)
+        return -1;
+    int ni = cb_n_inputs(cb), rc = 0;
+    element_t *in = malloc(sizeof(element_t) * (ni > 0 ? ni : 1));
+    for (int i = 0; i < ni; i++)
+    {
+        const char *name = cb_input_name(cb, i);
+        size_t len = strlen(name);
+        int found = 0;
+        element_init_Zr(in[i], pairing);
+        for (int a = 0; a < argc && !found; a++)
+            if (strncmp(argv[a], name, len) == 0 && argv[a][len] == '=')
+            {
+                found = 1;
+                if (parse_value(in[i], argv[a] + len + 1, pairing) != 0)
+                {
+                    fprintf(stderr, "%s: bad value for input '%s': '%s'\n", path, name, argv[a] + len + 1);
+                    rc = -1;
+                }
+            }
+        if (!found)
+        {
+            fprintf(stderr, "%s: no value for input '%s' (pass %s=...)\n", path, name, name);
+            rc = -1;
+        }
+    }
+    if (rc == 0)
+    {
+        cb_to_r1cs(cb, r);
+        cb_witness(cb, in, wires);
+    }
+    for (int i = 0; i < ni; i++)
+        element_clear(in[i]);
+    free(in);
+    cb_free(cb);
+    return rc;
+}
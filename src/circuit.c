@@ -4,30 +4,28 @@
 #include <pbc/pbc.h>
 #include "../include/circuit.h"
 
-// src/circuit.c  (replace the whole build_r1cs with this)
-void build_r1cs(int d,
-                element_t *coeffs,
-                element_t x,
-                element_t y,
-                r1cs_t *r1cs,
-                element_t **wires,
-                pairing_t pairing)
+void r1cs_shape(int d, int *n_vars, int *n_cons)
+{
+    *n_vars = 2 * (d + 1) + CIRCUIT_N_PUB;
+    *n_cons = (d > 0 ? (2 * d + 2) : 2);
+}
+
+int r1cs_pub(int d)
+{
+    return 2 * (d + 1);
+}
+
+void build_witness(int d,
+                   element_t *coeffs,
+                   element_t x,
+                   element_t **wires,
+                   pairing_t pairing)
 {
-    // Layout:
-    // wires[0..d]     : w_i = x^i   (w0=1, w1=x, …, wd=x^d)
-    // wires[d+1..2d+1]: s_i partial sums (s0..sd)
     int n_pow = d + 1;
     int n_sum = d + 1;
-    int n_vars = n_pow + n_sum;
+    int n_vars = n_pow + n_sum + CIRCUIT_N_PUB;
 
-    // Constraints:
-    // 1) s0 = a0 * w0                      -> 1
-    // 2) w_i * w1 = w_{i+1} for i=1..d-1   -> (d-1)
-    // 3) s_i = s_{i-1} + a_i * w_i for i=1..d -> d
-    // 4) s_d * 1 = y                       -> 1
-    int n_cons = (d > 0 ? (2 * d + 1) : 2);
-
-    // ---- wires (w^i and partial sums) ----
+    // ---- wires (w^i, partial sums, public x and y) ----
     *wires = malloc(sizeof(element_t) * n_vars);
     for (int i = 0; i < n_vars; i++)
         element_init_Zr((*wires)[i], pairing);
@@ -54,9 +52,43 @@ void build_r1cs(int d,
         element_clear(term);
     }
 
+    // public inputs
+    element_set((*wires)[n_pow + n_sum], x);
+    element_set((*wires)[n_pow + n_sum + 1], (*wires)[off + d]);
+}
+
+void build_r1cs(int d,
+                element_t *coeffs,
+                element_t x,
+                element_t y,
+                r1cs_t *r1cs,
+                element_t **wires,
+                pairing_t pairing)
+{
+    // Layout:
+    // wires[0..d]     : w_i = x^i   (w0=1, w1=x, …, wd=x^d)
+    // wires[d+1..2d+1]: s_i partial sums (s0..sd)
+    // wires[2d+2], [2d+3]: public x and y
+    //
+    // Constraints:
+    // 1) s0 = a0 * w0                      -> 1
+    // 2) w_i * w1 = w_{i+1} for i=1..d-1   -> (d-1)
+    // 3) s_i = s_{i-1} + a_i * w_i for i=1..d -> d
+    // 4) s_d * 1 = y                       -> 1
+    // 5) w1 * 1 = x (d > 0)                -> 1
+    // The public wires only ever appear in C.
+    int n_vars, n_cons;
+    r1cs_shape(d, &n_vars, &n_cons);
+    int off = d + 1; // start of s_i region
+    int pub = r1cs_pub(d);
+
+    build_witness(d, coeffs, x, wires, pairing);
+    element_set((*wires)[pub + 1], y); // the claim, which may be false
+
     // ---- allocate R1CS A,B,C ----
     r1cs->n_vars = n_vars;
     r1cs->n_cons = n_cons;
+    r1cs->n_pub = CIRCUIT_N_PUB;
     r1cs->A = malloc(sizeof(element_t *) * n_cons);
     r1cs->B = malloc(sizeof(element_t *) * n_cons);
     r1cs->C = malloc(sizeof(element_t *) * n_cons);
@@ -102,8 +134,87 @@ void build_r1cs(int d,
         element_set1(r1cs->C[ci][off + i]);     // = s_i
     }
 
-    // (4) final check: s_d * 1 = y (y lives as constant via w0 == 1)
+    // (4) final check: s_d * 1 = y
     element_set1(r1cs->A[ci][off + d]); // s_d
     element_set1(r1cs->B[ci][0]);       // × 1
-    element_set(r1cs->C[ci][0], y);     // = y (since w0 == 1)
+    element_set1(r1cs->C[ci][pub + 1]); // = y
+    ci++;
+
+    // (5) bind the public x to the power chain: w1 * 1 = x
+    if (d > 0)
+    {
+        element_set1(r1cs->A[ci][1]);   // w1
+        element_set1(r1cs->B[ci][0]);   // × 1
+        element_set1(r1cs->C[ci][pub]); // = x
+    }
+}
+
+void eval_r1cs_columns(int d,
+                       element_t *coeffs,
+                       element_t *L,
+                       element_t *valA,
+                       element_t *valB,
+                       element_t *valC,
+                       pairing_t pairing)
+{
+    // Same constraint layout as build_r1cs: every nonzero entry M[k][j]
+    // contributes M[k][j]·L_k(τ) to column j, so one pass over the rows
+    // replaces the dense per-column interpolation.
+    int n_vars, n_cons;
+    r1cs_shape(d, &n_vars, &n_cons);
+    int off = d + 1;
+    int pub = r1cs_pub(d);
+    int yrow = 2 * d + (d == 0); // row (4)
+
+    for (int j = 0; j < n_vars; j++)
+    {
+        element_init_Zr(valA[j], pairing);
+        element_set0(valA[j]);
+        element_init_Zr(valB[j], pairing);
+        element_set0(valB[j]);
+        element_init_Zr(valC[j], pairing);
+        element_set0(valC[j]);
+    }
+    element_t t;
+    element_init_Zr(t, pairing);
+
+    // (1) (a0·w0) * 1 = s0
+    element_mul(t, coeffs[0], L[0]);
+    element_add(valA[0], valA[0], t);
+    element_add(valB[0], valB[0], L[0]);
+    element_add(valC[off + 0], valC[off + 0], L[0]);
+
+    // (2) w_i * w1 = w_{i+1}, row i
+    for (int i = 1; i <= d - 1; i++)
+    {
+        element_add(valA[i], valA[i], L[i]);
+        element_add(valB[1], valB[1], L[i]);
+        element_add(valC[i + 1], valC[i + 1], L[i]);
+    }
+
+    // (3) (s_{i-1} + a_i·w_i) * 1 = s_i, row d-1+i
+    for (int i = 1; i <= d; i++)
+    {
+        element_ptr Lk = L[d - 1 + i];
+        element_add(valA[off + i - 1], valA[off + i - 1], Lk);
+        element_mul(t, coeffs[i], Lk);
+        element_add(valA[i], valA[i], t);
+        element_add(valB[0], valB[0], Lk);
+        element_add(valC[off + i], valC[off + i], Lk);
+    }
+
+    // (4) s_d * 1 = y
+    element_add(valA[off + d], valA[off + d], L[yrow]);
+    element_add(valB[0], valB[0], L[yrow]);
+    element_add(valC[pub + 1], valC[pub + 1], L[yrow]);
+
+    // (5) w1 * 1 = x, row 2d+1
+    if (d > 0)
+    {
+        element_add(valA[1], valA[1], L[yrow + 1]);
+        element_add(valB[0], valB[0], L[yrow + 1]);
+        element_add(valC[pub], valC[pub], L[yrow + 1]);
+    }
+
+    element_clear(t);
 }
@@ -54,6 +54,13 @@ void fmt_kv_e(const char *k, element_t e)
     element_printf("%B\n", e);
 }
 
+void fmt_pairing(pairing_t pairing)
+{
+    fmt_kv_s("pairing", pairing_is_symmetric(pairing) ? "symmetric (G1 = G2)" : "asymmetric");
+    fmt_kv_i("G1 bytes", pairing_length_in_bytes_G1(pairing));
+    fmt_kv_i("G2 bytes", pairing_length_in_bytes_G2(pairing));
+}
+
 void fmt_vec_e(const char *title, element_t *arr, int n)
 {
     if (title && *title)
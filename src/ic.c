@@ -0,0 +1,34 @@
+// src/ic.c
+#include <stdlib.h>
+#include <pbc/pbc.h>
+#include "../include/ic.h"
+
+void ic_table_init(ic_table_t *t, element_t *ic, int l, pairing_t pairing)
+{
+    t->l = l;
+    t->t = malloc(sizeof(fb_table_t) * (l > 0 ? l : 1));
+    for (int i = 0; i < l; i++)
+        fb_table_init(&t->t[i], ic[i], pairing);
+}
+
+void ic_table_clear(ic_table_t *t)
+{
+    for (int i = 0; i < t->l; i++)
+        fb_table_clear(&t->t[i]);
+    free(t->t);
+    t->t = NULL;
+    t->l = 0;
+}
+
+void ic_table_eval(element_t out, const ic_table_t *t, element_t *x)
+{
+    element_t term;
+    element_init_same_as(term, out);
+    element_set0(out);
+    for (int i = 0; i < t->l; i++)
+    {
+        fb_pow(term, &t->t[i], x[i]);
+        element_mul(out, out, term);
+    }
+    element_clear(term);
+}
@@ -3,169 +3,19 @@
 #include <stdlib.h>
 #include <pbc/pbc.h>
 #include "../include/circuit.h"
+#include "../include/r1cs_opt.h"
 #include "../include/poly.h"
+#include "../include/subprod.h"
+#include "../include/qap.h"
+#include "../include/pool.h"
+#include "../include/qapcache.h"
+#include "../include/io.h"
 #include "fmt.h"
-
-// Helper: multiply two polynomials a,b of degree< m,
-// truncating to degree < m: result in res (all length m).
-static void poly_mul(
-    element_t *res,
-    element_t *a,
-    element_t *b,
-    int m,
-    pairing_t pairing)
-{
-    // temp polynomial
-    element_t *tmp = malloc(sizeof(element_t) * m);
-    for (int i = 0; i < m; i++)
-    {
-        element_init_Zr(tmp[i], pairing);
-        element_set0(tmp[i]);
-    }
-    for (int i = 0; i < m; i++)
-    {
-        if (!element_is0(a[i]))
-        {
-            for (int j = 0; j + i < m; j++)
-            {
-                if (!element_is0(b[j]))
-                {
-                    element_t t;
-                    element_init_Zr(t, pairing);
-                    element_mul(t, a[i], b[j]);
-                    element_add(tmp[i + j], tmp[i + j], t);
-                    element_clear(t);
-                }
-            }
-        }
-    }
-    // copy back
-    for (int i = 0; i < m; i++)
-    {
-        element_set(res[i], tmp[i]);
-        element_clear(tmp[i]);
-    }
-    free(tmp);
-}
-
-void lagrange_interpolation(
-    element_t *out,
-    element_t *tau,
-    element_t *eval,
-    int m,
-    pairing_t pairing)
-{
-    // Initialize out[] = 0
-    for (int i = 0; i < m; i++)
-    {
-        element_init_Zr(out[i], pairing);
-        element_set0(out[i]);
-    }
-
-    // Workspace for basis polynomial
-    element_t *basis = malloc(sizeof(element_t) * m);
-    element_t *next_basis = malloc(sizeof(element_t) * m);
-
-    for (int k = 0; k < m; k++)
-    {
-        // 1) build ℓ_k numerator = ∏_{j≠k} (x - τ[j])
-        // start with basis = [1,0,0,...]
-        for (int i = 0; i < m; i++)
-        {
-            element_init_Zr(basis[i], pairing);
-            element_set0(basis[i]);
-        }
-        element_set1(basis[0]);
-
-        for (int j = 0; j < m; j++)
-        {
-            if (j == k)
-                continue;
-            // multiply basis by (x - τ[j])
-            // i.e. polynomial [ -τ[j], 1 ]
-            for (int i = 0; i < m; i++)
-            {
-                element_init_Zr(next_basis[i], pairing);
-                element_set0(next_basis[i]);
-            }
-            // next_basis[i+1] += basis[i]
-            for (int i = 0; i < m - 1; i++)
-            {
-                if (!element_is0(basis[i]))
-                {
-                    element_add(next_basis[i + 1], next_basis[i + 1], basis[i]);
-                }
-            }
-            // next_basis[i] += basis[i] * (-τ[j])
-            for (int i = 0; i < m; i++)
-            {
-                if (!element_is0(basis[i]))
-                {
-                    element_t neg;
-                    element_init_Zr(neg, pairing);
-                    element_neg(neg, tau[j]);
-                    element_mul(neg, neg, basis[i]);
-                    element_add(next_basis[i], next_basis[i], neg);
-                    element_clear(neg);
-                }
-            }
-            // swap next_basis→basis
-            for (int i = 0; i < m; i++)
-            {
-                element_set(basis[i], next_basis[i]);
-                element_clear(next_basis[i]);
-            }
-        }
-
-        // 2) compute denominator denom = ∏_{j≠k} (τ[k] - τ[j])
-        element_t denom;
-        element_init_Zr(denom, pairing);
-        element_set1(denom);
-        for (int j = 0; j < m; j++)
-        {
-            if (j == k)
-                continue;
-            element_t diff;
-            element_init_Zr(diff, pairing);
-            element_sub(diff, tau[k], tau[j]);
-            element_mul(denom, denom, diff);
-            element_clear(diff);
-        }
-        // invert denom
-        element_t inv_denom;
-        element_init_Zr(inv_denom, pairing);
-        element_invert(inv_denom, denom);
-        element_clear(denom);
-
-        // 3) scale basis by eval[k] * inv_denom
-        element_t scale;
-        element_init_Zr(scale, pairing);
-        element_mul(scale, eval[k], inv_denom);
-        element_clear(inv_denom);
-
-        for (int i = 0; i < m; i++)
-        {
-            element_t tmp;
-            element_init_Zr(tmp, pairing);
-            element_mul(tmp, basis[i], scale);
-            element_add(out[i], out[i], tmp);
-            element_clear(tmp);
-        }
-        element_clear(scale);
-
-        // clear basis
-        for (int i = 0; i < m; i++)
-        {
-            element_clear(basis[i]);
-        }
-    }
-
-    free(basis);
-    free(next_basis);
-}
+#include "memstat.h"
 
 int main(int argc, char **argv)
 {
+    memstat_init();
     if (argc < 5)
     {
         fprintf(stderr,
@@ -179,25 +29,12 @@ int main(int argc, char **argv)
     fmt_banner("QAP Interpolation");
 
     // --- init pairing (as in build_circuit) ---
-    FILE *fp = fopen(argv[1], "r");
-    fseek(fp, 0, SEEK_END);
-    long sz = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-    char *buf = malloc(sz + 1);
-    if (fread(buf, 1, sz, fp) != sz)
-    {
-        perror("fread a.param");
-        return 1;
-    }
-    buf[sz] = '\0';
-    fclose(fp);
-    pbc_param_t params;
-    pbc_param_init_set_buf(params, buf, sz + 1);
-    free(buf);
     pairing_t pairing;
-    pairing_init_pbc_param(pairing, params);
+    if (load_pairing(argv[1], pairing) != 0)
+        return 1;
 
     // --- parse inputs & build R1CS ---
+    memstat_stage("circuit");
     int i, argi = 2;
     int d = atoi(argv[argi++]);
     element_t x, y;
@@ -214,6 +51,7 @@ int main(int argc, char **argv)
     r1cs_t r1cs;
     element_t *wires;
     build_r1cs(d, coeffs, x, y, &r1cs, &wires, pairing);
+    r1cs_maybe_optimize(&r1cs, &wires, pairing);
 
     int m = r1cs.n_cons;
     int n = r1cs.n_vars;
@@ -226,63 +64,82 @@ int main(int argc, char **argv)
         element_set_si(tau[i], i + 1);
     }
 
-    // --- for each variable j, gather A_eval[k] = r1cs.A[k][j] ---
-    element_t *A_eval = malloc(sizeof(element_t) * m);
-    element_t *B_eval = malloc(sizeof(element_t) * m);
-    element_t *C_eval = malloc(sizeof(element_t) * m);
-
-    element_t *polyA = malloc(sizeof(element_t) * m);
-    element_t *polyB = malloc(sizeof(element_t) * m);
-    element_t *polyC = malloc(sizeof(element_t) * m);
+    // --- reuse cached columns for this exact circuit, or record them ---
+    qap_cache_t cache;
+    qap_cache_writer_t writer;
+    int hit = (qap_cache_open(&cache, &r1cs, pairing) == 0);
+    int record = !hit && qap_cache_begin(&writer, &r1cs, pairing) == 0;
+    fmt_kv_s("QAP cache", hit ? "hit" : (record ? "miss (writing)" : "off"));
+
+    subprod_tree_t tree;
+    if (!hit)
+        subprod_tree_init(&tree, tau, m, pairing);
+
+    // --- interpolate columns in parallel, one block at a time, print in order ---
+    memstat_stage("interpolate");
+    pool_t *pool = pool_create(pool_default_threads());
+    int block = 16 * pool_size(pool); // bounds the number of live column polys
+    element_t **polyA = malloc(sizeof(element_t *) * block);
+    element_t **polyB = malloc(sizeof(element_t *) * block);
+    element_t **polyC = malloc(sizeof(element_t *) * block);
+    for (i = 0; i < block; i++)
+    {
+        polyA[i] = malloc(sizeof(element_t) * m);
+        polyB[i] = malloc(sizeof(element_t) * m);
+        polyC[i] = malloc(sizeof(element_t) * m);
+    }
 
-    for (int j = 0; j < n; j++)
+    for (int j0 = 0; j0 < n; j0 += block)
     {
-        // extract column j
-        for (int k = 0; k < m; k++)
-        {
-            element_init_Zr(A_eval[k], pairing);
-            element_set(A_eval[k], r1cs.A[k][j]);
-            element_init_Zr(B_eval[k], pairing);
-            element_set(B_eval[k], r1cs.B[k][j]);
-            element_init_Zr(C_eval[k], pairing);
-            element_set(C_eval[k], r1cs.C[k][j]);
-        }
+        int j1 = (j0 + block < n ? j0 + block : n);
         // interp: get polynomials of degree < m
-        lagrange_interpolation(polyA, tau, A_eval, m, pairing);
-        lagrange_interpolation(polyB, tau, B_eval, m, pairing);
-        lagrange_interpolation(polyC, tau, C_eval, m, pairing);
-
-        // Print out the coefficient vectors:
-        // printf("Variable %d → A_j(x) coeffs:", j);
-        // for (i = 0; i < m; i++)
-        //     element_printf(" %B", polyA[i]);
-        // printf("\n");
-        // printf("           B_j(x) coeffs:");
-        // for (i = 0; i < m; i++)
-        //     element_printf(" %B", polyB[i]);
-        // printf("\n");
-        // printf("           C_j(x) coeffs:");
-        // for (i = 0; i < m; i++)
-        //     element_printf(" %B", polyC[i]);
-        // printf("\n\n");
-        fmt_sub("Variable polynomials");
-        printf("  var %d\n", j);
-        printf("    A_j(x): "); for(i = 0; i < m; i++) element_printf("%B ", polyA[i]); printf("\n");
-        printf("    B_j(x): "); for(i = 0; i < m; i++) element_printf("%B ", polyB[i]); printf("\n");
-        printf("    C_j(x): "); for(i = 0; i < m; i++) element_printf("%B ", polyC[i]); printf("\n");
+        if (hit)
+            for (int j = j0; j < j1; j++)
+            {
+                qap_cache_column(polyA[j - j0], &cache, j, 0, pairing);
+                qap_cache_column(polyB[j - j0], &cache, j, 1, pairing);
+                qap_cache_column(polyC[j - j0], &cache, j, 2, pairing);
+            }
+        else
+            qap_interp_columns(pool, &r1cs, &tree, j0, j1, polyA, polyB, polyC);
 
-        // clear eval & poly arrays for next j
-        for (i = 0; i < m; i++)
+        for (int j = j0; j < j1; j++)
         {
-            element_clear(A_eval[i]);
-            element_clear(B_eval[i]);
-            element_clear(C_eval[i]);
-            element_clear(polyA[i]);
-            element_clear(polyB[i]);
-            element_clear(polyC[i]);
+            element_t *pA = polyA[j - j0], *pB = polyB[j - j0], *pC = polyC[j - j0];
+            fmt_sub("Variable polynomials");
+            printf("  var %d\n", j);
+            printf("    A_j(x): "); for(i = 0; i < m; i++) element_printf("%B ", pA[i]); printf("\n");
+            printf("    B_j(x): "); for(i = 0; i < m; i++) element_printf("%B ", pB[i]); printf("\n");
+            printf("    C_j(x): "); for(i = 0; i < m; i++) element_printf("%B ", pC[i]); printf("\n");
+            if (record)
+                qap_cache_append(&writer, pA, pB, pC);
+
+            // clear poly arrays for the next block
+            for (i = 0; i < m; i++)
+            {
+                element_clear(pA[i]);
+                element_clear(pB[i]);
+                element_clear(pC[i]);
+            }
         }
     }
 
+    for (i = 0; i < block; i++)
+    {
+        free(polyA[i]);
+        free(polyB[i]);
+        free(polyC[i]);
+    }
+    free(polyA);
+    free(polyB);
+    free(polyC);
+    pool_destroy(pool);
+    if (record)
+        qap_cache_finish(&writer);
+    if (hit)
+        qap_cache_close(&cache);
+    else
+        subprod_tree_clear(&tree);
     // Cleanup r1cs, wires, tau, etc. (omitted for brevity)
     return 0;
 }
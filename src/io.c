@@ -0,0 +1,224 @@
+// src/io.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <arpa/inet.h> // htonl / ntohl
+#include <pbc/pbc.h>
+#include "../include/io.h"
+#include "../include/pctx.h"
+
+int write_exact(FILE *f, const void *p, size_t n) {
+    const unsigned char *b = (const unsigned char*)p;
+    size_t w = 0;
+    while (w < n) {
+        size_t r = fwrite(b + w, 1, n - w, f);
+        if (r == 0) return -1;
+        w += r;
+    }
+    return 0;
+}
+
+int write_u32(FILE *f, uint32_t v_host) {
+    uint32_t v = htonl(v_host);
+    return write_exact(f, &v, 4);
+}
+
+int write_elem(FILE *f, element_t e) {
+    int len = element_length_in_bytes(e);
+    unsigned char *buf = (unsigned char*)malloc(len);
+    element_to_bytes(buf, e);
+    int ok = (write_u32(f, (uint32_t)len) == 0 && write_exact(f, buf, (size_t)len) == 0);
+    free(buf);
+    return ok ? 0 : -1;
+}
+
+int read_exact(FILE *f, void *p, size_t n) {
+    unsigned char *b = (unsigned char*)p;
+    size_t rtot = 0;
+    while (rtot < n) {
+        size_t r = fread(b + rtot, 1, n - rtot, f);
+        if (r == 0) return -1;
+        rtot += r;
+    }
+    return 0;
+}
+
+int read_u32(FILE *f, uint32_t *out_host) {
+    uint32_t v_be;
+    if (read_exact(f, &v_be, 4) != 0) return -1;
+    *out_host = ntohl(v_be);
+    return 0;
+}
+
+// Elements have a fixed encoding length per group; on asymmetric pairings
+// G1 and G2 differ, so a length mismatch means the wrong group or params.
+static int check_len(element_t out, uint32_t len, const char *group) {
+    int want = element_length_in_bytes(out);
+    if (len == (uint32_t)want) return 0;
+    fprintf(stderr, "Expected a %d-byte %s element, found %u bytes (other pairing params?)\n", want, group, len);
+    return -1;
+}
+
+static const char *group_name(element_t e) {
+    pairing_ptr p = e->field->pairing;
+    return e->field == p->G1 ? "G1" : e->field == p->G2 ? "G2" : "Zr";
+}
+
+// coordinates (and scalars) ≥ the modulus decode modulo it; the re-encoding
+// tells them apart
+static int decode_point(element_t out, const unsigned char *buf, uint32_t len, const char *group) {
+    unsigned char *re = (unsigned char*)malloc(len);
+    if (!re) return -1;
+    element_from_bytes(out, (unsigned char*)buf);
+    element_to_bytes(re, out);
+    int ok = memcmp(buf, re, len) == 0 && (group[0] == 'Z' || elem_on_curve(out));
+    free(re);
+    if (!ok) { fprintf(stderr, "Invalid %s element: not a canonical %s\n", group, group[0] == 'Z' ? "scalar" : "point on the curve"); return -1; }
+    return 0;
+}
+
+static int read_elem(FILE *f, element_t out, const char *group) {
+    uint32_t len; if (read_u32(f, &len) != 0 || check_len(out, len, group) != 0) return -1;
+    unsigned char *buf = (unsigned char*)malloc(len);
+    if (!buf) return -1;
+    if (read_exact(f, buf, len) != 0) { free(buf); return -1; }
+    int rc = decode_point(out, buf, len, group);
+    free(buf);
+    return rc;
+}
+
+int io_get_point(element_t out, const unsigned char **p, const unsigned char *end) {
+    if (end - *p < 4) return -1;
+    uint32_t len = io_get_u32(*p);
+    const char *group = group_name(out);
+    if (check_len(out, len, group) != 0 || (size_t)(end - *p - 4) < len) return -1;
+    if (decode_point(out, *p + 4, len, group) != 0) return -1;
+    *p += 4 + (size_t)len;
+    return 0;
+}
+
+int io_fits(FILE *f, uint64_t n, int len) {
+    struct stat st; long at = ftell(f);
+    if (at < 0 || fstat(fileno(f), &st) != 0 || st.st_size < at) return 0;
+    return n <= (uint64_t)(st.st_size - at) / (4 + (uint64_t)len);
+}
+
+int elem_on_curve(element_t e) {
+    if (element_is0(e)) return 1;
+    element_ptr x = element_x(e), y = element_y(e);
+    element_t l, r;
+    element_init_same_as(l, x); element_init_same_as(r, x);
+    element_square(l, y);                                                    // y²
+    element_square(r, x); element_add(r, r, curve_a_coeff(e)); element_mul(r, r, x); // (x² + a)·x
+    element_add(r, r, curve_b_coeff(e));
+    int ok = element_cmp(l, r) == 0;
+    element_clear(l); element_clear(r);
+    return ok;
+}
+
+int read_elem_G1(FILE *f, pairing_t pairing, element_t out) {
+    element_init_G1(out, pairing);
+    if (read_elem(f, out, "G1") != 0) { element_clear(out); return -1; }
+    return 0;
+}
+
+int read_elem_G2(FILE *f, pairing_t pairing, element_t out) {
+    element_init_G2(out, pairing);
+    if (read_elem(f, out, "G2") != 0) { element_clear(out); return -1; }
+    return 0;
+}
+
+int read_elem_Zr(FILE *f, pairing_t pairing, element_t out) {
+    element_init_Zr(out, pairing);
+    if (read_elem(f, out, "Zr") != 0) { element_clear(out); return -1; }
+    return 0;
+}
+
+int io_is_snapshot(const char *path) {
+    unsigned char magic[4];
+    FILE *fp = fopen(path, "rb");
+    if (!fp) return 0;
+    int is = (fread(magic, 1, 4, fp) == 4 && memcmp(magic, PCTX_MAGIC, 4) == 0);
+    fclose(fp);
+    return is;
+}
+
+char *io_read_params(const char *path, size_t *len) {
+    io_map_t map;
+    if (io_map_open(&map, path) != 0) return NULL;
+    const char *text = (const char*)map.base;
+    size_t n = map.size;
+    if (n >= 4 && memcmp(map.base, PCTX_MAGIC, 4) == 0) { // snapshot: embedded params
+        if (n < 12 || io_get_u32(map.base + 4) != PCTX_VERSION || io_get_u32(map.base + 8) > n - 12) {
+            fprintf(stderr, "Error: '%s' is not a valid pairing snapshot\n", path);
+            io_map_close(&map); return NULL;
+        }
+        text = (const char*)map.base + 12;
+        n = io_get_u32(map.base + 8);
+    }
+    char *buf = (char*)malloc(n + 1);
+    memcpy(buf, text, n);
+    if (n == 0 || buf[n - 1] != '\0') buf[n++] = '\0';
+    io_map_close(&map);
+    *len = n;
+    return buf;
+}
+
+int load_pairing(const char *path, pairing_t pairing) {
+    size_t n;
+    char *buf = io_read_params(path, &n);
+    if (!buf) return -1;
+    pbc_param_t params; pbc_param_init_set_buf(params, buf, n); free(buf);
+    pairing_init_pbc_param(pairing, params);
+    return 0;
+}
+
+int io_map_open(io_map_t *mp, const char *path) {
+    mp->base = NULL; mp->size = 0;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { fprintf(stderr, "Error opening '%s': %s\n", path, strerror(errno)); return -1; }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        fprintf(stderr, "Error: '%s' is empty or unreadable\n", path); close(fd); return -1;
+    }
+    void *p = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // the mapping keeps the file referenced
+    if (p == MAP_FAILED) { fprintf(stderr, "mmap '%s': %s\n", path, strerror(errno)); return -1; }
+    mp->base = (unsigned char*)p;
+    mp->size = (size_t)st.st_size;
+    return 0;
+}
+
+void io_map_close(io_map_t *mp) {
+    if (mp->base) munmap(mp->base, mp->size);
+    mp->base = NULL; mp->size = 0;
+}
+
+uint32_t io_get_u32(const unsigned char *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+int write_u32le(FILE *f, uint32_t v) {
+    unsigned char b[4];
+    for (int i = 0; i < 4; i++) b[i] = (unsigned char)(v >> (8 * i));
+    return write_exact(f, b, 4);
+}
+
+int write_u64le(FILE *f, uint64_t v) {
+    unsigned char b[8];
+    for (int i = 0; i < 8; i++) b[i] = (unsigned char)(v >> (8 * i));
+    return write_exact(f, b, 8);
+}
+
+uint32_t io_get_u32le(const unsigned char *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint64_t io_get_u64le(const unsigned char *p) {
+    return (uint64_t)io_get_u32le(p) | ((uint64_t)io_get_u32le(p + 4) << 32);
+}
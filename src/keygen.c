@@ -5,84 +5,783 @@
 #include <string.h>
 #include <pbc/pbc.h>
 #include "circuit.h"
+#include "r1cs_opt.h"
+#include "cbuild.h"
+#include "r1csfile.h"
 #include "poly.h"
+#include "subprod.h"
+#include "qap.h"
+#include "pool.h"
 #include "keys.h"
+#include "msm.h"
+#include "ptau.h"
+#include "qapcache.h"
+#include "witness.h"
+#include "pctx.h"
+#include "rng.h"
+#include "io.h"
+#include "memstat.h"
 #include "fmt.h"
 
-// Horner evaluation: out = coeffs[0] + coeffs[1]*t + ... (degree < m)
-static void poly_eval(element_t out, element_t *coeffs, int m, element_t t, pairing_t pairing)
+// B_query lives in G2, A/C queries in G1: task = 3·column + which
+typedef struct {
+    element_t *val[3];   // A_j(τ), B_j(τ), C_j(τ)
+    element_t *query[3]; // outputs
+    const fb_table_t *t1, *t2;
+} query_job_t;
+
+static void query_task(int task, int worker, void *ctx)
+{
+    (void)worker;
+    query_job_t *job = (query_job_t *)ctx;
+    int j = task / 3, which = task % 3;
+    fb_pow(job->query[which][j], which == 1 ? job->t2 : job->t1, job->val[which][j]);
+}
+
+// Setup without the secret: query_j = Σ_i coef_i · g^{τ^i} over the
+// powers-of-tau file, one MSM per column and matrix. Used by --shard
+// and --update. Column polynomials come from the QAP cache when
+// `interpolate` already wrote one for this circuit.
+typedef struct {
+    ptau_t pt;
+    int m;
+    element_t g1, g2;           // g^{τ^0}
+    msm_src_t g1_pow, g2_pow;   // g^{τ^i}, i < m, streamed from the mapping
+                                // (column polys have degree < m)
+    element_t *tau_pts;
+    subprod_tree_t tree;        // cache misses only
+    qap_cache_t cache;
+    int cached;
+    pool_t *pool;
+    pairing_ptr pairing;
+} ptau_setup_t;
+
+static int setup_open(ptau_setup_t *s, const char *pot_path, const r1cs_t *r,
+                      pairing_t pairing)
 {
-    (void)pairing; // unused here but kept for consistent signature
-    element_set0(out);
-    for (int i = m - 1; i >= 0; i--)
+    int m = r->n_cons;
+    if (ptau_open(&s->pt, pot_path, pairing) != 0)
+        return -1;
+    if (s->pt.deg < m)
     {
-        element_mul(out, out, t);         // out = out * t
-        element_add(out, out, coeffs[i]); // out += coeffs[i]
+        fprintf(stderr, "Powers file has degree %d, need at least %d\n", s->pt.deg, m);
+        ptau_close(&s->pt);
+        return -1;
     }
+    s->m = m;
+    s->pairing = pairing;
+    element_init_G1(s->g1, pairing);
+    element_init_G2(s->g2, pairing);
+    ptau_get_g1(s->g1, &s->pt, 0);
+    ptau_get_g2(s->g2, &s->pt, 0);
+    s->g1_pow = (msm_src_t){s->pt.g1 + 4, s->pt.g1_stride};
+    s->g2_pow = (msm_src_t){s->pt.g2 + 4, s->pt.g2_stride};
+    s->tau_pts = poly_alloc(m, pairing);
+    for (int i = 0; i < m; i++)
+        element_set_si(s->tau_pts[i], i + 1);
+    s->cached = (qap_cache_open(&s->cache, r, pairing) == 0);
+    if (!s->cached)
+        subprod_tree_init(&s->tree, s->tau_pts, m, pairing);
+    fmt_kv_s("QAP cache", s->cached ? "hit" : "miss");
+    s->pool = pool_create(pool_default_threads());
+    return 0;
 }
 
-int main(int argc, char **argv)
+static void setup_close(ptau_setup_t *s)
+{
+    element_clear(s->g1);
+    element_clear(s->g2);
+    pool_destroy(s->pool);
+    if (s->cached)
+        qap_cache_close(&s->cache);
+    else
+        subprod_tree_clear(&s->tree);
+    poly_free(s->tau_pts, s->m);
+    ptau_close(&s->pt);
+}
+
+typedef struct {
+    element_t **poly[3]; // column coefficients for the current block
+    element_t *query[3]; // outputs
+    const msm_src_t *g1_pow, *g2_pow;
+    int m, off;          // off: output index of the block's first column
+} msm_job_t;
+
+static void msm_task(int task, int worker, void *ctx)
+{
+    (void)worker;
+    msm_job_t *job = (msm_job_t *)ctx;
+    int j = task / 3, which = task % 3;
+    msm_stream(job->query[which][job->off + j], which == 1 ? job->g2_pow : job->g1_pow,
+               job->poly[which][j], job->m);
+}
+
+// Aq/Bq/Cq[i] (initialized) ← queries of column cols[i]
+static void column_queries(ptau_setup_t *s, const r1cs_t *r, const int *cols, int ncols,
+                           element_t *Aq, element_t *Bq, element_t *Cq)
 {
-    if (argc < 5)
+    int m = s->m;
+    int block = 16 * pool_size(s->pool);
+    element_t **polyA = (element_t **)malloc(sizeof(element_t *) * block);
+    element_t **polyB = (element_t **)malloc(sizeof(element_t *) * block);
+    element_t **polyC = (element_t **)malloc(sizeof(element_t *) * block);
+    for (int b = 0; b < block; b++)
     {
-        fprintf(stderr, "Usage: %s pairing.params d x y a0…ad\n", argv[0]);
-        return 1;
+        polyA[b] = (element_t *)malloc(sizeof(element_t) * m);
+        polyB[b] = (element_t *)malloc(sizeof(element_t) * m);
+        polyC[b] = (element_t *)malloc(sizeof(element_t) * m);
     }
+    msm_job_t job = {.poly = {polyA, polyB, polyC}, .query = {Aq, Bq, Cq},
+                     .g1_pow = &s->g1_pow, .g2_pow = &s->g2_pow, .m = m};
+    for (int i0 = 0; i0 < ncols; i0 += block)
+    {
+        int nb = (ncols - i0 < block ? ncols - i0 : block);
+        if (s->cached)
+            for (int b = 0; b < nb; b++)
+            {
+                qap_cache_column(polyA[b], &s->cache, cols[i0 + b], 0, s->pairing);
+                qap_cache_column(polyB[b], &s->cache, cols[i0 + b], 1, s->pairing);
+                qap_cache_column(polyC[b], &s->cache, cols[i0 + b], 2, s->pairing);
+            }
+        else
+            qap_interp_column_list(s->pool, r, &s->tree, cols + i0, nb, polyA, polyB, polyC);
+        job.off = i0;
+        pool_for(s->pool, 3 * nb, msm_task, &job);
+        for (int b = 0; b < nb; b++)
+            for (int k = 0; k < m; k++)
+            {
+                element_clear(polyA[b][k]);
+                element_clear(polyB[b][k]);
+                element_clear(polyC[b][k]);
+            }
+    }
+    for (int b = 0; b < block; b++)
+    {
+        free(polyA[b]);
+        free(polyB[b]);
+        free(polyC[b]);
+    }
+    free(polyA);
+    free(polyB);
+    free(polyC);
+}
 
-    fmt_init(1, stdout);
-    fmt_banner("Key Generation (demo)");
-
-    // --- init pairing from params file ---
-    FILE *fp = fopen(argv[1], "r");
-    if (!fp)
+// vk->ic (allocated here) ← IC_i = C_query of the r->n_pub public wires,
+// the last columns; their A and B queries come along and are dropped
+static void public_queries(ptau_setup_t *s, const r1cs_t *r, vk_t *vk, pairing_t pairing)
+{
+    int l = r->n_pub, n = r->n_vars;
+    int *cols = (int *)calloc(l > 0 ? l : 1, sizeof(int));
+    element_t *Aq = (element_t *)malloc(sizeof(element_t) * (l > 0 ? l : 1));
+    element_t *Bq = (element_t *)malloc(sizeof(element_t) * (l > 0 ? l : 1));
+    vk->l = l;
+    vk->ic = (element_t *)malloc(sizeof(element_t) * (l > 0 ? l : 1));
+    for (int i = 0; i < l; i++)
     {
-        fprintf(stderr, "Error opening '%s': %s\n", argv[1], strerror(errno));
-        return 1;
+        cols[i] = n - l + i;
+        element_init_G1(Aq[i], pairing);
+        element_init_G2(Bq[i], pairing);
+        element_init_G1(vk->ic[i], pairing);
     }
-    fseek(fp, 0, SEEK_END);
-    long sz = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-    char *buf = (char *)malloc(sz + 1);
-    size_t rd = fread(buf, 1, sz, fp);
-    fclose(fp);
-    if (rd != (size_t)sz)
+    column_queries(s, r, cols, l, Aq, Bq, vk->ic);
+    for (int i = 0; i < l; i++)
     {
-        fprintf(stderr, "Short read: %zu of %ld\n", rd, sz);
-        free(buf);
-        return 1;
+        element_clear(Aq[i]);
+        element_clear(Bq[i]);
     }
-    buf[sz] = '\0';
-    pbc_param_t params;
-    pbc_param_init_set_buf(params, buf, sz + 1);
-    free(buf);
-    pairing_t pairing;
-    pairing_init_pbc_param(pairing, params);
+    free(Aq);
+    free(Bq);
+    free(cols);
+}
 
-    // --- parse inputs ---
-    int argi = 2;
+// argv = d x y a0…ad, --circuit file.cir name=value… or --r1cs file.r1cs file.wtns
+static int parse_circuit(int argc, char **argv, pairing_t pairing,
+                         r1cs_t *r, element_t **wires)
+{
+    if (argc >= 2 && strcmp(argv[0], "--circuit") == 0)
+    {
+        if (cb_load(argv[1], argc - 2, argv + 2, pairing, r, wires) != 0)
+            return -1;
+        r1cs_maybe_optimize(r, wires, pairing);
+        return 0;
+    }
+    if (argc >= 3 && strcmp(argv[0], "--r1cs") == 0)
+    {
+        if (r1cs_load_files(argv[1], argv[2], pairing, r, wires) != 0)
+            return -1;
+        r1cs_maybe_optimize(r, wires, pairing);
+        return 0;
+    }
+    if (argc < 4 || argc < 4 + atoi(argv[0]))
+    {
+        fprintf(stderr, "Expected d x y a0…ad, --circuit file.cir name=value… or "
+                        "--r1cs file.r1cs file.wtns\n");
+        return -1;
+    }
+    int argi = 0;
     int d = atoi(argv[argi++]);
-
     element_t x, y;
     element_init_Zr(x, pairing);
     element_init_Zr(y, pairing);
     element_set_str(x, argv[argi++], 10);
     element_set_str(y, argv[argi++], 10);
-
     element_t *coeffs = (element_t *)malloc((d + 1) * sizeof(element_t));
     for (int i = 0; i <= d; i++)
     {
         element_init_Zr(coeffs[i], pairing);
         element_set_str(coeffs[i], argv[argi++], 10);
     }
+    build_r1cs(d, coeffs, x, y, r, wires, pairing);
+    r1cs_maybe_optimize(r, wires, pairing);
+    for (int i = 0; i <= d; i++)
+        element_clear(coeffs[i]);
+    free(coeffs);
+    element_clear(x);
+    element_clear(y);
+    return 0;
+}
 
-    // --- R1CS and wires (for sizes & witness) ---
+static int keygen_shard(const char *spec, const char *pot_path, const char *out_path,
+                        int argc, char **argv)
+{
+    int si, sn;
+    if (sscanf(spec, "%d/%d", &si, &sn) != 2 || sn < 1 || si < 0 || si >= sn)
+    {
+        fprintf(stderr, "Bad shard spec '%s' (want i/N with 0 <= i < N)\n", spec);
+        return 1;
+    }
+    if (argc < 1)
+    {
+        fprintf(stderr, "Missing pairing.params d x y a0…ad\n");
+        return 1;
+    }
+
+    fmt_init(1, stdout);
+    fmt_banner("Key Generation (shard)");
+    memstat_stage("circuit");
+
+    pairing_t pairing;
     r1cs_t r;
     element_t *wires;
-    build_r1cs(d, coeffs, x, y, &r, &wires, pairing);
+    if (load_pairing(argv[0], pairing) != 0 ||
+        parse_circuit(argc - 1, argv + 1, pairing, &r, &wires) != 0)
+        return 1;
     int m = r.n_cons;
     int n = r.n_vars;
+    int lo = (int)((long long)n * si / sn);
+    int hi = (int)((long long)n * (si + 1) / sn);
+    int cnt = hi - lo;
+
+    ptau_setup_t st;
+    if (setup_open(&st, pot_path, &r, pairing) != 0)
+        return 1;
+    fmt_kv_s("shard", spec);
     fmt_kv_i("constraints (m)", m);
     fmt_kv_i("variables (n)", n);
+    fmt_kv_i("columns from", lo);
+    fmt_kv_i("columns to", hi);
+    fmt_kv_i("threads", pool_size(st.pool));
+
+    pk_t pk;
+    pk.n_vars = n;
+    pk.n_cons = m;
+    pk.lo = lo;
+    pk.hi = hi;
+    element_init_G1(pk.g1, pairing);
+    element_init_G2(pk.g2, pairing);
+    element_set(pk.g1, st.g1);
+    element_set(pk.g2, st.g2);
+    pk.A_query = (element_t *)malloc(sizeof(element_t) * (cnt > 0 ? cnt : 1));
+    pk.B_query = (element_t *)malloc(sizeof(element_t) * (cnt > 0 ? cnt : 1));
+    pk.C_query = (element_t *)malloc(sizeof(element_t) * (cnt > 0 ? cnt : 1));
+    pk.col_digest = (uint64_t *)malloc(sizeof(uint64_t) * (cnt > 0 ? cnt : 1));
+    pk.wires = (element_t *)malloc(sizeof(element_t) * (cnt > 0 ? cnt : 1));
+    int *cols = (int *)malloc(sizeof(int) * (cnt > 0 ? cnt : 1));
+    for (int j = 0; j < cnt; j++)
+    {
+        element_init_G1(pk.A_query[j], pairing);
+        element_init_G2(pk.B_query[j], pairing);
+        element_init_G1(pk.C_query[j], pairing);
+        element_init_Zr(pk.wires[j], pairing);
+        element_set(pk.wires[j], wires[lo + j]);
+        pk.col_digest[j] = keys_column_digest(&r, lo + j);
+        cols[j] = lo + j;
+    }
+
+    // --- column polynomials and an MSM per query ---
+    memstat_stage("queries");
+    column_queries(&st, &r, cols, cnt, pk.A_query, pk.B_query, pk.C_query);
+
+    // --- this shard's share of the aggregates ---
+    element_init_G1(pk.A_agg, pairing);
+    element_init_G2(pk.B_agg, pairing);
+    element_init_G1(pk.C_agg, pairing);
+    msm(pk.A_agg, pk.A_query, pk.wires, cnt);
+    msm(pk.B_agg, pk.B_query, pk.wires, cnt);
+    msm(pk.C_agg, pk.C_query, pk.wires, cnt);
+    fmt_sub("Partial aggregates");
+    fmt_kv_e("Σ w_j·A_query", pk.A_agg);
+    fmt_kv_e("Σ w_j·B_query", pk.B_agg);
+    fmt_kv_e("Σ w_j·C_query", pk.C_agg);
+
+    // --- verifier section (g2^{τ^0..τ^m} and IC) travels with the first shard ---
+    memstat_stage("g2 tail");
+    vk_t vk = {.l = 0, .ic = NULL};
+    vk.m = (lo == 0 ? m : 0);
+    vk.g2_tau = (element_t *)malloc(sizeof(element_t) * (m + 1));
+    for (int i = 0; vk.m > 0 && i <= m; i++)
+    {
+        element_init_G2(vk.g2_tau[i], pairing);
+        ptau_get_g2(vk.g2_tau[i], &st.pt, i);
+    }
+    element_init_G2(vk.g2, pairing);
+    element_init_G2(vk.g2_gamma, pairing);
+    element_set(vk.g2, pk.g2);
+    element_set(vk.g2_gamma, pk.g2);
+    if (vk.m > 0)
+    {
+        public_queries(&st, &r, &vk, pairing);
+        fmt_kv_i("public inputs", vk.l);
+    }
+
+    int rc = keys_write(out_path, &pk, &vk);
+    if (rc == 0)
+        fmt_kv_s("shard file", out_path);
+
+    keys_clear(&pk, &vk);
+    free(cols);
+    setup_close(&st);
+    // (r1cs matrices and wires clearing omitted in this demo)
+    return rc == 0 ? 0 : 1;
+}
+
+// Re-key after a circuit edit that keeps the shape (same n, m): only
+// columns whose digest changed get new queries; the aggregates are
+// patched by Σ (w'_j·Q'_j − w_j·Q_j) over columns whose query or wire moved.
+static int keygen_update(const char *old_path, const char *pot_path, const char *out_path,
+                         int argc, char **argv)
+{
+    if (argc < 1)
+    {
+        fprintf(stderr, "Missing pairing.params d x y a0…ad\n");
+        return 1;
+    }
+    fmt_init(1, stdout);
+    fmt_banner("Key Generation (update)");
+
+    pairing_t pairing;
+    if (load_pairing(argv[0], pairing) != 0)
+        return 1;
+    pk_t pk;
+    vk_t vk;
+    if (keys_read(old_path, &pk, &vk, pairing) != 0)
+        return 1;
+    if (!pk.col_digest)
+    {
+        fprintf(stderr, "'%s' has no circuit fingerprint; run a full keygen\n", old_path);
+        return 1;
+    }
+
+    r1cs_t r;
+    element_t *wires;
+    if (parse_circuit(argc - 1, argv + 1, pairing, &r, &wires) != 0)
+        return 1;
+    int m = r.n_cons, n = r.n_vars;
+    if (n != pk.n_vars || m != pk.n_cons)
+    {
+        fprintf(stderr, "Circuit shape changed (%dx%d -> %dx%d); run a full keygen\n",
+                pk.n_cons, pk.n_vars, m, n);
+        return 1;
+    }
+
+    ptau_setup_t st;
+    if (setup_open(&st, pot_path, &r, pairing) != 0)
+        return 1;
+    if (element_cmp(st.g1, pk.g1) || element_cmp(st.g2, pk.g2))
+    {
+        fprintf(stderr, "'%s' was not generated from '%s'\n", old_path, pot_path);
+        setup_close(&st);
+        return 1;
+    }
+
+    // --- diff: changed columns need new queries, changed wires new weights ---
+    int cnt = pk.hi - pk.lo;
+    int *cols = (int *)malloc(sizeof(int) * (cnt > 0 ? cnt : 1));
+    int *touched = (int *)malloc(sizeof(int) * (cnt > 0 ? cnt : 1));
+    int nc = 0, nt = 0;
+    for (int i = 0; i < cnt; i++)
+    {
+        int j = pk.lo + i;
+        uint64_t dg = keys_column_digest(&r, j);
+        int col_changed = (dg != pk.col_digest[i]);
+        if (col_changed)
+        {
+            cols[nc++] = j;
+            pk.col_digest[i] = dg;
+        }
+        if (col_changed || element_cmp(wires[j], pk.wires[i]))
+            touched[nt++] = i;
+    }
+    fmt_kv_i("columns", cnt);
+    fmt_kv_i("columns changed", nc);
+    fmt_kv_i("wires re-weighted", nt);
+    fmt_kv_i("threads", pool_size(st.pool));
+
+    // --- old contributions of touched columns (before anything moves) ---
+    element_t *base[3], *sc = (element_t *)malloc(sizeof(element_t) * (nt > 0 ? nt : 1));
+    element_t *q[3] = {pk.A_query, pk.B_query, pk.C_query};
+    element_ptr agg[3] = {pk.A_agg, pk.B_agg, pk.C_agg};
+    element_t part;
+    for (int w = 0; w < 3; w++)
+        base[w] = (element_t *)malloc(sizeof(element_t) * (nt > 0 ? nt : 1));
+    for (int t = 0; t < nt; t++)
+    {
+        element_init_Zr(sc[t], pairing);
+        element_neg(sc[t], pk.wires[touched[t]]);
+        for (int w = 0; w < 3; w++)
+        {
+            element_init_same_as(base[w][t], q[w][touched[t]]);
+            element_set(base[w][t], q[w][touched[t]]);
+        }
+    }
+    for (int w = 0; w < 3; w++)
+    {
+        element_init_same_as(part, agg[w]);
+        msm(part, base[w], sc, nt);
+        element_add(agg[w], agg[w], part);
+        element_clear(part);
+    }
+
+    // --- recompute changed queries in place ---
+    element_t *nq[3];
+    for (int w = 0; w < 3; w++)
+    {
+        nq[w] = (element_t *)malloc(sizeof(element_t) * (nc > 0 ? nc : 1));
+        for (int i = 0; i < nc; i++)
+            element_init_same_as(nq[w][i], q[w][0]);
+    }
+    column_queries(&st, &r, cols, nc, nq[0], nq[1], nq[2]);
+    for (int w = 0; w < 3; w++)
+    {
+        for (int i = 0; i < nc; i++)
+        {
+            element_set(q[w][cols[i] - pk.lo], nq[w][i]);
+            element_clear(nq[w][i]);
+        }
+        free(nq[w]);
+    }
+
+    // --- new contributions ---
+    for (int t = 0; t < nt; t++)
+    {
+        element_set(pk.wires[touched[t]], wires[pk.lo + touched[t]]);
+        element_set(sc[t], pk.wires[touched[t]]);
+        for (int w = 0; w < 3; w++)
+            element_set(base[w][t], q[w][touched[t]]);
+    }
+    for (int w = 0; w < 3; w++)
+    {
+        element_init_same_as(part, agg[w]);
+        msm(part, base[w], sc, nt);
+        element_add(agg[w], agg[w], part);
+        element_clear(part);
+    }
+    fmt_sub("Aggregates");
+    fmt_kv_e("Σ w_j·A_query", pk.A_agg);
+    fmt_kv_e("Σ w_j·B_query", pk.B_agg);
+    fmt_kv_e("Σ w_j·C_query", pk.C_agg);
+
+    // --- IC follows the public columns, which the edit may have touched ---
+    if (vk.m > 0)
+    {
+        for (int i = 0; i < vk.l; i++)
+            element_clear(vk.ic[i]);
+        free(vk.ic);
+        public_queries(&st, &r, &vk, pairing);
+    }
+
+    int rc = keys_write(out_path, &pk, &vk);
+    if (rc == 0)
+        fmt_kv_s("key file", out_path);
+
+    for (int t = 0; t < nt; t++)
+    {
+        element_clear(sc[t]);
+        for (int w = 0; w < 3; w++)
+            element_clear(base[w][t]);
+    }
+    for (int w = 0; w < 3; w++)
+        free(base[w]);
+    free(sc);
+    free(cols);
+    free(touched);
+    keys_clear(&pk, &vk);
+    setup_close(&st);
+    // (r1cs matrices and wires clearing omitted in this demo)
+    return rc == 0 ? 0 : 1;
+}
+
+static int keygen_merge(const char *params_path, const char *out_path,
+                        int ns, char **paths)
+{
+    fmt_init(1, stdout);
+    fmt_banner("Key Generation (merge)");
+
+    pairing_t pairing;
+    if (load_pairing(params_path, pairing) != 0)
+        return 1;
+
+    pk_t *pks = (pk_t *)malloc(sizeof(pk_t) * ns);
+    vk_t *vks = (vk_t *)malloc(sizeof(vk_t) * ns);
+    int loaded = 0, ok = 1;
+    for (; loaded < ns; loaded++)
+        if (keys_read(paths[loaded], &pks[loaded], &vks[loaded], pairing) != 0)
+        {
+            ok = 0;
+            break;
+        }
+
+    // order shards by first column (insertion sort on an index)
+    int *ord = (int *)malloc(sizeof(int) * ns);
+    for (int i = 0; i < ns; i++)
+        ord[i] = i;
+    for (int i = 1; ok && i < ns; i++)
+        for (int k = i; k > 0 && pks[ord[k]].lo < pks[ord[k - 1]].lo; k--)
+        {
+            int t = ord[k];
+            ord[k] = ord[k - 1];
+            ord[k - 1] = t;
+        }
+
+    // shards must agree on the circuit and bases and tile [0, n) exactly
+    int n = ok ? pks[0].n_vars : 0, at = 0, vk_from = -1;
+    for (int i = 0; ok && i < ns; i++)
+    {
+        pk_t *s = &pks[ord[i]];
+        if (s->n_vars != n || s->n_cons != pks[0].n_cons ||
+            element_cmp(s->g1, pks[0].g1) || element_cmp(s->g2, pks[0].g2))
+        {
+            fprintf(stderr, "Shard '%s' belongs to a different circuit or setup\n", paths[ord[i]]);
+            ok = 0;
+        }
+        else if (s->lo != at)
+        {
+            fprintf(stderr, "Columns %d..%d are %s\n", at, s->lo,
+                    s->lo > at ? "missing" : "covered twice");
+            ok = 0;
+        }
+        at = s->hi;
+        if (vks[ord[i]].m > 0)
+            vk_from = ord[i];
+    }
+    if (ok && at != n)
+    {
+        fprintf(stderr, "Columns %d..%d are missing\n", at, n);
+        ok = 0;
+    }
+    if (ok && vk_from < 0)
+    {
+        fprintf(stderr, "No shard carries the verifier powers (shard 0 missing?)\n");
+        ok = 0;
+    }
+
+    int rc = 1;
+    if (ok)
+    {
+        pk_t pk;
+        pk.n_vars = n;
+        pk.n_cons = pks[0].n_cons;
+        pk.lo = 0;
+        pk.hi = n;
+        element_init_same_as(pk.g1, pks[0].g1);
+        element_init_same_as(pk.g2, pks[0].g2);
+        element_set(pk.g1, pks[0].g1);
+        element_set(pk.g2, pks[0].g2);
+        pk.A_query = (element_t *)malloc(sizeof(element_t) * n);
+        pk.B_query = (element_t *)malloc(sizeof(element_t) * n);
+        pk.C_query = (element_t *)malloc(sizeof(element_t) * n);
+        element_init_G1(pk.A_agg, pairing);
+        element_init_G2(pk.B_agg, pairing);
+        element_init_G1(pk.C_agg, pairing);
+        element_set0(pk.A_agg);
+        element_set0(pk.B_agg);
+        element_set0(pk.C_agg);
+        int fp = 1;
+        for (int i = 0; i < ns; i++)
+            fp = fp && pks[i].col_digest != NULL;
+        pk.col_digest = fp ? (uint64_t *)malloc(sizeof(uint64_t) * n) : NULL;
+        pk.wires = fp ? (element_t *)malloc(sizeof(element_t) * n) : NULL;
+
+        for (int i = 0; i < ns; i++)
+        {
+            pk_t *s = &pks[ord[i]];
+            for (int j = s->lo; j < s->hi; j++)
+            {
+                element_init_G1(pk.A_query[j], pairing);
+                element_init_G2(pk.B_query[j], pairing);
+                element_init_G1(pk.C_query[j], pairing);
+                element_set(pk.A_query[j], s->A_query[j - s->lo]);
+                element_set(pk.B_query[j], s->B_query[j - s->lo]);
+                element_set(pk.C_query[j], s->C_query[j - s->lo]);
+                if (fp)
+                {
+                    pk.col_digest[j] = s->col_digest[j - s->lo];
+                    element_init_Zr(pk.wires[j], pairing);
+                    element_set(pk.wires[j], s->wires[j - s->lo]);
+                }
+            }
+            element_add(pk.A_agg, pk.A_agg, s->A_agg);
+            element_add(pk.B_agg, pk.B_agg, s->B_agg);
+            element_add(pk.C_agg, pk.C_agg, s->C_agg);
+        }
+
+        fmt_kv_i("shards", ns);
+        fmt_kv_i("constraints (m)", pk.n_cons);
+        fmt_kv_i("variables (n)", n);
+        fmt_sub("Aggregates");
+        fmt_kv_e("g1^{A(τ)}", pk.A_agg);
+        fmt_kv_e("g2^{B(τ)}", pk.B_agg);
+        fmt_kv_e("g1^{C(τ)}", pk.C_agg);
+
+        rc = keys_write(out_path, &pk, &vks[vk_from]);
+        if (rc == 0)
+            fmt_kv_s("key file", out_path);
+        keys_clear(&pk, NULL);
+    }
+
+    for (int i = 0; i < loaded; i++)
+        keys_clear(&pks[i], &vks[i]);
+    free(pks);
+    free(vks);
+    free(ord);
+    return rc == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    memstat_init();
+    if (argc > 1 && strcmp(argv[1], "--shard") == 0 && argc >= 5)
+        return keygen_shard(argv[2], argv[3], argv[4], argc - 5, argv + 5);
+    if (argc > 1 && strcmp(argv[1], "--update") == 0 && argc >= 5)
+        return keygen_update(argv[2], argv[3], argv[4], argc - 5, argv + 5);
+    if (argc > 1 && strcmp(argv[1], "--merge") == 0 && argc >= 5)
+        return keygen_merge(argv[2], argv[3], argc - 4, argv + 4);
+    // --dense: interpolate the materialized A/B/C instead of the implicit path
+    int dense = (argc > 1 && strcmp(argv[1], "--dense") == 0);
+    if (dense)
+    {
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+    // --circuit file.cir: compile a DSL circuit instead (always dense)
+    // --r1cs file.r1cs file.wtns: a saved constraint system and witness
+    const char *cir = NULL, *r1cs_path = NULL, *wtns_path = NULL;
+    if (argc > 2 && strcmp(argv[1], "--circuit") == 0)
+    {
+        cir = argv[2];
+        dense = 1;
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+    else if (argc > 3 && strcmp(argv[1], "--r1cs") == 0)
+    {
+        r1cs_path = argv[2];
+        wtns_path = argv[3];
+        dense = 1;
+        argv[3] = argv[0];
+        argv += 3;
+        argc -= 3;
+    }
+    int external = cir || r1cs_path;
+    if (argc < (external ? 2 : 5) || argv[1][0] == '-')
+    {
+        fprintf(stderr,
+                "Usage: %s [--dense] pairing.params d x y a0…ad\n"
+                "       %s --circuit file.cir pairing.params name=value…\n"
+                "       %s --r1cs file.r1cs file.wtns pairing.params\n"
+                "       %s --shard i/N pot.ptau out.shard pairing.params d x y a0…ad\n"
+                "       %s --merge pairing.params out.key shard…\n"
+                "       %s --update old.key pot.ptau new.key pairing.params d x y a0…ad\n"
+                "  (--shard and --update also take --circuit file.cir name=value… or\n"
+                "   --r1cs file.r1cs file.wtns in place of d x y a0…ad)\n",
+                argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+        return 1;
+    }
+
+    fmt_init(1, stdout);
+    fmt_banner("Key Generation (demo)");
+    if (rng_install() != 0)
+        return 1;
+
+    // --- init pairing, bases and fixed-base tables from params or a snapshot ---
+    memstat_stage("setup");
+    pairing_t pairing;
+    pctx_t ctx;
+    if (pctx_open(&ctx, argv[1], pairing) != 0)
+        return 1;
+    fmt_pairing(pairing);
+    fmt_kv_s("randomness", rng_source());
+
+    // --- parse inputs ---
+    int argi = 2, d = 0;
+    element_t x, y;
+    element_init_Zr(x, pairing);
+    element_init_Zr(y, pairing);
+    element_t *coeffs = NULL;
+    if (!external)
+    {
+        d = atoi(argv[argi++]);
+        element_set_str(x, argv[argi++], 10);
+        element_set_str(y, argv[argi++], 10);
+        coeffs = (element_t *)malloc((d + 1) * sizeof(element_t));
+        for (int i = 0; i <= d; i++)
+        {
+            element_init_Zr(coeffs[i], pairing);
+            element_set_str(coeffs[i], argv[argi++], 10);
+        }
+    }
+
+    pool_t *pool = pool_create(pool_default_threads());
+
+    // --- wires, plus the R1CS matrices only on the dense path ---
+    memstat_stage("circuit");
+    r1cs_t r;
+    element_t *wires;
+    int m, n;
+    r1cs_shape(d, &n, &m);
+    if (cir)
+    {
+        if (cb_load(cir, argc - 2, argv + 2, pairing, &r, &wires) != 0)
+            return 1;
+        fmt_kv_s("circuit", cir);
+    }
+    else if (r1cs_path)
+    {
+        if (r1cs_load_files(r1cs_path, wtns_path, pairing, &r, &wires) != 0)
+            return 1;
+        fmt_kv_s("circuit", r1cs_path);
+    }
+    else if (dense)
+        build_r1cs(d, coeffs, x, y, &r, &wires, pairing);
+    else
+    {
+        witness_build(pool, d, coeffs, x, &wires, pairing);
+        element_set(wires[r1cs_pub(d) + 1], y); // the claim, as build_r1cs does
+    }
+    int n_pub = CIRCUIT_N_PUB;
+    if (dense)
+    {
+        r1cs_maybe_optimize(&r, &wires, pairing);
+        m = r.n_cons;
+        n = r.n_vars;
+        n_pub = r.n_pub;
+    }
+    fmt_kv_i("constraints (m)", m);
+    fmt_kv_i("variables (n)", n);
+    fmt_kv_i("public inputs", n_pub);
+    fmt_kv_s("QAP path", dense ? "dense" : "implicit");
 
     // --- interpolation points: τ_k = 1..m ---
     element_t *tau_pts = (element_t *)malloc(sizeof(element_t) * m);
@@ -92,19 +791,15 @@ int main(int argc, char **argv)
         element_set_si(tau_pts[i], i + 1);
     }
 
-    // --- sample toxic waste τ and choose bases g1,g2 ---
+    // --- sample toxic waste τ (bases g1,g2 come from the context) ---
     element_t tau_secret;
     element_init_Zr(tau_secret, pairing);
     element_random(tau_secret);
     fmt_kv_e("tau", tau_secret);
 
-    element_t g1, g2;
-    element_init_G1(g1, pairing);
-    element_random(g1);
-    element_init_G2(g2, pairing);
-    element_random(g2);
-    fmt_kv_e("g1", g1);
-    fmt_kv_e("g2", g2);
+    fmt_kv_e("g1", ctx.g1);
+    fmt_kv_e("g2", ctx.g2);
+    fmt_kv_s("bases", ctx.snapshot ? "snapshot" : "random");
 
     // --- print g2^{tau^i} for i = 0..m-1 ---
     element_t tau_pow;
@@ -117,100 +812,94 @@ int main(int argc, char **argv)
     {
         if (i > 0)
             element_mul(tau_pow, tau_pow, tau_secret);
-        element_pow_zn(g2_pow, g2, tau_pow);
+        fb_pow(g2_pow, &ctx.t2, tau_pow);
         printf("  i=%d : ", i);
         element_printf("%B\n", g2_pow);
     }
 
-    // --- temp arrays for per-column interpolation ---
-    element_t *Ae = (element_t *)malloc(sizeof(element_t) * m);
-    element_t *Be = (element_t *)malloc(sizeof(element_t) * m);
-    element_t *Ce = (element_t *)malloc(sizeof(element_t) * m);
-
-    element_t *pA = (element_t *)malloc(sizeof(element_t) * m);
-    element_t *pB = (element_t *)malloc(sizeof(element_t) * m);
-    element_t *pC = (element_t *)malloc(sizeof(element_t) * m);
-
-    // --- accumulators for aggregates A(τ), B(τ), C(τ) ---
-    element_t Aagg, Bagg, Cagg;
-    element_init_Zr(Aagg, pairing);
-    element_set0(Aagg);
-    element_init_Zr(Bagg, pairing);
-    element_set0(Bagg);
-    element_init_Zr(Cagg, pairing);
-    element_set0(Cagg);
+    // --- per-variable query scalars: A_j(τ), B_j(τ), C_j(τ) ---
+    memstat_stage("columns");
+    fmt_kv_i("threads", pool_size(pool));
 
-    // --- per-variable query scalars and elements ---
-    element_t valA, valB, valC;
-    element_init_Zr(valA, pairing);
-    element_init_Zr(valB, pairing);
-    element_init_Zr(valC, pairing);
+    element_t *valA = (element_t *)malloc(sizeof(element_t) * n);
+    element_t *valB = (element_t *)malloc(sizeof(element_t) * n);
+    element_t *valC = (element_t *)malloc(sizeof(element_t) * n);
+    qap_cache_t cache;
+    if (dense && m <= POLY_SMALL)
+    {
+        // small domain: summed against L_k(τ), no tree or cached coefficients
+        qap_eval_columns(pool, &r, NULL, tau_secret, valA, valB, valC, pairing);
+    }
+    else if (dense && qap_cache_open(&cache, &r, pairing) == 0)
+    {
+        fmt_kv_s("QAP cache", "hit");
+        qap_cache_eval(pool, &cache, tau_secret, valA, valB, valC, pairing);
+        qap_cache_close(&cache);
+    }
+    else if (dense)
+    {
+        // subproduct tree over the domain (shared by every column)
+        subprod_tree_t tree;
+        subprod_tree_init(&tree, tau_pts, m, pairing);
+        qap_eval_columns(pool, &r, &tree, tau_secret, valA, valB, valC, pairing);
+        subprod_tree_clear(&tree);
+    }
+    else
+    {
+        element_t *L = (element_t *)malloc(sizeof(element_t) * m);
+        qap_lagrange_at(L, m, tau_secret, pairing);
+        eval_r1cs_columns(d, coeffs, L, valA, valB, valC, pairing);
+        poly_free(L, m);
+    }
 
-    element_t AqueryG1, BqueryG2, CqueryG1;
-    element_init_G1(AqueryG1, pairing);
-    element_init_G2(BqueryG2, pairing);
-    element_init_G1(CqueryG1, pairing);
+    // --- queries in the exponent ---
+    memstat_stage("queries");
+    element_t *AqueryG1 = (element_t *)malloc(sizeof(element_t) * n);
+    element_t *BqueryG2 = (element_t *)malloc(sizeof(element_t) * n);
+    element_t *CqueryG1 = (element_t *)malloc(sizeof(element_t) * n);
+    for (int j = 0; j < n; j++)
+    {
+        element_init_G1(AqueryG1[j], pairing);
+        element_init_G2(BqueryG2[j], pairing);
+        element_init_G1(CqueryG1[j], pairing);
+    }
+    query_job_t qjob = {.val = {valA, valB, valC},
+                        .query = {AqueryG1, BqueryG2, CqueryG1},
+                        .t1 = &ctx.t1, .t2 = &ctx.t2};
+    pool_for(pool, 3 * n, query_task, &qjob);
 
     fmt_sub("Per-variable queries");
     for (int j = 0; j < n; j++)
     {
-        // column j evaluations at the m points
-        for (int k = 0; k < m; k++)
-        {
-            element_init_Zr(Ae[k], pairing);
-            element_set(Ae[k], r.A[k][j]);
-            element_init_Zr(Be[k], pairing);
-            element_set(Be[k], r.B[k][j]);
-            element_init_Zr(Ce[k], pairing);
-            element_set(Ce[k], r.C[k][j]);
-        }
-        // interpolate coefficient vectors (degree < m)
-        lagrange_interpolation(pA, tau_pts, Ae, m, pairing);
-        lagrange_interpolation(pB, tau_pts, Be, m, pairing);
-        lagrange_interpolation(pC, tau_pts, Ce, m, pairing);
-
-        // evaluate at secret tau
-        poly_eval(valA, pA, m, tau_secret, pairing);
-        poly_eval(valB, pB, m, tau_secret, pairing);
-        poly_eval(valC, pC, m, tau_secret, pairing);
-
-        // queries in the exponent
-        element_pow_zn(AqueryG1, g1, valA);
-        element_pow_zn(BqueryG2, g2, valB);
-        element_pow_zn(CqueryG1, g1, valC);
-
-        // print
         printf("  var %d\n", j);
-        fmt_kv_e("    A_j(τ)", valA);
-        fmt_kv_e("    B_j(τ)", valB);
-        fmt_kv_e("    C_j(τ)", valC);
-        fmt_kv_e("    A_query[G1]", AqueryG1);
-        fmt_kv_e("    B_query[G2]", BqueryG2);
-        fmt_kv_e("    C_query[G1]", CqueryG1);
-
-        // aggregate: A(τ) += w_j * A_j(τ), etc.
-        element_t t;
-        element_init_Zr(t, pairing);
-        element_mul(t, wires[j], valA);
-        element_add(Aagg, Aagg, t);
-        element_mul(t, wires[j], valB);
-        element_add(Bagg, Bagg, t);
-        element_mul(t, wires[j], valC);
-        element_add(Cagg, Cagg, t);
-        element_clear(t);
-
-        // clear temporaries for this j
-        for (int k = 0; k < m; k++)
-        {
-            element_clear(Ae[k]);
-            element_clear(Be[k]);
-            element_clear(Ce[k]);
-            element_clear(pA[k]);
-            element_clear(pB[k]);
-            element_clear(pC[k]);
-        }
+        fmt_kv_e("    A_j(τ)", valA[j]);
+        fmt_kv_e("    B_j(τ)", valB[j]);
+        fmt_kv_e("    C_j(τ)", valC[j]);
+        fmt_kv_e("    A_query[G1]", AqueryG1[j]);
+        fmt_kv_e("    B_query[G2]", BqueryG2[j]);
+        fmt_kv_e("    C_query[G1]", CqueryG1[j]);
     }
 
+    // --- verifier-key query: IC_i = g1^{C_i(τ)} for the public wires (their
+    //     A and B columns are zero), so the verifier adds Σ x_i·IC_i itself;
+    //     key files carry it in their verifier section (--shard, --merge) ---
+    fmt_sub("Public-input query (IC)");
+    for (int i = 0; i < n_pub; i++)
+    {
+        printf("  input %d (wire %d)\n", i, n - n_pub + i);
+        fmt_kv_e("    IC[G1]", CqueryG1[n - n_pub + i]);
+    }
+
+    // --- aggregates A(τ) = Σ w_j·A_j(τ), etc. ---
+    memstat_stage("aggregates");
+    element_t Aagg, Bagg, Cagg;
+    element_init_Zr(Aagg, pairing);
+    element_init_Zr(Bagg, pairing);
+    element_init_Zr(Cagg, pairing);
+    qap_inner_product(pool, Aagg, wires, valA, n, pairing);
+    qap_inner_product(pool, Bagg, wires, valB, n, pairing);
+    qap_inner_product(pool, Cagg, wires, valC, n, pairing);
+
     fmt_hr();
     fmt_sub("Aggregate check (QAP divisibility)");
 
@@ -269,21 +958,26 @@ int main(int argc, char **argv)
     element_clear(Aagg);
     element_clear(Bagg);
     element_clear(Cagg);
-    element_clear(AqueryG1);
-    element_clear(BqueryG2);
-    element_clear(CqueryG1);
-    element_clear(valA);
-    element_clear(valB);
-    element_clear(valC);
+    for (int j = 0; j < n; j++)
+    {
+        element_clear(AqueryG1[j]);
+        element_clear(BqueryG2[j]);
+        element_clear(CqueryG1[j]);
+        element_clear(valA[j]);
+        element_clear(valB[j]);
+        element_clear(valC[j]);
+    }
+    free(AqueryG1);
+    free(BqueryG2);
+    free(CqueryG1);
+    free(valA);
+    free(valB);
+    free(valC);
+    pool_destroy(pool);
+    pctx_close(&ctx);
     for (int i = 0; i < m; i++)
         element_clear(tau_pts[i]);
     free(tau_pts);
-    free(Ae);
-    free(Be);
-    free(Ce);
-    free(pA);
-    free(pB);
-    free(pC);
     // (r1cs matrices and wires clearing omitted in this demo)
     return 0;
 }
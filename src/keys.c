@@ -0,0 +1,331 @@
+// src/keys.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pbc/pbc.h>
+#include "../include/keys.h"
+#include "../include/io.h"
+#include "../include/sha256.h"
+
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+static uint64_t fnv(uint64_t h, const unsigned char *p, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        h = (h ^ p[i]) * FNV_PRIME;
+    return h;
+}
+
+uint64_t keys_column_digest(const r1cs_t *r, int j)
+{
+    uint64_t h = FNV_OFFSET;
+    element_t **mats[3] = {r->A, r->B, r->C};
+    unsigned char buf[512];
+    for (int w = 0; w < 3; w++)
+        for (int k = 0; k < r->n_cons; k++)
+        {
+            element_ptr e = mats[w][k][j];
+            if (element_is0(e))
+                continue;
+            uint32_t tag[2] = {(uint32_t)w, (uint32_t)k};
+            h = fnv(h, (const unsigned char *)tag, sizeof tag);
+            int len = element_length_in_bytes(e);
+            unsigned char *p = len <= (int)sizeof buf ? buf : malloc(len);
+            element_to_bytes(p, e);
+            h = fnv(h, p, (size_t)len);
+            if (p != buf)
+                free(p);
+        }
+    return h;
+}
+
+int keys_write(const char *path, pk_t *pk, vk_t *vk)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f)
+    {
+        fprintf(stderr, "Error opening '%s' for write: %s\n", path, strerror(errno));
+        return -1;
+    }
+    int has_vk = (vk && vk->m > 0);
+    uint32_t flags = (has_vk ? KEYS_HAS_VK : 0) | (pk->col_digest ? KEYS_HAS_CIRCUIT : 0);
+    int cnt = pk->hi - pk->lo;
+    int err = write_exact(f, KEYS_MAGIC, 4) || write_u32(f, KEYS_VERSION) ||
+              write_u32(f, pk->n_vars) || write_u32(f, pk->n_cons) ||
+              write_u32(f, pk->lo) || write_u32(f, pk->hi) || write_u32(f, flags) ||
+              write_elem(f, pk->g1) || write_elem(f, pk->g2);
+    for (int j = 0; j < cnt && !err; j++)
+        err = write_elem(f, pk->A_query[j]);
+    for (int j = 0; j < cnt && !err; j++)
+        err = write_elem(f, pk->B_query[j]);
+    for (int j = 0; j < cnt && !err; j++)
+        err = write_elem(f, pk->C_query[j]);
+    if (!err)
+        err = write_elem(f, pk->A_agg) || write_elem(f, pk->B_agg) || write_elem(f, pk->C_agg);
+    for (int i = 0; has_vk && i <= vk->m && !err; i++)
+        err = write_elem(f, vk->g2_tau[i]);
+    if (has_vk && !err)
+        err = write_u32(f, (uint32_t)vk->l);
+    for (int i = 0; has_vk && i < vk->l && !err; i++)
+        err = write_elem(f, vk->ic[i]);
+    for (int j = 0; pk->col_digest && j < cnt && !err; j++)
+        err = write_u32(f, (uint32_t)(pk->col_digest[j] >> 32)) ||
+              write_u32(f, (uint32_t)pk->col_digest[j]) || write_elem(f, pk->wires[j]);
+    if (fclose(f) != 0)
+        err = 1;
+    if (err)
+        fprintf(stderr, "Error writing '%s'\n", path);
+    return err ? -1 : 0;
+}
+
+int keys_write_vk(const char *path, int n_vars, int n_cons, element_t g1, vk_t *vk)
+{
+    pk_t pk = {.n_vars = n_vars, .n_cons = n_cons, .lo = 0, .hi = 0};
+    element_init_same_as(pk.g1, g1);
+    element_init_same_as(pk.g2, vk->g2);
+    element_set(pk.g1, g1);
+    element_set(pk.g2, vk->g2);
+    element_init_same_as(pk.A_agg, g1);
+    element_init_same_as(pk.B_agg, vk->g2);
+    element_init_same_as(pk.C_agg, g1);
+    element_set0(pk.A_agg);
+    element_set0(pk.B_agg);
+    element_set0(pk.C_agg);
+    pk.A_query = pk.B_query = pk.C_query = NULL;
+    pk.col_digest = NULL;
+    pk.wires = NULL;
+    int rc = keys_write(path, &pk, vk);
+    keys_clear(&pk, NULL);
+    return rc;
+}
+
+static void id_u32(sha256_t *s, uint32_t v)
+{
+    unsigned char b[4] = {(unsigned char)(v >> 24), (unsigned char)(v >> 16),
+                          (unsigned char)(v >> 8), (unsigned char)v};
+    sha256_update(s, b, 4);
+}
+
+static void id_elem(sha256_t *s, element_t e)
+{
+    int len = element_length_in_bytes(e);
+    unsigned char *buf = malloc(len);
+    element_to_bytes(buf, e);
+    id_u32(s, (uint32_t)len);
+    sha256_update(s, buf, len);
+    free(buf);
+}
+
+void keys_vk_id(vk_t *vk, unsigned char id[32])
+{
+    sha256_t s;
+    sha256_init(&s);
+    id_elem(&s, vk->g2);
+    id_u32(&s, (uint32_t)vk->m);
+    for (int i = 0; i <= vk->m; i++)
+        id_elem(&s, vk->g2_tau[i]);
+    id_u32(&s, (uint32_t)vk->l);
+    for (int i = 0; i < vk->l; i++)
+        id_elem(&s, vk->ic[i]);
+    sha256_final(&s, id);
+}
+
+int keys_read(const char *path, pk_t *pk, vk_t *vk, pairing_t pairing)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        fprintf(stderr, "Error opening '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+    char magic[4];
+    uint32_t ver, n, m, lo, hi, flags;
+    if (read_exact(f, magic, 4) || memcmp(magic, KEYS_MAGIC, 4) != 0 ||
+        read_u32(f, &ver) || ver != KEYS_VERSION ||
+        read_u32(f, &n) || read_u32(f, &m) || read_u32(f, &lo) || read_u32(f, &hi) ||
+        read_u32(f, &flags) || lo > hi || hi > n)
+    {
+        fprintf(stderr, "Error: '%s' is not a key file\n", path);
+        fclose(f);
+        return -1;
+    }
+    int has_vk = (flags & KEYS_HAS_VK) != 0;
+    // g1, g2, the queries, the aggregates and g2^{τ^0..τ^m} must all be in
+    // the file before any of them is allocated
+    int len1 = pairing_length_in_bytes_G1(pairing), len2 = pairing_length_in_bytes_G2(pairing);
+    if (!io_fits(f, 5 + 3ULL * (hi - lo) + (has_vk ? m + 1ULL : 0), len1 < len2 ? len1 : len2))
+    {
+        fprintf(stderr, "Error: '%s' is truncated: its header counts more elements than it holds\n", path);
+        fclose(f);
+        return -1;
+    }
+    pk->n_vars = (int)n;
+    pk->n_cons = (int)m;
+    pk->lo = (int)lo;
+    pk->hi = (int)hi;
+    int cnt = (int)(hi - lo);
+
+    // initialize everything first so keys_clear is always safe
+    element_init_G1(pk->g1, pairing);
+    element_init_G2(pk->g2, pairing);
+    pk->A_query = malloc(sizeof(element_t) * (cnt > 0 ? cnt : 1));
+    pk->B_query = malloc(sizeof(element_t) * (cnt > 0 ? cnt : 1));
+    pk->C_query = malloc(sizeof(element_t) * (cnt > 0 ? cnt : 1));
+    for (int j = 0; j < cnt; j++)
+    {
+        element_init_G1(pk->A_query[j], pairing);
+        element_init_G2(pk->B_query[j], pairing);
+        element_init_G1(pk->C_query[j], pairing);
+    }
+    element_init_G1(pk->A_agg, pairing);
+    element_init_G2(pk->B_agg, pairing);
+    element_init_G1(pk->C_agg, pairing);
+    pk->col_digest = NULL;
+    pk->wires = NULL;
+    if (flags & KEYS_HAS_CIRCUIT)
+    {
+        pk->col_digest = calloc(cnt > 0 ? cnt : 1, sizeof(uint64_t));
+        pk->wires = malloc(sizeof(element_t) * (cnt > 0 ? cnt : 1));
+        for (int j = 0; j < cnt; j++)
+            element_init_Zr(pk->wires[j], pairing);
+    }
+    if (vk)
+    {
+        vk->m = has_vk ? (int)m : 0;
+        vk->g2_tau = malloc(sizeof(element_t) * ((size_t)m + 1));
+        for (uint32_t i = 0; has_vk && i <= m; i++)
+            element_init_G2(vk->g2_tau[i], pairing);
+        element_init_G2(vk->g2, pairing);
+        element_init_G2(vk->g2_gamma, pairing);
+        vk->l = 0;
+        vk->ic = NULL;
+    }
+
+    // framed elements: [len][bytes]
+    unsigned char *buf = NULL;
+    size_t cap = 0;
+    int err = 0;
+#define READ_INTO(e)                                              \
+    do                                                            \
+    {                                                             \
+        uint32_t len;                                             \
+        if (err || read_u32(f, &len)) { err = 1; break; }         \
+        if (len != (uint32_t)element_length_in_bytes(e))          \
+            { err = 1; break; } /* G1/G2 of other params */       \
+        if (len > cap) { cap = len; buf = realloc(buf, cap); }    \
+        if (read_exact(f, buf, len)) { err = 1; break; }          \
+        element_from_bytes((e), buf);                             \
+    } while (0)
+
+    READ_INTO(pk->g1);
+    READ_INTO(pk->g2);
+    for (int j = 0; j < cnt; j++)
+        READ_INTO(pk->A_query[j]);
+    for (int j = 0; j < cnt; j++)
+        READ_INTO(pk->B_query[j]);
+    for (int j = 0; j < cnt; j++)
+        READ_INTO(pk->C_query[j]);
+    READ_INTO(pk->A_agg);
+    READ_INTO(pk->B_agg);
+    READ_INTO(pk->C_agg);
+    if (has_vk)
+    {
+        for (uint32_t i = 0; i <= m; i++)
+        {
+            if (vk)
+                READ_INTO(vk->g2_tau[i]);
+            else
+            {
+                element_t skip;
+                element_init_G2(skip, pairing);
+                READ_INTO(skip);
+                element_clear(skip);
+            }
+        }
+        uint32_t l;
+        if (err || read_u32(f, &l) || l > n)
+            err = 1;
+        else if (vk)
+        {
+            vk->ic = malloc(sizeof(element_t) * (l > 0 ? l : 1));
+            for (; vk->l < (int)l; vk->l++)
+                element_init_G1(vk->ic[vk->l], pairing);
+            for (uint32_t i = 0; i < l; i++)
+                READ_INTO(vk->ic[i]);
+        }
+        else
+            for (uint32_t i = 0; i < l; i++)
+            {
+                element_t skip;
+                element_init_G1(skip, pairing);
+                READ_INTO(skip);
+                element_clear(skip);
+            }
+    }
+    for (int j = 0; pk->col_digest && j < cnt && !err; j++)
+    {
+        uint32_t dh, dl;
+        if (read_u32(f, &dh) || read_u32(f, &dl))
+        {
+            err = 1;
+            break;
+        }
+        pk->col_digest[j] = ((uint64_t)dh << 32) | dl;
+        READ_INTO(pk->wires[j]);
+    }
+#undef READ_INTO
+    free(buf);
+    fclose(f);
+
+    if (vk)
+    {
+        element_set(vk->g2, pk->g2);
+        element_set(vk->g2_gamma, pk->g2); // γ = 1 in this demo
+    }
+    if (err)
+    {
+        fprintf(stderr, "Error: '%s' is truncated or was made with other pairing params\n", path);
+        keys_clear(pk, vk);
+        return -1;
+    }
+    return 0;
+}
+
+void keys_clear(pk_t *pk, vk_t *vk)
+{
+    int cnt = pk->hi - pk->lo;
+    for (int j = 0; j < cnt; j++)
+    {
+        element_clear(pk->A_query[j]);
+        element_clear(pk->B_query[j]);
+        element_clear(pk->C_query[j]);
+    }
+    free(pk->A_query);
+    free(pk->B_query);
+    free(pk->C_query);
+    element_clear(pk->g1);
+    element_clear(pk->g2);
+    element_clear(pk->A_agg);
+    element_clear(pk->B_agg);
+    element_clear(pk->C_agg);
+    if (pk->col_digest)
+    {
+        for (int j = 0; j < cnt; j++)
+            element_clear(pk->wires[j]);
+        free(pk->wires);
+        free(pk->col_digest);
+    }
+    if (vk)
+    {
+        for (int i = 0; vk->m > 0 && i <= vk->m; i++)
+            element_clear(vk->g2_tau[i]);
+        free(vk->g2_tau);
+        element_clear(vk->g2);
+        element_clear(vk->g2_gamma);
+        for (int i = 0; i < vk->l; i++)
+            element_clear(vk->ic[i]);
+        free(vk->ic);
+    }
+}
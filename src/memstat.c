@@ -0,0 +1,266 @@
+// src/memstat.c
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <gmp.h>
+#include <pbc/pbc.h>
+#include "../include/memstat.h"
+
+// header in front of every counted block; keeps max_align_t alignment
+typedef union {
+    struct {
+        size_t size;
+        int stage;
+    } h;
+    max_align_t align;
+} hdr_t;
+
+typedef struct {
+    const char *name;
+    long long live, peak, allocs, frees, bytes;
+} stage_t;
+
+static stage_t stages[MEMSTAT_STAGES];
+static int n_stages, cur, enabled;
+static long long live_all, peak_all;
+static int peak_stage; // stage current at the global high-water mark
+static long page_size;
+
+static void raise_peak(long long *peak, long long v, int *who, int stage)
+{
+    long long p = __atomic_load_n(peak, __ATOMIC_RELAXED);
+    while (v > p)
+        if (__atomic_compare_exchange_n(peak, &p, v, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            if (who)
+                __atomic_store_n(who, stage, __ATOMIC_RELAXED);
+            break;
+        }
+}
+
+static void account(int s, size_t n, int sign)
+{
+    stage_t *st = &stages[s];
+    long long d = sign * (long long)n;
+    long long v = __atomic_add_fetch(&st->live, d, __ATOMIC_RELAXED);
+    long long all = __atomic_add_fetch(&live_all, d, __ATOMIC_RELAXED);
+    if (sign > 0)
+    {
+        __atomic_add_fetch(&st->allocs, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&st->bytes, (long long)n, __ATOMIC_RELAXED);
+        raise_peak(&st->peak, v, NULL, s);
+        raise_peak(&peak_all, all, &peak_stage, s);
+    }
+    else
+        __atomic_add_fetch(&st->frees, 1, __ATOMIC_RELAXED);
+}
+
+static void *ms_malloc(size_t n)
+{
+    hdr_t *h = malloc(sizeof(hdr_t) + n);
+    if (!h)
+        return NULL;
+    h->h.size = n;
+    h->h.stage = __atomic_load_n(&cur, __ATOMIC_RELAXED);
+    account(h->h.stage, n, 1);
+    return h + 1;
+}
+
+static void ms_free(void *p)
+{
+    if (!p)
+        return;
+    hdr_t *h = (hdr_t *)p - 1;
+    account(h->h.stage, h->h.size, -1);
+    free(h);
+}
+
+// a resize counts as a free in the old stage and an allocation in the current one
+static void *ms_realloc(void *p, size_t n)
+{
+    if (!p)
+        return ms_malloc(n);
+    hdr_t *h = (hdr_t *)p - 1;
+    size_t old = h->h.size;
+    int s = h->h.stage;
+    h = realloc(h, sizeof(hdr_t) + n);
+    if (!h)
+        return NULL;
+    account(s, old, -1);
+    h->h.size = n;
+    h->h.stage = __atomic_load_n(&cur, __ATOMIC_RELAXED);
+    account(h->h.stage, n, 1);
+    return h + 1;
+}
+
+static void *gmp_realloc(void *p, size_t old, size_t n)
+{
+    (void)old;
+    return ms_realloc(p, n);
+}
+
+static void gmp_free(void *p, size_t n)
+{
+    (void)n;
+    ms_free(p);
+}
+
+// --- async-signal-safe text output ---
+
+typedef struct {
+    char b[4096];
+    size_t n;
+} out_t;
+
+static void put_s(out_t *o, const char *s, int width)
+{
+    int k = 0;
+    for (; s[k] && o->n < sizeof o->b; k++)
+        o->b[o->n++] = s[k];
+    for (; k < width && o->n < sizeof o->b; k++)
+        o->b[o->n++] = ' ';
+}
+
+static void put_i(out_t *o, long long v, int width)
+{
+    char d[24];
+    int k = 0, neg = v < 0;
+    unsigned long long u = neg ? 0ULL - (unsigned long long)v : (unsigned long long)v;
+    do
+        d[k++] = (char)('0' + u % 10);
+    while ((u /= 10) > 0);
+    if (neg)
+        d[k++] = '-';
+    for (int pad = width - k; pad > 0 && o->n < sizeof o->b; pad--)
+        o->b[o->n++] = ' ';
+    while (k > 0 && o->n < sizeof o->b)
+        o->b[o->n++] = d[--k];
+}
+
+// resident set size in kB from /proc/self/statm, -1 if unavailable
+static long long rss_kb(void)
+{
+    int fd = open("/proc/self/statm", O_RDONLY);
+    if (fd < 0)
+        return -1;
+    char b[128];
+    ssize_t n = read(fd, b, sizeof b - 1);
+    close(fd);
+    if (n <= 0)
+        return -1;
+    b[n] = 0;
+    long long pages = 0;
+    char *p = b;
+    while (*p && *p != ' ') // skip total size
+        p++;
+    while (*p == ' ')
+        p++;
+    for (; *p >= '0' && *p <= '9'; p++)
+        pages = pages * 10 + (*p - '0');
+    return pages * (page_size / 1024);
+}
+
+void memstat_dump(int fd)
+{
+    if (!enabled)
+        return;
+    static const int w[6] = {18, 12, 12, 14, 14, 16};
+    static const char *head[6] = {"stage", "allocs", "frees", "live B", "peak B", "total B"};
+    out_t o = {.n = 0};
+    put_s(&o, "\n== memory (GROTH16_MEMSTAT) ==\n", 0);
+    put_s(&o, head[0], w[0]);
+    for (int c = 1; c < 6; c++)
+    {
+        int k = (int)strlen(head[c]);
+        put_s(&o, "", w[c] - k);
+        put_s(&o, head[c], 0);
+    }
+    put_s(&o, "\n", 0);
+    int n = __atomic_load_n(&n_stages, __ATOMIC_ACQUIRE);
+    for (int s = 0; s < n; s++)
+    {
+        stage_t *st = &stages[s];
+        put_s(&o, st->name, w[0]);
+        put_i(&o, __atomic_load_n(&st->allocs, __ATOMIC_RELAXED), w[1]);
+        put_i(&o, __atomic_load_n(&st->frees, __ATOMIC_RELAXED), w[2]);
+        put_i(&o, __atomic_load_n(&st->live, __ATOMIC_RELAXED), w[3]);
+        put_i(&o, __atomic_load_n(&st->peak, __ATOMIC_RELAXED), w[4]);
+        put_i(&o, __atomic_load_n(&st->bytes, __ATOMIC_RELAXED), w[5]);
+        put_s(&o, "\n", 0);
+    }
+    put_s(&o, "tracked live B     ", 0);
+    put_i(&o, __atomic_load_n(&live_all, __ATOMIC_RELAXED), 0);
+    put_s(&o, ", peak B ", 0);
+    put_i(&o, __atomic_load_n(&peak_all, __ATOMIC_RELAXED), 0);
+    put_s(&o, " (during ", 0);
+    put_s(&o, stages[__atomic_load_n(&peak_stage, __ATOMIC_RELAXED)].name, 0);
+    put_s(&o, ")\n", 0);
+    struct rusage ru;
+    put_s(&o, "RSS kB             current ", 0);
+    put_i(&o, rss_kb(), 0);
+    put_s(&o, ", peak ", 0);
+    put_i(&o, getrusage(RUSAGE_SELF, &ru) == 0 ? ru.ru_maxrss : -1, 0);
+    put_s(&o, "\n", 0);
+    for (size_t off = 0; off < o.n;)
+    {
+        ssize_t k = write(fd, o.b + off, o.n - off);
+        if (k <= 0)
+            break;
+        off += (size_t)k;
+    }
+}
+
+static void on_exit_dump(void)
+{
+    memstat_dump(2);
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    memstat_dump(2);
+}
+
+void memstat_init(void)
+{
+    const char *env = getenv("GROTH16_MEMSTAT");
+    if (enabled || !env || !*env || strcmp(env, "0") == 0)
+        return;
+    page_size = sysconf(_SC_PAGESIZE);
+    stages[0].name = "startup";
+    n_stages = 1;
+    mp_set_memory_functions(ms_malloc, gmp_realloc, gmp_free);
+    pbc_set_memory_functions(ms_malloc, ms_realloc, ms_free);
+    enabled = 1;
+    atexit(on_exit_dump);
+    struct sigaction sa;
+    memset(&sa, 0, sizeof sa);
+    sa.sa_handler = on_signal;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, NULL);
+}
+
+void memstat_stage(const char *name)
+{
+    if (!enabled)
+        return;
+    int s = 0;
+    while (s < n_stages && strcmp(stages[s].name, name) != 0)
+        s++;
+    if (s == n_stages)
+    {
+        if (s == MEMSTAT_STAGES)
+            s = MEMSTAT_STAGES - 1; // overflow shares the last slot
+        else
+        {
+            stages[s].name = name;
+            __atomic_store_n(&n_stages, s + 1, __ATOMIC_RELEASE);
+        }
+    }
+    __atomic_store_n(&cur, s, __ATOMIC_RELAXED);
+}
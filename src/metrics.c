@@ -0,0 +1,366 @@
+// src/metrics.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "../include/metrics.h"
+
+// log-linear buckets: values below SUB get one bucket each, then every
+// power of two [2^e, 2^{e+1}) is split into SUB equal sub-buckets
+#define SUB_BITS 3
+#define SUB (1 << SUB_BITS)
+#define BUCKETS ((64 - SUB_BITS + 1) * SUB)
+// exported histogram bounds: 2^k ns for k in [LE_LO, LE_HI] (1 µs … 69 s)
+#define LE_LO 10
+#define LE_HI 36
+
+typedef struct {
+    long long count[BUCKETS];
+    long long n, sum, max; // sum and max in ns
+} hist_t;
+
+static const char *phase_name[METRICS_PHASES] = {
+    "decode", "witness", "qap", "msm", "pairing", "serialize", "request"};
+
+static hist_t hist[METRICS_PHASES];
+static long long counters[METRICS_COUNTERS], depth;
+static int enabled;
+static const char *prog;
+static uint64_t t_start;
+static const char *file_path; // file mode
+static char sock_path[108];   // unix: mode, removed at exit
+static int listen_fd = -1;
+
+static int bucket(uint64_t v)
+{
+    if (v < SUB)
+        return (int)v;
+    int e = 63 - __builtin_clzll(v);
+    return (e - SUB_BITS + 1) * SUB + (int)((v >> (e - SUB_BITS)) & (SUB - 1));
+}
+
+// one past the largest value that lands in bucket b
+static double bucket_end(int b)
+{
+    int k = b / SUB, s = b % SUB;
+    return k == 0 ? s + 1 : (double)(SUB + s + 1) * (double)(1ULL << (k - 1));
+}
+
+uint64_t metrics_now(void)
+{
+    if (!enabled)
+        return 0;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void metrics_record(int phase, uint64_t ns, int n)
+{
+    if (!enabled || n <= 0)
+        return;
+    hist_t *h = &hist[phase];
+    __atomic_add_fetch(&h->count[bucket(ns)], n, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&h->n, n, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&h->sum, (long long)ns * n, __ATOMIC_RELAXED);
+    long long m = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+    while ((long long)ns > m &&
+           !__atomic_compare_exchange_n(&h->max, &m, (long long)ns, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        ;
+}
+
+void metrics_since(int phase, uint64_t t0)
+{
+    if (enabled)
+        metrics_record(phase, metrics_now() - t0, 1);
+}
+
+void metrics_add(int counter, long long v)
+{
+    if (enabled)
+        __atomic_add_fetch(&counters[counter], v, __ATOMIC_RELAXED);
+}
+
+void metrics_queue(long long v)
+{
+    if (enabled)
+        __atomic_store_n(&depth, v, __ATOMIC_RELAXED);
+}
+
+void metrics_queue_add(long long delta)
+{
+    if (enabled)
+        __atomic_add_fetch(&depth, delta, __ATOMIC_RELAXED);
+}
+
+// smallest bucket end covering a fraction q of the samples, capped at the max
+static double quantile(const hist_t *h, long long n, double q)
+{
+    long long want = (long long)(q * (double)n), seen = 0;
+    if (want < q * (double)n)
+        want++;
+    double mx = (double)__atomic_load_n(&h->max, __ATOMIC_RELAXED);
+    for (int b = 0; b < BUCKETS; b++)
+    {
+        seen += __atomic_load_n(&h->count[b], __ATOMIC_RELAXED);
+        if (seen >= want)
+            return bucket_end(b) - 1 < mx ? bucket_end(b) - 1 : mx;
+    }
+    return mx;
+}
+
+static void snapshot(FILE *f)
+{
+    static const double qs[4] = {0.5, 0.9, 0.99, 0.999};
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    double up = ((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec - t_start) * 1e-9;
+
+    fprintf(f, "# HELP groth16_phase_seconds Latency of one phase of a request.\n"
+               "# TYPE groth16_phase_seconds histogram\n");
+    for (int p = 0; p < METRICS_PHASES; p++)
+    {
+        const hist_t *h = &hist[p];
+        long long n = __atomic_load_n(&h->n, __ATOMIC_RELAXED);
+        if (n == 0)
+            continue;
+        // bucket boundaries fall on powers of two, so these counts are exact
+        long long cum = 0;
+        int b = 0;
+        for (int k = LE_LO; k <= LE_HI; k++)
+        {
+            for (; b < bucket(1ULL << k); b++)
+                cum += __atomic_load_n(&h->count[b], __ATOMIC_RELAXED);
+            fprintf(f, "groth16_phase_seconds_bucket{prog=\"%s\",phase=\"%s\",le=\"%.9g\"} %lld\n",
+                    prog, phase_name[p], (double)(1ULL << k) * 1e-9, cum);
+        }
+        fprintf(f, "groth16_phase_seconds_bucket{prog=\"%s\",phase=\"%s\",le=\"+Inf\"} %lld\n",
+                prog, phase_name[p], n);
+        fprintf(f, "groth16_phase_seconds_sum{prog=\"%s\",phase=\"%s\"} %.9f\n",
+                prog, phase_name[p], __atomic_load_n(&h->sum, __ATOMIC_RELAXED) * 1e-9);
+        fprintf(f, "groth16_phase_seconds_count{prog=\"%s\",phase=\"%s\"} %lld\n", prog, phase_name[p], n);
+    }
+
+    fprintf(f, "# HELP groth16_phase_quantile_seconds Latency quantiles from the fine buckets (within 12.5%%).\n"
+               "# TYPE groth16_phase_quantile_seconds gauge\n");
+    for (int p = 0; p < METRICS_PHASES; p++)
+    {
+        long long n = __atomic_load_n(&hist[p].n, __ATOMIC_RELAXED);
+        for (int i = 0; i < 4 && n > 0; i++)
+            fprintf(f, "groth16_phase_quantile_seconds{prog=\"%s\",phase=\"%s\",quantile=\"%g\"} %.9f\n",
+                    prog, phase_name[p], qs[i], quantile(&hist[p], n, qs[i]) * 1e-9);
+        if (n > 0)
+            fprintf(f, "groth16_phase_quantile_seconds{prog=\"%s\",phase=\"%s\",quantile=\"1\"} %.9f\n",
+                    prog, phase_name[p], __atomic_load_n(&hist[p].max, __ATOMIC_RELAXED) * 1e-9);
+    }
+
+    static const char *cname[METRICS_COUNTERS] = {"requests", "accepted", "rejected", "bytes"};
+    static const char *chelp[METRICS_COUNTERS] = {
+        "Proofs made or checked.", "Proofs written or accepted.",
+        "Instances without a proof, or proofs rejected.", "Proof bytes written or read."};
+    for (int c = 0; c < METRICS_COUNTERS; c++)
+        fprintf(f, "# HELP groth16_%s_total %s\n# TYPE groth16_%s_total counter\ngroth16_%s_total{prog=\"%s\"} %lld\n",
+                cname[c], chelp[c], cname[c], cname[c], prog, __atomic_load_n(&counters[c], __ATOMIC_RELAXED));
+
+    long long req = __atomic_load_n(&counters[METRICS_REQUESTS], __ATOMIC_RELAXED);
+    fprintf(f, "# HELP groth16_queue_depth Instances of the current batch or bundle still to go.\n"
+               "# TYPE groth16_queue_depth gauge\ngroth16_queue_depth{prog=\"%s\"} %lld\n",
+            prog, __atomic_load_n(&depth, __ATOMIC_RELAXED));
+    fprintf(f, "# HELP groth16_uptime_seconds Time since start.\n"
+               "# TYPE groth16_uptime_seconds gauge\ngroth16_uptime_seconds{prog=\"%s\"} %.3f\n", prog, up);
+    fprintf(f, "# HELP groth16_requests_per_second Requests over uptime.\n"
+               "# TYPE groth16_requests_per_second gauge\ngroth16_requests_per_second{prog=\"%s\"} %.3f\n",
+            prog, up > 0 ? req / up : 0.0);
+}
+
+static void write_all(int fd, const char *p, size_t n)
+{
+    while (n > 0)
+    {
+        ssize_t k = send(fd, p, n, MSG_NOSIGNAL);
+        if (k < 0 && errno == ENOTSOCK)
+            k = write(fd, p, n);
+        if (k < 0 && errno == EINTR)
+            continue;
+        if (k <= 0)
+            return;
+        p += k;
+        n -= (size_t)k;
+    }
+}
+
+void metrics_dump(int fd)
+{
+    if (!enabled)
+        return;
+    char *buf = NULL;
+    size_t len = 0;
+    FILE *f = open_memstream(&buf, &len);
+    if (!f)
+        return;
+    snapshot(f);
+    fclose(f);
+    write_all(fd, buf, len);
+    free(buf);
+}
+
+// file mode: a complete snapshot replaces the old one atomically
+static void dump_file(void)
+{
+    char tmp[4096];
+    if (snprintf(tmp, sizeof tmp, "%s.tmp", file_path) >= (int)sizeof tmp)
+        return;
+    FILE *f = fopen(tmp, "w");
+    if (!f)
+    {
+        fprintf(stderr, "metrics: cannot write '%s': %s\n", tmp, strerror(errno));
+        return;
+    }
+    snapshot(f);
+    if (fclose(f) != 0 || rename(tmp, file_path) != 0)
+        fprintf(stderr, "metrics: cannot write '%s': %s\n", file_path, strerror(errno));
+}
+
+static void on_exit_metrics(void)
+{
+    if (file_path)
+        dump_file();
+    if (sock_path[0])
+        unlink(sock_path);
+}
+
+// SIGUSR2 is blocked in every thread and taken here, so the dump runs in
+// ordinary thread context
+static void *signal_thread(void *arg)
+{
+    sigset_t *set = (sigset_t *)arg;
+    for (int sig; sigwait(set, &sig) == 0;)
+        dump_file();
+    return NULL;
+}
+
+// one snapshot per connection; an HTTP GET gets a response header first
+static void *serve_thread(void *arg)
+{
+    (void)arg;
+    for (;;)
+    {
+        int c = accept(listen_fd, NULL, NULL);
+        if (c < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            return NULL;
+        }
+        char req[1024];
+        ssize_t k = 0;
+        struct pollfd pfd = {.fd = c, .events = POLLIN};
+        if (poll(&pfd, 1, 100) > 0)
+            k = recv(c, req, sizeof req, 0);
+        char *buf = NULL;
+        size_t len = 0;
+        FILE *f = open_memstream(&buf, &len);
+        if (f)
+        {
+            snapshot(f);
+            fclose(f);
+            if (k >= 4 && (memcmp(req, "GET ", 4) == 0 || memcmp(req, "HEAD", 4) == 0))
+            {
+                char head[160];
+                int h = snprintf(head, sizeof head,
+                                 "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                                 "Content-Length: %zu\r\nConnection: close\r\n\r\n", len);
+                write_all(c, head, (size_t)h);
+                if (memcmp(req, "GET ", 4) == 0)
+                    write_all(c, buf, len);
+            }
+            else
+                write_all(c, buf, len);
+            free(buf);
+        }
+        close(c);
+    }
+}
+
+static int listen_on(const char *spec)
+{
+    int fd;
+    if (strncmp(spec, "unix:", 5) == 0)
+    {
+        struct sockaddr_un a = {.sun_family = AF_UNIX};
+        if (strlen(spec + 5) >= sizeof a.sun_path)
+            return -1;
+        strcpy(a.sun_path, spec + 5);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(a.sun_path);
+        if (fd < 0 || bind(fd, (struct sockaddr *)&a, sizeof a) != 0)
+            goto fail;
+        strcpy(sock_path, a.sun_path);
+    }
+    else
+    {
+        int port = atoi(spec + 4), one = 1;
+        struct sockaddr_in a = {.sin_family = AF_INET, .sin_port = htons((uint16_t)port)};
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (port <= 0 || port > 65535)
+            return -1;
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0)
+            return -1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+        if (bind(fd, (struct sockaddr *)&a, sizeof a) != 0)
+            goto fail;
+    }
+    if (listen(fd, 16) == 0)
+        return fd;
+fail:
+    if (fd >= 0)
+        close(fd);
+    return -1;
+}
+
+void metrics_init(const char *name)
+{
+    const char *env = getenv("GROTH16_METRICS");
+    if (enabled || !env || !*env || strcmp(env, "0") == 0)
+        return;
+    prog = name;
+    enabled = 1;
+    t_start = metrics_now();
+    pthread_t th;
+    if (strncmp(env, "unix:", 5) == 0 || strncmp(env, "tcp:", 4) == 0)
+    {
+        listen_fd = listen_on(env);
+        if (listen_fd < 0 || pthread_create(&th, NULL, serve_thread, NULL) != 0)
+        {
+            fprintf(stderr, "metrics: cannot serve on '%s': %s\n", env, strerror(errno));
+            enabled = 0;
+            return;
+        }
+    }
+    else
+    {
+        file_path = env;
+        static sigset_t set;
+        sigemptyset(&set);
+        sigaddset(&set, SIGUSR2);
+        pthread_sigmask(SIG_BLOCK, &set, NULL);
+        if (pthread_create(&th, NULL, signal_thread, &set) != 0)
+        {
+            pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+            atexit(on_exit_metrics);
+            return;
+        }
+    }
+    pthread_detach(th);
+    atexit(on_exit_metrics);
+}
@@ -0,0 +1,354 @@
+// src/msm.c
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <gmp.h>
+#include <pbc/pbc.h>
+#include "../include/msm.h"
+
+// below this many terms plain exponentiation is cheaper than bucket setup
+#define MSM_NAIVE 8
+
+static int window_bits(int n)
+{
+    int lg = 0;
+    while ((1 << (lg + 1)) <= n)
+        lg++;
+    int c = lg - 2;
+    if (c < 2)
+        c = 2;
+    if (c > 16)
+        c = 16;
+    return c;
+}
+
+/**
+ * Bucket additions of one window, queued and applied together with
+ * element_multi_add. PBC keeps curve points affine, so every element_add
+ * pays a field inversion; multi_add shares one inversion across the batch
+ * (Montgomery's trick). A bucket is queued at most once per batch, and an
+ * addition to a bucket already queued waits in a deferred list for the
+ * next batch. Identity bases are skipped and empty buckets take the base
+ * by copy; P + P and P + (−P), which multi_add does not special-case, go
+ * through element_add.
+ */
+#define MSM_BATCH 128
+
+typedef struct {
+    int n, nd;
+    element_t *bucket;     // the window's buckets
+    unsigned char *queued; // per bucket
+    int slot[MSM_BATCH];   // bucket of each queued addition
+    element_t acc[MSM_BATCH], add[MSM_BATCH], sum[MSM_BATCH];
+    int dslot[MSM_BATCH];  // deferred additions
+    element_t def[MSM_BATCH];
+    element_t neg;
+} batch_t;
+
+static void batch_init(batch_t *bt, element_t *bucket, int nb, element_t like)
+{
+    bt->n = bt->nd = 0;
+    bt->bucket = bucket;
+    bt->queued = calloc(nb, 1);
+    for (int j = 0; j < MSM_BATCH; j++)
+    {
+        element_init_same_as(bt->acc[j], like);
+        element_init_same_as(bt->add[j], like);
+        element_init_same_as(bt->sum[j], like);
+        element_init_same_as(bt->def[j], like);
+    }
+    element_init_same_as(bt->neg, like);
+}
+
+static void batch_clear(batch_t *bt)
+{
+    for (int j = 0; j < MSM_BATCH; j++)
+    {
+        element_clear(bt->acc[j]);
+        element_clear(bt->add[j]);
+        element_clear(bt->sum[j]);
+        element_clear(bt->def[j]);
+    }
+    element_clear(bt->neg);
+    free(bt->queued);
+}
+
+// apply the queued additions
+static void batch_apply(batch_t *bt)
+{
+    int g = 0; // generic pairs, compacted to the front
+    for (int j = 0; j < bt->n; j++)
+    {
+        int s = bt->slot[j];
+        bt->queued[s] = 0;
+        element_neg(bt->neg, bt->add[j]);
+        if (!element_cmp(bt->acc[j], bt->add[j]) || !element_cmp(bt->acc[j], bt->neg))
+        {
+            element_add(bt->bucket[s], bt->bucket[s], bt->add[j]);
+            continue;
+        }
+        if (g != j)
+        {
+            element_set(bt->acc[g], bt->acc[j]);
+            element_set(bt->add[g], bt->add[j]);
+            bt->slot[g] = s;
+        }
+        g++;
+    }
+    if (g > 0)
+        element_multi_add(bt->sum, bt->acc, bt->add, g);
+    for (int j = 0; j < g; j++)
+        element_set(bt->bucket[bt->slot[j]], bt->sum[j]);
+    bt->n = 0;
+}
+
+// queue bucket[s] += base; returns 0 if s is already queued
+static int batch_enqueue(batch_t *bt, int s, element_t base)
+{
+    if (bt->queued[s])
+        return 0;
+    if (element_is0(bt->bucket[s]))
+    {
+        element_set(bt->bucket[s], base);
+        return 1;
+    }
+    element_set(bt->acc[bt->n], bt->bucket[s]);
+    element_set(bt->add[bt->n], base);
+    bt->slot[bt->n++] = s;
+    bt->queued[s] = 1;
+    if (bt->n == MSM_BATCH)
+        batch_apply(bt);
+    return 1;
+}
+
+// retry the deferred additions; ones that collide again stay deferred
+static void batch_retry(batch_t *bt)
+{
+    int kept = 0;
+    for (int j = 0; j < bt->nd; j++)
+        if (!batch_enqueue(bt, bt->dslot[j], bt->def[j]))
+        {
+            if (kept != j)
+                element_set(bt->def[kept], bt->def[j]);
+            bt->dslot[kept++] = bt->dslot[j];
+        }
+    bt->nd = kept;
+}
+
+// apply everything pending (end of a window)
+static void batch_flush(batch_t *bt)
+{
+    while (bt->n > 0 || bt->nd > 0)
+    {
+        batch_apply(bt);
+        batch_retry(bt);
+    }
+}
+
+// bucket[s] += base, possibly deferred to a later batch
+static void batch_push(batch_t *bt, int s, element_t base)
+{
+    if (element_is0(base) || batch_enqueue(bt, s, base))
+        return;
+    if (bt->nd == MSM_BATCH)
+    {
+        batch_apply(bt);
+        batch_retry(bt);
+        if (batch_enqueue(bt, s, base))
+            return;
+    }
+    element_set(bt->def[bt->nd], base);
+    bt->dslot[bt->nd++] = s;
+}
+
+void msm(element_t out, element_t *bases, element_t *scalars, int n)
+{
+    element_set0(out); // identity
+    if (n <= 0)
+        return;
+
+    element_t t;
+    element_init_same_as(t, out);
+    if (n < MSM_NAIVE)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            element_pow_zn(t, bases[i], scalars[i]);
+            element_add(out, out, t);
+        }
+        element_clear(t);
+        return;
+    }
+
+    int c = window_bits(n);
+    int nb = (1 << c) - 1; // bucket b holds digit b+1
+    int bits = (int)mpz_sizeinbase(scalars[0]->field->order, 2);
+    int windows = (bits + c - 1) / c;
+
+    mpz_t *k = malloc(sizeof(mpz_t) * n);
+    for (int i = 0; i < n; i++)
+    {
+        mpz_init(k[i]);
+        element_to_mpz(k[i], scalars[i]);
+    }
+    element_t *bucket = malloc(sizeof(element_t) * nb);
+    for (int b = 0; b < nb; b++)
+        element_init_same_as(bucket[b], out);
+    element_t running, wsum;
+    element_init_same_as(running, out);
+    element_init_same_as(wsum, out);
+    batch_t bt;
+    batch_init(&bt, bucket, nb, out);
+
+    for (int w = windows - 1; w >= 0; w--)
+    {
+        // out ← 2^c · out
+        for (int s = 0; s < c; s++)
+            element_double(out, out);
+
+        for (int b = 0; b < nb; b++)
+            element_set0(bucket[b]);
+        for (int i = 0; i < n; i++)
+        {
+            int digit = 0;
+            for (int s = c - 1; s >= 0; s--)
+                digit = (digit << 1) | mpz_tstbit(k[i], (mp_bitcnt_t)(w * c + s));
+            if (digit)
+                batch_push(&bt, digit - 1, bases[i]);
+        }
+        batch_flush(&bt);
+
+        // Σ_b (b+1)·bucket[b] via running suffix sums
+        element_set0(running);
+        element_set0(wsum);
+        for (int b = nb - 1; b >= 0; b--)
+        {
+            element_add(running, running, bucket[b]);
+            element_add(wsum, wsum, running);
+        }
+        element_add(out, out, wsum);
+    }
+
+    batch_clear(&bt);
+    element_clear(running);
+    element_clear(wsum);
+    for (int b = 0; b < nb; b++)
+        element_clear(bucket[b]);
+    free(bucket);
+    for (int i = 0; i < n; i++)
+        mpz_clear(k[i]);
+    free(k);
+    element_clear(t);
+}
+
+// best effort: the range need not be page-aligned or mapped
+static void advise(const unsigned char *p, size_t len, int advice)
+{
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t a = (uintptr_t)p & ~(page - 1);
+    (void)madvise((void *)a, len + ((uintptr_t)p - a), advice);
+}
+
+void msm_stream(element_t out, const msm_src_t *src, element_t *scalars, int n)
+{
+    element_set0(out); // identity
+    if (n <= 0)
+        return;
+
+    element_t base, t;
+    element_init_same_as(base, out);
+    element_init_same_as(t, out);
+    if (n < MSM_NAIVE)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            element_from_bytes(base, (unsigned char *)src->data + (size_t)i * src->stride);
+            element_pow_zn(t, base, scalars[i]);
+            element_add(out, out, t);
+        }
+        element_clear(base);
+        element_clear(t);
+        return;
+    }
+
+    int c = window_bits(n);
+    if (c > MSM_STREAM_MAX_C)
+        c = MSM_STREAM_MAX_C;
+    int nb = (1 << c) - 1; // bucket[w·nb + b] holds digit b+1 of window w
+    int bits = (int)mpz_sizeinbase(scalars[0]->field->order, 2);
+    int windows = (bits + c - 1) / c;
+    element_t *bucket = malloc(sizeof(element_t) * (size_t)windows * nb);
+    for (size_t b = 0; b < (size_t)windows * nb; b++)
+    {
+        element_init_same_as(bucket[b], out);
+        element_set0(bucket[b]);
+    }
+
+    batch_t *bt = malloc(sizeof(batch_t) * windows);
+    for (int w = 0; w < windows; w++)
+        batch_init(&bt[w], bucket + (size_t)w * nb, nb, out);
+
+    // one pass over the bases, prefetching a chunk ahead
+    mpz_t k;
+    mpz_init(k);
+    advise(src->data, (size_t)n * src->stride, MADV_SEQUENTIAL);
+    for (int i0 = 0; i0 < n; i0 += MSM_STREAM_CHUNK)
+    {
+        int i1 = (n - i0 < MSM_STREAM_CHUNK ? n : i0 + MSM_STREAM_CHUNK);
+        if (i1 < n)
+        {
+            int next = (n - i1 < MSM_STREAM_CHUNK ? n - i1 : MSM_STREAM_CHUNK);
+            advise(src->data + (size_t)i1 * src->stride, (size_t)next * src->stride,
+                   MADV_WILLNEED);
+        }
+        for (int i = i0; i < i1; i++)
+        {
+            element_to_mpz(k, scalars[i]);
+            if (mpz_sgn(k) == 0)
+                continue;
+            element_from_bytes(base, (unsigned char *)src->data + (size_t)i * src->stride);
+            for (int w = 0; w < windows; w++)
+            {
+                int digit = 0;
+                for (int s = c - 1; s >= 0; s--)
+                    digit = (digit << 1) | mpz_tstbit(k, (mp_bitcnt_t)(w * c + s));
+                if (digit)
+                    batch_push(&bt[w], digit - 1, base);
+            }
+        }
+    }
+    mpz_clear(k);
+    for (int w = 0; w < windows; w++)
+    {
+        batch_flush(&bt[w]);
+        batch_clear(&bt[w]);
+    }
+    free(bt);
+
+    // fold the windows from the top, as in msm
+    element_t running, wsum;
+    element_init_same_as(running, out);
+    element_init_same_as(wsum, out);
+    for (int w = windows - 1; w >= 0; w--)
+    {
+        for (int s = 0; s < c; s++)
+            element_double(out, out);
+        element_set0(running);
+        element_set0(wsum);
+        for (int b = nb - 1; b >= 0; b--)
+        {
+            element_add(running, running, bucket[(size_t)w * nb + b]);
+            element_add(wsum, wsum, running);
+        }
+        element_add(out, out, wsum);
+    }
+
+    element_clear(running);
+    element_clear(wsum);
+    for (size_t b = 0; b < (size_t)windows * nb; b++)
+        element_clear(bucket[b]);
+    free(bucket);
+    element_clear(base);
+    element_clear(t);
+}
@@ -0,0 +1,202 @@
+// src/pctx.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <gmp.h>
+#include <pbc/pbc.h>
+#include "../include/pctx.h"
+
+static int fb_windows(pairing_t pairing)
+{
+    return (int)((mpz_sizeinbase(pairing->r, 2) + FB_WINDOW - 1) / FB_WINDOW);
+}
+
+static void fb_alloc(fb_table_t *t, element_t like, pairing_t pairing)
+{
+    t->windows = fb_windows(pairing);
+    t->t = malloc(sizeof(element_t) * t->windows * FB_DIGITS);
+    for (int i = 0; i < t->windows * FB_DIGITS; i++)
+        element_init_same_as(t->t[i], like);
+}
+
+// Row i is cur_i^k (k = 1..FB_DIGITS) with cur_i = base^{2^{FB_WINDOW·i}}.
+// The cur_i come from doublings; then column k of every row is one batched
+// addition (cur_i^{k-1}·cur_i for all i), so the table costs FB_DIGITS
+// shared inversions instead of one per entry.
+void fb_table_init(fb_table_t *t, element_t base, pairing_t pairing)
+{
+    fb_alloc(t, base, pairing);
+    int n = t->windows;
+    element_t *cur = malloc(sizeof(element_t) * n);
+    element_t *prev = malloc(sizeof(element_t) * n);
+    element_t *next = malloc(sizeof(element_t) * n);
+    for (int i = 0; i < n; i++)
+    {
+        element_init_same_as(cur[i], base);
+        element_init_same_as(prev[i], base);
+        element_init_same_as(next[i], base);
+        if (i == 0)
+            element_set(cur[i], base);
+        else
+        {
+            element_set(cur[i], cur[i - 1]);
+            for (int b = 0; b < FB_WINDOW; b++)
+                element_double(cur[i], cur[i]);
+        }
+        element_set(t->t[(size_t)i * FB_DIGITS], cur[i]);
+    }
+    // k = 2 is a doubling; for k ≥ 3, cur^{k-1} ≠ cur^{±1} unless base is
+    // the identity, which multi_add does not handle
+    if (!element_is0(base))
+    {
+        element_multi_double(prev, cur, n);
+        for (int k = 1; k < FB_DIGITS; k++)
+        {
+            if (k > 1)
+                element_multi_add(next, prev, cur, n);
+            for (int i = 0; i < n; i++)
+            {
+                if (k > 1)
+                    element_set(prev[i], next[i]);
+                element_set(t->t[(size_t)i * FB_DIGITS + k], prev[i]);
+            }
+        }
+    }
+    else
+        for (int i = 0; i < n * FB_DIGITS; i++)
+            element_set0(t->t[i]);
+    for (int i = 0; i < n; i++)
+    {
+        element_clear(cur[i]);
+        element_clear(prev[i]);
+        element_clear(next[i]);
+    }
+    free(cur);
+    free(prev);
+    free(next);
+}
+
+void fb_table_clear(fb_table_t *t)
+{
+    for (int i = 0; i < t->windows * FB_DIGITS; i++)
+        element_clear(t->t[i]);
+    free(t->t);
+}
+
+void fb_pow(element_t out, const fb_table_t *t, element_t e)
+{
+    mpz_t z;
+    mpz_init(z);
+    element_to_mpz(z, e);
+    element_set1(out);
+    for (int i = 0; i < t->windows; i++)
+    {
+        int digit = 0;
+        for (int b = 0; b < FB_WINDOW; b++)
+            digit |= mpz_tstbit(z, (mp_bitcnt_t)(i * FB_WINDOW + b)) << b;
+        if (digit)
+            element_mul(out, out, t->t[(size_t)i * FB_DIGITS + digit - 1]);
+    }
+    mpz_clear(z);
+}
+
+// next framed element of a mapped snapshot into e (initialized)
+static int take_elem(element_t e, const unsigned char **p, const unsigned char *end)
+{
+    if (end - *p < 4)
+        return -1;
+    uint32_t len = io_get_u32(*p);
+    if (len != (uint32_t)element_length_in_bytes(e) || (size_t)(end - *p - 4) < len)
+        return -1;
+    element_from_bytes(e, (unsigned char *)*p + 4);
+    *p += 4 + len;
+    return 0;
+}
+
+static int load_snapshot(pctx_t *c, const char *path, pairing_t pairing)
+{
+    io_map_t map;
+    if (io_map_open(&map, path) != 0)
+        return -1;
+    const unsigned char *p = map.base + 12 + io_get_u32(map.base + 8);
+    const unsigned char *end = map.base + map.size;
+    int err = (p > end);
+    if (!err)
+        err = take_elem(c->g1, &p, end) || take_elem(c->g2, &p, end);
+    fb_alloc(&c->t1, c->g1, pairing);
+    fb_alloc(&c->t2, c->g2, pairing);
+    for (int i = 0; i < c->t1.windows * FB_DIGITS && !err; i++)
+        err = take_elem(c->t1.t[i], &p, end);
+    for (int i = 0; i < c->t2.windows * FB_DIGITS && !err; i++)
+        err = take_elem(c->t2.t[i], &p, end);
+    io_map_close(&map);
+    if (err || p != end)
+    {
+        fprintf(stderr, "Error: snapshot '%s' is truncated or inconsistent\n", path);
+        fb_table_clear(&c->t1);
+        fb_table_clear(&c->t2);
+        return -1;
+    }
+    return 0;
+}
+
+int pctx_open(pctx_t *c, const char *path, pairing_t pairing)
+{
+    if (load_pairing(path, pairing) != 0)
+        return -1;
+    element_init_G1(c->g1, pairing);
+    element_init_G2(c->g2, pairing);
+    c->snapshot = io_is_snapshot(path);
+    if (c->snapshot)
+    {
+        if (load_snapshot(c, path, pairing) != 0)
+        {
+            element_clear(c->g1);
+            element_clear(c->g2);
+            return -1;
+        }
+        return 0;
+    }
+    element_random(c->g1);
+    element_random(c->g2);
+    fb_table_init(&c->t1, c->g1, pairing);
+    fb_table_init(&c->t2, c->g2, pairing);
+    return 0;
+}
+
+void pctx_close(pctx_t *c)
+{
+    fb_table_clear(&c->t1);
+    fb_table_clear(&c->t2);
+    element_clear(c->g1);
+    element_clear(c->g2);
+}
+
+int pctx_write(const char *out_path, const char *params_path, pctx_t *c)
+{
+    size_t plen;
+    char *text = io_read_params(params_path, &plen);
+    if (!text)
+        return -1;
+    FILE *f = fopen(out_path, "wb");
+    if (!f)
+    {
+        fprintf(stderr, "Error opening '%s' for write: %s\n", out_path, strerror(errno));
+        free(text);
+        return -1;
+    }
+    int err = write_exact(f, PCTX_MAGIC, 4) || write_u32(f, PCTX_VERSION) ||
+              write_u32(f, (uint32_t)plen) || write_exact(f, text, plen) ||
+              write_elem(f, c->g1) || write_elem(f, c->g2);
+    for (int i = 0; i < c->t1.windows * FB_DIGITS && !err; i++)
+        err = write_elem(f, c->t1.t[i]);
+    for (int i = 0; i < c->t2.windows * FB_DIGITS && !err; i++)
+        err = write_elem(f, c->t2.t[i]);
+    if (fclose(f) != 0)
+        err = 1;
+    free(text);
+    if (err)
+        fprintf(stderr, "Error writing '%s'\n", out_path);
+    return err ? -1 : 0;
+}
@@ -1,8 +1,14 @@
 // src/poly.c
 #include <pbc/pbc.h>
 #include <stdlib.h>
+#include <gmp.h>
 #include "../include/poly.h"
 
+// below this many coefficients schoolbook beats the recursive methods
+#define POLY_MUL_CUTOFF 32
+// quotients shorter than this use plain long division
+#define POLY_DIV_CUTOFF 32
+
 void lagrange_interpolation(element_t *out, element_t *tau, element_t *eval,
                             int m, pairing_t pairing)
 {
@@ -106,3 +112,430 @@ void lagrange_interpolation(element_t *out, element_t *tau, element_t *eval,
     free(basis);
     free(nb);
 }
+
+void poly_eval(element_t out, element_t *coeffs, int m, element_t t)
+{
+    if (m <= 0)
+    {
+        element_set0(out);
+        return;
+    }
+    element_set(out, coeffs[m - 1]);
+    for (int i = m - 2; i >= 0; i--)
+    {
+        element_mul(out, out, t);         // out = out * t
+        element_add(out, out, coeffs[i]); // out += coeffs[i]
+    }
+}
+
+element_t *poly_alloc(int n, pairing_t pairing)
+{
+    element_t *p = malloc(sizeof(element_t) * (n > 0 ? n : 1));
+    for (int i = 0; i < n; i++)
+    {
+        element_init_Zr(p[i], pairing);
+        element_set0(p[i]);
+    }
+    return p;
+}
+
+void poly_free(element_t *p, int n)
+{
+    for (int i = 0; i < n; i++)
+        element_clear(p[i]);
+    free(p);
+}
+
+// ---- NTT support -------------------------------------------------------
+// r − 1 = 2^s · t. If s is large enough we multiply through a radix-2 NTT
+// of size ≤ 2^s; the root is cached per modulus. The cache is filled the
+// first time a large product is requested, so build any subproduct tree
+// before fanning work out to threads.
+
+static mpz_t ntt_mod;  // modulus the cache belongs to
+static mpz_t ntt_root; // primitive 2^ntt_s-th root of unity
+static int ntt_s = -1;
+
+static void ntt_setup(pairing_t pairing)
+{
+    if (ntt_s >= 0 && mpz_cmp(ntt_mod, pairing->r) == 0)
+        return;
+    if (ntt_s < 0)
+    {
+        mpz_init(ntt_mod);
+        mpz_init(ntt_root);
+    }
+    mpz_set(ntt_mod, pairing->r);
+
+    mpz_t t, e, g, half;
+    mpz_inits(t, e, g, half, NULL);
+    mpz_sub_ui(t, pairing->r, 1);
+    int s = (int)mpz_scan1(t, 0);
+    mpz_tdiv_q_2exp(t, t, s); // odd part
+    mpz_sub_ui(half, pairing->r, 1);
+    mpz_tdiv_q_2exp(half, half, 1);
+
+    // smallest quadratic non-residue g, so g^t has order exactly 2^s
+    for (mpz_set_ui(g, 2);; mpz_add_ui(g, g, 1))
+    {
+        mpz_powm(e, g, half, pairing->r);
+        if (mpz_cmp_ui(e, 1) != 0)
+            break;
+    }
+    mpz_powm(ntt_root, g, t, pairing->r);
+    ntt_s = s;
+    mpz_clears(t, e, g, half, NULL);
+}
+
+// in-place NTT of length N (power of two) with primitive N-th root w
+static void ntt(element_t *v, int N, element_t w, pairing_t pairing)
+{
+    element_t tmp, u;
+    element_init_Zr(tmp, pairing);
+    element_init_Zr(u, pairing);
+
+    // bit-reversal permutation
+    for (int i = 1, j = 0; i < N; i++)
+    {
+        int bit = N >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j)
+        {
+            element_set(tmp, v[i]);
+            element_set(v[i], v[j]);
+            element_set(v[j], tmp);
+        }
+    }
+
+    // twiddles w^0 .. w^{N/2-1}
+    int half = N / 2;
+    element_t *tw = poly_alloc(half, pairing);
+    element_set1(tw[0]);
+    for (int i = 1; i < half; i++)
+        element_mul(tw[i], tw[i - 1], w);
+
+    for (int len = 2; len <= N; len <<= 1)
+    {
+        int h = len / 2, step = N / len;
+        for (int i = 0; i < N; i += len)
+        {
+            for (int j = 0; j < h; j++)
+            {
+                element_mul(tmp, v[i + j + h], tw[j * step]);
+                element_set(u, v[i + j]);
+                element_add(v[i + j], u, tmp);
+                element_sub(v[i + j + h], u, tmp);
+            }
+        }
+    }
+
+    poly_free(tw, half);
+    element_clear(tmp);
+    element_clear(u);
+}
+
+static void mul_ntt(element_t *res, element_t *a, int na, element_t *b, int nb,
+                    int N, int logN, pairing_t pairing)
+{
+    element_t w, winv, ninv;
+    element_init_Zr(w, pairing);
+    element_init_Zr(winv, pairing);
+    element_init_Zr(ninv, pairing);
+
+    mpz_t e;
+    mpz_init_set_ui(e, 1);
+    mpz_mul_2exp(e, e, ntt_s - logN);
+    element_set_mpz(w, ntt_root);
+    element_pow_mpz(w, w, e); // primitive N-th root
+    mpz_clear(e);
+    element_invert(winv, w);
+    element_set_si(ninv, N);
+    element_invert(ninv, ninv);
+
+    element_t *fa = poly_alloc(N, pairing);
+    element_t *fb = poly_alloc(N, pairing);
+    for (int i = 0; i < na; i++)
+        element_set(fa[i], a[i]);
+    for (int i = 0; i < nb; i++)
+        element_set(fb[i], b[i]);
+
+    ntt(fa, N, w, pairing);
+    ntt(fb, N, w, pairing);
+    for (int i = 0; i < N; i++)
+        element_mul(fa[i], fa[i], fb[i]);
+    ntt(fa, N, winv, pairing);
+
+    for (int i = 0; i < na + nb - 1; i++)
+        element_mul(res[i], fa[i], ninv);
+
+    poly_free(fa, N);
+    poly_free(fb, N);
+    element_clear(w);
+    element_clear(winv);
+    element_clear(ninv);
+}
+
+// ---- schoolbook / Karatsuba ---------------------------------------------
+
+// res[0..na+nb-2] += a·b (res must not alias a, b)
+static void mul_school_acc(element_t *res, element_t *a, int na, element_t *b, int nb,
+                           pairing_t pairing)
+{
+    element_t t;
+    element_init_Zr(t, pairing);
+    for (int i = 0; i < na; i++)
+    {
+        if (element_is0(a[i]))
+            continue;
+        for (int j = 0; j < nb; j++)
+        {
+            element_mul(t, a[i], b[j]);
+            element_add(res[i + j], res[i + j], t);
+        }
+    }
+    element_clear(t);
+}
+
+// res[0..2n-2] = a·b for two length-n operands (res zeroed, no aliasing)
+static void mul_kara(element_t *res, element_t *a, element_t *b, int n, pairing_t pairing)
+{
+    if (n <= POLY_MUL_CUTOFF)
+    {
+        mul_school_acc(res, a, n, b, n, pairing);
+        return;
+    }
+    int lo = n / 2, hi = n - lo;
+
+    // z0 = a_lo·b_lo, z2 = a_hi·b_hi, z1 = (a_lo+a_hi)(b_lo+b_hi) − z0 − z2
+    element_t *z0 = poly_alloc(2 * lo - 1, pairing);
+    element_t *z2 = poly_alloc(2 * hi - 1, pairing);
+    element_t *z1 = poly_alloc(2 * hi - 1, pairing);
+    element_t *sa = poly_alloc(hi, pairing);
+    element_t *sb = poly_alloc(hi, pairing);
+
+    mul_kara(z0, a, b, lo, pairing);
+    mul_kara(z2, a + lo, b + lo, hi, pairing);
+    for (int i = 0; i < hi; i++)
+    {
+        element_set(sa[i], a[lo + i]);
+        element_set(sb[i], b[lo + i]);
+        if (i < lo)
+        {
+            element_add(sa[i], sa[i], a[i]);
+            element_add(sb[i], sb[i], b[i]);
+        }
+    }
+    mul_kara(z1, sa, sb, hi, pairing);
+    for (int i = 0; i < 2 * hi - 1; i++)
+    {
+        element_sub(z1[i], z1[i], z2[i]);
+        if (i < 2 * lo - 1)
+            element_sub(z1[i], z1[i], z0[i]);
+    }
+
+    for (int i = 0; i < 2 * lo - 1; i++)
+        element_add(res[i], res[i], z0[i]);
+    for (int i = 0; i < 2 * hi - 1; i++)
+    {
+        element_add(res[lo + i], res[lo + i], z1[i]);
+        element_add(res[2 * lo + i], res[2 * lo + i], z2[i]);
+    }
+
+    poly_free(z0, 2 * lo - 1);
+    poly_free(z1, 2 * hi - 1);
+    poly_free(z2, 2 * hi - 1);
+    poly_free(sa, hi);
+    poly_free(sb, hi);
+}
+
+void poly_mul(element_t *res, element_t *a, int na, element_t *b, int nb,
+              pairing_t pairing)
+{
+    if (na <= 0 || nb <= 0)
+        return;
+    int nr = na + nb - 1;
+    int small = (na < nb ? na : nb);
+
+    if (small > POLY_MUL_CUTOFF)
+    {
+        int N = 1, logN = 0;
+        while (N < nr)
+        {
+            N <<= 1;
+            logN++;
+        }
+        ntt_setup(pairing);
+        if (logN <= ntt_s)
+        {
+            mul_ntt(res, a, na, b, nb, N, logN, pairing);
+            return;
+        }
+    }
+
+    element_t *tmp;
+    if (small <= POLY_MUL_CUTOFF)
+    {
+        tmp = poly_alloc(nr, pairing);
+        mul_school_acc(tmp, a, na, b, nb, pairing);
+    }
+    else
+    {
+        // pad both operands to a common length for Karatsuba
+        int n = (na > nb ? na : nb);
+        element_t *pa = poly_alloc(n, pairing);
+        element_t *pb = poly_alloc(n, pairing);
+        for (int i = 0; i < na; i++)
+            element_set(pa[i], a[i]);
+        for (int i = 0; i < nb; i++)
+            element_set(pb[i], b[i]);
+        tmp = poly_alloc(2 * n - 1, pairing);
+        mul_kara(tmp, pa, pb, n, pairing);
+        poly_free(pa, n);
+        poly_free(pb, n);
+        for (int i = nr; i < 2 * n - 1; i++)
+            element_clear(tmp[i]);
+    }
+    for (int i = 0; i < nr; i++)
+        element_set(res[i], tmp[i]);
+    poly_free(tmp, nr);
+}
+
+// ---- Newton inversion and division ---------------------------------------
+
+void poly_inv_series(element_t *out, element_t *a, int na, int k,
+                     pairing_t pairing)
+{
+    element_t *b = poly_alloc(k, pairing);
+    element_t *t = poly_alloc(2 * k, pairing);
+    element_invert(b[0], a[0]);
+
+    // b ← b·(2 − a·b) mod x^{2l}
+    for (int l = 1; l < k;)
+    {
+        int l2 = (2 * l < k ? 2 * l : k);
+        int ta = (na < l2 ? na : l2);
+        poly_mul(t, a, ta, b, l, pairing); // length ta+l-1 ≥ l2 unless na short
+        for (int i = ta + l - 1; i < l2; i++)
+            element_set0(t[i]);
+        for (int i = 0; i < l2; i++)
+            element_neg(t[i], t[i]);
+        element_t two;
+        element_init_Zr(two, pairing);
+        element_set_si(two, 2);
+        element_add(t[0], t[0], two);
+        element_clear(two);
+        poly_mul(t, b, l, t, l2, pairing);
+        for (int i = 0; i < l2; i++)
+            element_set(b[i], t[i]);
+        l = l2;
+    }
+
+    for (int i = 0; i < k; i++)
+        element_set(out[i], b[i]);
+    poly_free(b, k);
+    poly_free(t, 2 * k);
+}
+
+void poly_divrem(element_t *q, element_t *r, element_t *a, int na,
+                 element_t *b, int nb, pairing_t pairing)
+{
+    if (na < nb)
+    {
+        for (int i = 0; i < nb - 1; i++)
+        {
+            if (i < na)
+                element_set(r[i], a[i]);
+            else
+                element_set0(r[i]);
+        }
+        return;
+    }
+    int nq = na - nb + 1;
+
+    if (nq < POLY_DIV_CUTOFF)
+    {
+        // schoolbook long division on a working copy
+        element_t *w = poly_alloc(na, pairing);
+        for (int i = 0; i < na; i++)
+            element_set(w[i], a[i]);
+        element_t inv, t;
+        element_init_Zr(inv, pairing);
+        element_init_Zr(t, pairing);
+        element_invert(inv, b[nb - 1]);
+        for (int i = nq - 1; i >= 0; i--)
+        {
+            element_mul(q[i], w[i + nb - 1], inv);
+            if (element_is0(q[i]))
+                continue;
+            for (int j = 0; j < nb; j++)
+            {
+                element_mul(t, q[i], b[j]);
+                element_sub(w[i + j], w[i + j], t);
+            }
+        }
+        for (int i = 0; i < nb - 1; i++)
+            element_set(r[i], w[i]);
+        element_clear(inv);
+        element_clear(t);
+        poly_free(w, na);
+        return;
+    }
+
+    // rev(q) = rev(a) · rev(b)^{-1}  mod x^{nq}
+    element_t *ra = poly_alloc(nq, pairing);
+    element_t *rb = poly_alloc(nb, pairing);
+    element_t *ib = poly_alloc(nq, pairing);
+    element_t *rq = poly_alloc(2 * nq - 1, pairing);
+    for (int i = 0; i < nq; i++)
+        element_set(ra[i], a[na - 1 - i]);
+    for (int i = 0; i < nb; i++)
+        element_set(rb[i], b[nb - 1 - i]);
+    poly_inv_series(ib, rb, nb, nq, pairing);
+    poly_mul(rq, ra, nq, ib, nq, pairing);
+    for (int i = 0; i < nq; i++)
+        element_set(q[i], rq[nq - 1 - i]);
+
+    // r = a − b·q (only the low nb−1 coefficients survive)
+    if (nb > 1)
+    {
+        element_t *bq = poly_alloc(na, pairing);
+        poly_mul(bq, b, nb, q, nq, pairing);
+        for (int i = 0; i < nb - 1; i++)
+            element_sub(r[i], a[i], bq[i]);
+        poly_free(bq, na);
+    }
+
+    poly_free(ra, nq);
+    poly_free(rb, nb);
+    poly_free(ib, nq);
+    poly_free(rq, 2 * nq - 1);
+}
+
+void poly_batch_invert(element_t *out, element_t *in, int n, pairing_t pairing)
+{
+    if (n <= 0)
+        return;
+    // prefix products, one inversion, then unwind
+    element_t *pre = poly_alloc(n, pairing);
+    element_set(pre[0], in[0]);
+    for (int i = 1; i < n; i++)
+        element_mul(pre[i], pre[i - 1], in[i]);
+
+    element_t inv, t;
+    element_init_Zr(inv, pairing);
+    element_init_Zr(t, pairing);
+    element_invert(inv, pre[n - 1]);
+    for (int i = n - 1; i > 0; i--)
+    {
+        element_mul(t, inv, pre[i - 1]); // 1/in[i]
+        element_mul(inv, inv, in[i]);    // 1/(in[0]..in[i-1])
+        element_set(out[i], t);
+    }
+    element_set(out[0], inv);
+
+    element_clear(inv);
+    element_clear(t);
+    poly_free(pre, n);
+}
@@ -0,0 +1,201 @@
+// src/pool.c
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "../include/pool.h"
+
+typedef struct {
+    pthread_mutex_t mu;
+    int head, tail; // remaining tasks [head, tail)
+} range_t;
+
+struct pool_s {
+    int n; // workers, including the calling thread
+    pthread_t *th;
+    range_t *rq;
+
+    pthread_mutex_t mu;
+    pthread_cond_t cv_job, cv_done;
+    unsigned long gen; // bumped for every job
+    int busy;          // helper threads still inside the current job
+    int stop;
+
+    pool_task_fn fn;
+    void *ctx;
+};
+
+typedef struct {
+    pool_t *p;
+    int id;
+} worker_arg_t;
+
+static int take_own(range_t *r, int *task)
+{
+    int ok = 0;
+    pthread_mutex_lock(&r->mu);
+    if (r->head < r->tail)
+    {
+        *task = r->head++;
+        ok = 1;
+    }
+    pthread_mutex_unlock(&r->mu);
+    return ok;
+}
+
+// move the upper half of some victim's range into our own
+static int steal(pool_t *p, int id)
+{
+    for (int k = 1; k < p->n; k++)
+    {
+        range_t *v = &p->rq[(id + k) % p->n];
+        int lo = 0, hi = 0;
+        pthread_mutex_lock(&v->mu);
+        int left = v->tail - v->head;
+        if (left > 0)
+        {
+            int take = (left + 1) / 2;
+            hi = v->tail;
+            lo = hi - take;
+            v->tail = lo;
+        }
+        pthread_mutex_unlock(&v->mu);
+        if (hi > lo)
+        {
+            range_t *own = &p->rq[id];
+            pthread_mutex_lock(&own->mu);
+            own->head = lo;
+            own->tail = hi;
+            pthread_mutex_unlock(&own->mu);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static void run_worker(pool_t *p, int id)
+{
+    int task;
+    for (;;)
+    {
+        while (take_own(&p->rq[id], &task))
+            p->fn(task, id, p->ctx);
+        if (!steal(p, id))
+            break;
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    worker_arg_t *wa = (worker_arg_t *)arg;
+    pool_t *p = wa->p;
+    int id = wa->id;
+    free(wa);
+
+    unsigned long seen = 0;
+    for (;;)
+    {
+        pthread_mutex_lock(&p->mu);
+        while (!p->stop && p->gen == seen)
+            pthread_cond_wait(&p->cv_job, &p->mu);
+        if (p->stop)
+        {
+            pthread_mutex_unlock(&p->mu);
+            return NULL;
+        }
+        seen = p->gen;
+        pthread_mutex_unlock(&p->mu);
+
+        run_worker(p, id);
+
+        pthread_mutex_lock(&p->mu);
+        if (--p->busy == 0)
+            pthread_cond_signal(&p->cv_done);
+        pthread_mutex_unlock(&p->mu);
+    }
+}
+
+int pool_default_threads(void)
+{
+    const char *env = getenv("GROTH16_THREADS");
+    if (env && atoi(env) > 0)
+        return atoi(env);
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}
+
+pool_t *pool_create(int nthreads)
+{
+    pool_t *p = calloc(1, sizeof(pool_t));
+    p->n = nthreads > 0 ? nthreads : 1;
+    p->rq = calloc(p->n, sizeof(range_t));
+    for (int i = 0; i < p->n; i++)
+        pthread_mutex_init(&p->rq[i].mu, NULL);
+    pthread_mutex_init(&p->mu, NULL);
+    pthread_cond_init(&p->cv_job, NULL);
+    pthread_cond_init(&p->cv_done, NULL);
+
+    p->th = calloc(p->n, sizeof(pthread_t));
+    for (int i = 1; i < p->n; i++)
+    {
+        worker_arg_t *wa = malloc(sizeof(worker_arg_t));
+        wa->p = p;
+        wa->id = i;
+        pthread_create(&p->th[i], NULL, worker_main, wa);
+    }
+    return p;
+}
+
+void pool_destroy(pool_t *p)
+{
+    pthread_mutex_lock(&p->mu);
+    p->stop = 1;
+    pthread_cond_broadcast(&p->cv_job);
+    pthread_mutex_unlock(&p->mu);
+    for (int i = 1; i < p->n; i++)
+        pthread_join(p->th[i], NULL);
+    for (int i = 0; i < p->n; i++)
+        pthread_mutex_destroy(&p->rq[i].mu);
+    pthread_mutex_destroy(&p->mu);
+    pthread_cond_destroy(&p->cv_job);
+    pthread_cond_destroy(&p->cv_done);
+    free(p->th);
+    free(p->rq);
+    free(p);
+}
+
+int pool_size(pool_t *p)
+{
+    return p->n;
+}
+
+void pool_for(pool_t *p, int n_tasks, pool_task_fn fn, void *ctx)
+{
+    if (n_tasks <= 0)
+        return;
+    if (p->n == 1 || n_tasks == 1)
+    {
+        for (int t = 0; t < n_tasks; t++)
+            fn(t, 0, ctx);
+        return;
+    }
+
+    pthread_mutex_lock(&p->mu);
+    for (int i = 0; i < p->n; i++)
+    {
+        p->rq[i].head = (int)((long long)n_tasks * i / p->n);
+        p->rq[i].tail = (int)((long long)n_tasks * (i + 1) / p->n);
+    }
+    p->fn = fn;
+    p->ctx = ctx;
+    p->busy = p->n - 1;
+    p->gen++;
+    pthread_cond_broadcast(&p->cv_job);
+    pthread_mutex_unlock(&p->mu);
+
+    run_worker(p, 0);
+
+    pthread_mutex_lock(&p->mu);
+    while (p->busy > 0)
+        pthread_cond_wait(&p->cv_done, &p->mu);
+    pthread_mutex_unlock(&p->mu);
+}
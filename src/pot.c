@@ -3,105 +3,810 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <pbc/pbc.h>
 #include "pot.h"
+#include "ptau.h"
+#include "pool.h"
+#include "msm.h"
+#include "sha256.h"
+#include "rng.h"
+#include "ptcheck.h"
+#include "io.h"
+#include "memstat.h"
 #include "fmt.h"
 
-void generate_pot(int deg, pairing_t pairing)
+// Output goes to <out>.part and is renamed into place when complete, so a
+// half-written table is never mistaken for a powers file. Every
+// POT_CKPT_EVERY powers the part file is fsync'd and <out>.ckpt records
+// where it stopped; rerunning the same command resumes from there.
+#define POT_PRINT_MAX 64         // larger runs print no per-power lines
+#define POT_CKPT_EVERY (1 << 16) // powers between checkpoints
+#define POT_GEN_BLOCK 256        // powers per pool task batch, per thread
+
+#define CKPT_MAGIC "G16R"
+#define CKPT_VERSION 1
+
+/**
+ * Checkpoint (secret: it holds τ, written with mode 0600):
+ *   "G16R" | u32 version | u32 deg | u32 phase | u32 next | u32 bytes_hi | u32 bytes_lo
+ *   | 32-byte SHA-256 of the part file's first `bytes` bytes
+ *   | τ | τ^next | g1 | g2   (framed elements)
+ *   | 32-byte SHA-256 of everything above
+ * phase 0 is the G1 table, 1 the G2 table; next is the first power not yet
+ * written in that phase.
+ */
+typedef struct {
+    uint32_t deg, phase, next;
+    uint64_t bytes;
+    unsigned char digest[32];
+} ckpt_t;
+
+static int ckpt_write(const char *path, const ckpt_t *c, element_t tau, element_t tp,
+                      element_t g1, element_t g2)
+{
+    char *body = NULL;
+    size_t len = 0;
+    FILE *ms = open_memstream(&body, &len);
+    int err = write_exact(ms, CKPT_MAGIC, 4) || write_u32(ms, CKPT_VERSION) ||
+              write_u32(ms, c->deg) || write_u32(ms, c->phase) || write_u32(ms, c->next) ||
+              write_u32(ms, (uint32_t)(c->bytes >> 32)) || write_u32(ms, (uint32_t)c->bytes) ||
+              write_exact(ms, c->digest, 32) || write_elem(ms, tau) || write_elem(ms, tp) ||
+              write_elem(ms, g1) || write_elem(ms, g2);
+    fclose(ms);
+    unsigned char h[32];
+    sha256_t sh;
+    sha256_init(&sh);
+    sha256_update(&sh, body, len);
+    sha256_final(&sh, h);
+
+    char *tmp = malloc(strlen(path) + 5);
+    sprintf(tmp, "%s.tmp", path);
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    FILE *f = fd >= 0 ? fdopen(fd, "wb") : NULL;
+    if (!f)
+        err = 1;
+    else
+    {
+        err = err || write_exact(f, body, len) || write_exact(f, h, 32) || fflush(f) != 0 ||
+              fsync(fileno(f)) != 0;
+        if (fclose(f) != 0)
+            err = 1;
+    }
+    if (!err && rename(tmp, path) != 0)
+        err = 1;
+    if (err)
+        fprintf(stderr, "Error writing checkpoint '%s': %s\n", path, strerror(errno));
+    free(tmp);
+    free(body);
+    return err ? -1 : 0;
+}
+
+// next framed element at *p into e (initialized)
+static int ckpt_elem(element_t e, const unsigned char **p, const unsigned char *end)
+{
+    if (end - *p < 4 || io_get_u32(*p) != (uint32_t)element_length_in_bytes(e) ||
+        (size_t)(end - *p - 4) < io_get_u32(*p))
+        return -1;
+    element_from_bytes(e, (unsigned char *)*p + 4);
+    *p += 4 + io_get_u32(*p);
+    return 0;
+}
+
+// 1 if there is no checkpoint, 0 when loaded, -1 when it is unusable
+static int ckpt_read(const char *path, ckpt_t *c, element_t tau, element_t tp,
+                     element_t g1, element_t g2)
+{
+    if (access(path, F_OK) != 0)
+        return 1;
+    io_map_t map;
+    if (io_map_open(&map, path) != 0)
+        return -1;
+    const unsigned char *b = map.base, *end = map.base + map.size - 32;
+    int err = map.size < 4 + 6 * 4 + 32 + 32 || memcmp(b, CKPT_MAGIC, 4) != 0 ||
+              io_get_u32(b + 4) != CKPT_VERSION;
+    if (!err)
+    {
+        unsigned char h[32];
+        sha256_t sh;
+        sha256_init(&sh);
+        sha256_update(&sh, b, map.size - 32);
+        sha256_final(&sh, h);
+        err = memcmp(h, end, 32) != 0;
+    }
+    if (!err)
+    {
+        c->deg = io_get_u32(b + 8);
+        c->phase = io_get_u32(b + 12);
+        c->next = io_get_u32(b + 16);
+        c->bytes = (uint64_t)io_get_u32(b + 20) << 32 | io_get_u32(b + 24);
+        memcpy(c->digest, b + 28, 32);
+        const unsigned char *p = b + 60;
+        err = c->phase > 1 || c->next > c->deg || ckpt_elem(tau, &p, end) ||
+              ckpt_elem(tp, &p, end) || ckpt_elem(g1, &p, end) || ckpt_elem(g2, &p, end) ||
+              p != end;
+    }
+    io_map_close(&map);
+    if (err)
+        fprintf(stderr, "Error: checkpoint '%s' is corrupt\n", path);
+    return err ? -1 : 0;
+}
+
+// framed element into the part file and the running hash
+static int put_elem(FILE *f, sha256_t *sh, element_t e)
+{
+    unsigned char buf[4 + 1024];
+    int len = element_length_in_bytes(e);
+    if (len > 1024)
+        return -1;
+    buf[0] = (unsigned char)(len >> 24);
+    buf[1] = (unsigned char)(len >> 16);
+    buf[2] = (unsigned char)(len >> 8);
+    buf[3] = (unsigned char)len;
+    element_to_bytes(buf + 4, e);
+    sha256_update(sh, buf, 4 + len);
+    return f ? write_exact(f, buf, 4 + (size_t)len) : 0;
+}
+
+// hash of the file's first n bytes
+static int hash_prefix(FILE *f, uint64_t n, sha256_t *sh)
+{
+    unsigned char buf[1 << 16];
+    sha256_init(sh);
+    if (fseek(f, 0, SEEK_SET) != 0)
+        return -1;
+    while (n > 0)
+    {
+        size_t take = n < sizeof buf ? (size_t)n : sizeof buf;
+        if (read_exact(f, buf, take) != 0)
+            return -1;
+        sha256_update(sh, buf, take);
+        n -= take;
+    }
+    return 0;
+}
+
+typedef struct {
+    const fb_table_t *t;
+    element_t *exp, *out;
+} gen_job_t;
+
+static void gen_task(int i, int worker, void *ctx)
+{
+    (void)worker;
+    gen_job_t *job = (gen_job_t *)ctx;
+    fb_pow(job->out[i], job->t, job->exp[i]);
+}
+
+int generate_pot(int deg, pctx_t *ctx, pairing_t pairing, const char *out_path)
 {
     fmt_banner("Powers of Tau");
-    // 1) sample secret tau
-    element_t tau;
+    fmt_pairing(pairing);
+    fmt_kv_s("randomness", rng_source());
+    int err = 0, print = (deg <= POT_PRINT_MAX);
+    element_t tau, tp;
     element_init_Zr(tau, pairing);
-    element_random(tau);
-    fmt_kv_e("tau (Zr)", tau);
+    element_init_Zr(tp, pairing);
 
-    // 2) compute tau^i in Zr: tp[0]=1; tp[i]=tp[i-1]*tau
-    element_t *tp = malloc((deg + 1) * sizeof(element_t));
-    for (int i = 0; i <= deg; i++)
-        element_init_Zr(tp[i], pairing);
-    element_set1(tp[0]);
-    for (int i = 1; i <= deg; i++)
-        element_mul(tp[i], tp[i - 1], tau);
+    // 1) resume from a checkpoint, or sample a fresh secret tau
+    char *part = NULL, *ck = NULL;
+    ckpt_t c = {.deg = (uint32_t)deg};
+    sha256_t sh;
+    sha256_init(&sh);
+    FILE *out = NULL;
+    int resumed = 0;
+    if (out_path)
+    {
+        part = malloc(strlen(out_path) + 6);
+        ck = malloc(strlen(out_path) + 6);
+        sprintf(part, "%s.part", out_path);
+        sprintf(ck, "%s.ckpt", out_path);
+        element_t g1, g2;
+        element_init_same_as(g1, ctx->g1);
+        element_init_same_as(g2, ctx->g2);
+        int rc = ckpt_read(ck, &c, tau, tp, g1, g2);
+        if (rc == 0 && c.deg != (uint32_t)deg)
+        {
+            fprintf(stderr, "Checkpoint '%s' is for degree %u, not %d\n", ck, c.deg, deg);
+            rc = -1;
+        }
+        if (rc == 0)
+        {
+            out = fopen(part, "r+b");
+            sha256_t check;
+            unsigned char h[32];
+            if (!out || hash_prefix(out, c.bytes, &sh) != 0)
+                rc = -1;
+            else
+            {
+                check = sh;
+                sha256_final(&check, h);
+                if (memcmp(h, c.digest, 32) != 0 || ftruncate(fileno(out), (off_t)c.bytes) != 0 ||
+                    fseek(out, (long)c.bytes, SEEK_SET) != 0)
+                    rc = -1;
+            }
+            if (rc != 0)
+                fprintf(stderr, "Error: '%s' does not match its checkpoint\n", part);
+            else if (element_cmp(g1, ctx->g1) || element_cmp(g2, ctx->g2))
+            {
+                // resume with the bases the run started with
+                element_set(ctx->g1, g1);
+                element_set(ctx->g2, g2);
+                fb_table_clear(&ctx->t1);
+                fb_table_clear(&ctx->t2);
+                fb_table_init(&ctx->t1, ctx->g1, pairing);
+                fb_table_init(&ctx->t2, ctx->g2, pairing);
+            }
+        }
+        element_clear(g1);
+        element_clear(g2);
+        if (rc < 0)
+        {
+            fprintf(stderr, "Remove '%s' and '%s' to start over\n", ck, part);
+            if (out)
+                fclose(out);
+            free(part);
+            free(ck);
+            element_clear(tau);
+            element_clear(tp);
+            return 1;
+        }
+        resumed = (rc == 0);
+    }
+    if (resumed)
+    {
+        fmt_kv_s("resumed from", ck);
+        fmt_kv_s("phase", c.phase ? "G2 powers" : "G1 powers");
+        fmt_kv_i("next power", c.next);
+        print = 0;
+    }
+    else
+    {
+        element_random(tau);
+        element_set1(tp);
+        if (out_path)
+        {
+            out = fopen(part, "wb");
+            if (!out)
+            {
+                fprintf(stderr, "Error opening '%s' for write: %s\n", part, strerror(errno));
+                return 1;
+            }
+            // the header goes through the hash like everything after it
+            unsigned char hdr[12];
+            memcpy(hdr, PTAU_MAGIC, 4);
+            for (int k = 0; k < 4; k++)
+            {
+                hdr[4 + k] = (unsigned char)(PTAU_VERSION >> (24 - 8 * k));
+                hdr[8 + k] = (unsigned char)((uint32_t)deg >> (24 - 8 * k));
+            }
+            sha256_update(&sh, hdr, 12);
+            err = write_exact(out, hdr, 12);
+        }
+    }
+    fmt_kv_e("tau (Zr)", tau);
 
-    fmt_sub("tau^i (Zr)");
-    for (int i = 0; i <= deg; i++)
+    // 2) tau^i in Zr (printed for small degrees only)
+    if (print)
     {
-        printf("  i=%d : ", i);
-        element_printf("%B\n", tp[i]);
+        element_t t;
+        element_init_Zr(t, pairing);
+        element_set1(t);
+        fmt_sub("tau^i (Zr)");
+        for (int i = 0; i <= deg; i++)
+        {
+            printf("  i=%d : ", i);
+            element_printf("%B\n", t);
+            element_mul(t, t, tau);
+        }
+        element_clear(t);
     }
 
-    // 3) pick generators g1 in G1, g2 in G2
-    element_t g1, g2;
-    element_init_G1(g1, pairing);
-    element_random(g1);
-    element_init_G2(g2, pairing);
-    element_random(g2);
-    fmt_kv_e("g1 (G1)", g1);
-    fmt_kv_e("g2 (G2)", g2);
+    // 3) generators g1 in G1, g2 in G2 (random, or fixed by a snapshot)
+    fmt_kv_e("g1 (G1)", ctx->g1);
+    fmt_kv_e("g2 (G2)", ctx->g2);
 
-    // 4) exponentiate: g1^{tau^i}, g2^{tau^i}
+    // 4) exponentiate g1^{tau^i}, g2^{tau^i}: in parallel per block, written
+    //    in order, with a checkpoint every POT_CKPT_EVERY powers
+    pool_t *pool = pool_create(pool_default_threads());
+    int block = POT_GEN_BLOCK * pool_size(pool);
+    if (block > POT_CKPT_EVERY)
+        block = POT_CKPT_EVERY;
+    gen_job_t job;
+    job.exp = malloc(sizeof(element_t) * block);
+    job.out = malloc(sizeof(element_t) * block);
+    for (int b = 0; b < block; b++)
+        element_init_Zr(job.exp[b], pairing);
+    for (; c.phase < 2 && !err; c.phase++, c.next = 0, element_set1(tp))
+    {
+        job.t = c.phase ? &ctx->t2 : &ctx->t1;
+        for (int b = 0; b < block; b++)
+            element_init_same_as(job.out[b], c.phase ? ctx->g2 : ctx->g1);
+        if (print)
+            fmt_sub(c.phase ? "G2 powers" : "G1 powers");
+        while ((int)c.next <= deg && !err)
+        {
+            int nb = (deg + 1 - (int)c.next < block ? deg + 1 - (int)c.next : block);
+            for (int b = 0; b < nb; b++)
+            {
+                element_set(job.exp[b], tp);
+                element_mul(tp, tp, tau);
+            }
+            pool_for(pool, nb, gen_task, &job);
+            for (int b = 0; b < nb && !err; b++)
+            {
+                if (print)
+                {
+                    printf("  i=%d : ", (int)c.next + b);
+                    element_printf("%B\n", job.out[b]);
+                }
+                err = put_elem(out, &sh, job.out[b]);
+            }
+            uint32_t prev = c.next;
+            c.next += (uint32_t)nb;
+            if (out && !err && (c.next / POT_CKPT_EVERY != prev / POT_CKPT_EVERY || (int)c.next > deg))
+            {
+                // fsync the data before the checkpoint that vouches for it
+                ckpt_t at = c;
+                if ((int)at.next > deg)
+                {
+                    at.phase++;
+                    at.next = 0;
+                }
+                sha256_t fin = sh;
+                sha256_final(&fin, at.digest);
+                at.bytes = (uint64_t)ftell(out);
+                element_t one;
+                element_init_Zr(one, pairing);
+                element_set1(one);
+                err = fflush(out) != 0 || fsync(fileno(out)) != 0 ||
+                      (at.phase < 2 && ckpt_write(ck, &at, tau, at.next ? tp : one, ctx->g1, ctx->g2) != 0);
+                element_clear(one);
+            }
+        }
+        for (int b = 0; b < block; b++)
+            element_clear(job.out[b]);
+    }
+    for (int b = 0; b < block; b++)
+        element_clear(job.exp[b]);
+    free(job.exp);
+    free(job.out);
+    pool_destroy(pool);
+
+    // 5) transcript: pot's own τ is the first contribution
     element_t tmpG1, tmpG2;
     element_init_G1(tmpG1, pairing);
     element_init_G2(tmpG2, pairing);
-    fmt_sub("G1 powers");
-    for (int i = 0; i <= deg; i++)
+    fb_pow(tmpG1, &ctx->t1, tau);
+    fb_pow(tmpG2, &ctx->t2, tau);
+    if (out)
     {
-        element_pow_zn(tmpG1, g1, tp[i]);
-        printf("  i=%d : ", i);
-        element_printf("%B\n", tmpG1);
-    }
-    fmt_sub("G2 powers");
-    for (int i = 0; i <= deg; i++)
-    {
-        element_pow_zn(tmpG2, g2, tp[i]);
-        printf("  i=%d : ", i);
-        element_printf("%B\n", tmpG2);
+        unsigned char one[4] = {0, 0, 0, 1};
+        sha256_update(&sh, one, 4);
+        err = err || write_exact(out, one, 4) || put_elem(out, &sh, tmpG1) ||
+              put_elem(out, &sh, tmpG2) || fflush(out) != 0 || fsync(fileno(out)) != 0;
+        if (fclose(out) != 0)
+            err = 1;
+        if (!err && rename(part, out_path) != 0)
+            err = 1;
+        if (err)
+            fprintf(stderr, "Error writing '%s' (rerun to resume)\n", out_path);
+        else
+        {
+            unlink(ck);
+            unsigned char h[32];
+            char hex[65];
+            sha256_final(&sh, h);
+            for (int k = 0; k < 32; k++)
+                sprintf(hex + 2 * k, "%02x", h[k]);
+            fmt_kv_s("powers file", out_path);
+            fmt_kv_s("sha256", hex);
+        }
     }
 
     // cleanup
     element_clear(tmpG1);
     element_clear(tmpG2);
-    element_clear(g1);
-    element_clear(g2);
-    for (int i = 0; i <= deg; i++)
-        element_clear(tp[i]);
-    free(tp);
+    element_clear(tp);
     element_clear(tau);
+    free(part);
+    free(ck);
+    return err;
 }
 
-int main(int argc, char **argv)
+// --- ceremony: contribute / verify ---
+
+#define POT_BLOCK 1024  // powers per pool task
+#define POT_CHUNK 4096  // terms per partial MSM in --verify
+
+typedef struct {
+    ptau_t *pt;
+    int g2, base;        // group (0: G1, 1: G2), index of the block's first power
+    element_t *pw, *out; // s^i and results for the block
+} raise_job_t;
+
+static void raise_task(int t, int worker, void *ctx)
 {
-    if (argc < 2)
+    (void)worker;
+    raise_job_t *job = (raise_job_t *)ctx;
+    int i = job->base + t;
+    if (job->g2)
+        ptau_get_g2(job->out[t], job->pt, i);
+    else
+        ptau_get_g1(job->out[t], job->pt, i);
+    element_pow_zn(job->out[t], job->out[t], job->pw[t]);
+}
+
+// out = in with τ replaced by τ·s: g^{τ^i} ↦ (g^{τ^i})^{s^i}, plus a record
+static int pot_contribute(const char *params, const char *in_path, const char *out_path)
+{
+    fmt_banner("Powers of Tau (contribution)");
+    pairing_t pairing;
+    ptau_t pt;
+    if (load_pairing(params, pairing) != 0 || ptau_open(&pt, in_path, pairing) != 0)
+        return 1;
+    if (pt.n_contrib == 0)
     {
-        fprintf(stderr, "Usage: %s pairing.params [deg]", argv[0]);
+        fprintf(stderr, "'%s' has no contribution transcript; regenerate it with pot\n", in_path);
         return 1;
     }
-    int deg = (argc > 2 ? atoi(argv[2]) : 8);
-    FILE *fp = fopen(argv[1], "r");
-    if (!fp)
+    fmt_pairing(pairing);
+    fmt_kv_i("degree", pt.deg);
+    fmt_kv_i("previous contributions", pt.n_contrib);
+    fmt_kv_s("randomness", rng_source());
+
+    element_t s, sp;
+    element_init_Zr(s, pairing);
+    element_init_Zr(sp, pairing);
+    element_random(s);
+
+    FILE *out = fopen(out_path, "wb");
+    if (!out)
     {
-        fprintf(stderr, "Error opening '%s': %s", argv[1], strerror(errno));
+        fprintf(stderr, "Error opening '%s' for write: %s\n", out_path, strerror(errno));
         return 1;
     }
-    fseek(fp, 0, SEEK_END);
-    long sz = ftell(fp);
-    fseek(fp, 0, SEEK_SET);
-    char *buf = malloc(sz + 1);
-    size_t rd = fread(buf, 1, sz, fp);
-    fclose(fp);
-    if (rd != (size_t)sz)
+    int err = ptau_write_header(out, pt.deg);
+
+    pool_t *pool = pool_create(pool_default_threads());
+    fmt_kv_i("threads", pool_size(pool));
+    int block = POT_BLOCK * pool_size(pool);
+    raise_job_t job = {.pt = &pt};
+    job.pw = malloc(sizeof(element_t) * block);
+    job.out = malloc(sizeof(element_t) * block);
+    for (int b = 0; b < block; b++)
+        element_init_Zr(job.pw[b], pairing);
+    for (job.g2 = 0; job.g2 < 2 && !err; job.g2++)
+    {
+        for (int b = 0; b < block; b++)
+            if (job.g2)
+                element_init_G2(job.out[b], pairing);
+            else
+                element_init_G1(job.out[b], pairing);
+        element_set1(sp);
+        for (job.base = 0; job.base <= pt.deg && !err; job.base += block)
+        {
+            int nb = (pt.deg + 1 - job.base < block ? pt.deg + 1 - job.base : block);
+            for (int b = 0; b < nb; b++)
+            {
+                element_set(job.pw[b], sp);
+                element_mul(sp, sp, s);
+            }
+            pool_for(pool, nb, raise_task, &job);
+            for (int b = 0; b < nb && !err; b++)
+                err = write_elem(out, job.out[b]);
+        }
+        for (int b = 0; b < block; b++)
+            element_clear(job.out[b]);
+    }
+
+    // transcript: previous records verbatim, then g1^{τ·s} and g2^{s}
+    element_t g1tau, s2;
+    element_init_G1(g1tau, pairing);
+    element_init_G2(s2, pairing);
+    ptau_get_contrib(g1tau, s2, &pt, pt.n_contrib - 1);
+    element_pow_zn(g1tau, g1tau, s);
+    ptau_get_g2(s2, &pt, 0);
+    element_pow_zn(s2, s2, s);
+    size_t rec = pt.g1_stride + pt.g2_stride;
+    err = err || write_u32(out, (uint32_t)pt.n_contrib + 1) ||
+          write_exact(out, pt.contrib, (size_t)pt.n_contrib * rec) ||
+          write_elem(out, g1tau) || write_elem(out, s2);
+    if (fclose(out) != 0)
+        err = 1;
+    if (err)
+        fprintf(stderr, "Error writing '%s'\n", out_path);
+    else
+    {
+        fmt_kv_e("g2^s", s2);
+        fmt_kv_s("powers file", out_path);
+    }
+
+    for (int b = 0; b < block; b++)
+        element_clear(job.pw[b]);
+    free(job.pw);
+    free(job.out);
+    pool_destroy(pool);
+    element_clear(g1tau);
+    element_clear(s2);
+    element_clear(s); // the secret: never written anywhere
+    element_clear(sp);
+    ptau_close(&pt);
+    return err ? 1 : 0;
+}
+
+typedef struct {
+    ptau_t *pt;
+    int g2;
+    unsigned char seed[32];
+    pairing_ptr pairing;
+    element_t *lo, *hi; // per chunk: Σ ρ_i·g^{τ^i}, Σ ρ_i·g^{τ^{i+1}}
+    int *bad;           // per chunk: a power is not a curve point (or not in G)
+    int per_point;      // the group has a cofactor: r·P = O for every power
+} rlc_job_t;
+
+// ρ for chunk c come from a generator keyed with H(seed ‖ c), so chunks
+// need no coordination and the result does not depend on the thread count
+static void rlc_rng(rng_t *r, const unsigned char seed[32], int c)
+{
+    unsigned char buf[36], h[32];
+    memcpy(buf, seed, 32);
+    buf[32] = (unsigned char)(c >> 24);
+    buf[33] = (unsigned char)(c >> 16);
+    buf[34] = (unsigned char)(c >> 8);
+    buf[35] = (unsigned char)c;
+    sha256_t sh;
+    sha256_init(&sh);
+    sha256_update(&sh, buf, sizeof buf);
+    sha256_final(&sh, h);
+    rng_seed(r, h);
+}
+
+static void rlc_task(int c, int worker, void *ctx)
+{
+    (void)worker;
+    rlc_job_t *job = (rlc_job_t *)ctx;
+    int i0 = c * POT_CHUNK;
+    int n = (job->pt->deg - i0 < POT_CHUNK ? job->pt->deg - i0 : POT_CHUNK);
+    element_t *bases = malloc(sizeof(element_t) * (n + 1));
+    element_t *rho = malloc(sizeof(element_t) * n);
+    for (int k = 0; k <= n; k++)
+    {
+        element_init_same_as(bases[k], job->lo[c]);
+        if (job->g2)
+            ptau_get_g2(bases[k], job->pt, i0 + k);
+        else
+            ptau_get_g1(bases[k], job->pt, i0 + k);
+        if (!elem_on_curve(bases[k]) ||
+            (job->per_point && (k < n || i0 + k == job->pt->deg) && !ptcheck_one(bases[k])))
+            job->bad[c] = 1;
+    }
+    for (int k = 0; k < n; k++)
+        element_init_Zr(rho[k], job->pairing);
+    rng_t r;
+    rlc_rng(&r, job->seed, c);
+    rng_scalars(&r, rho, n);
+    rng_wipe(&r);
+    msm(job->lo[c], bases, rho, n);
+    msm(job->hi[c], bases + 1, rho, n);
+    for (int k = 0; k <= n; k++)
+        element_clear(bases[k]);
+    for (int k = 0; k < n; k++)
+        element_clear(rho[k]);
+    free(bases);
+    free(rho);
+}
+
+// lo = Σ_{i<deg} ρ_i·g^{τ^i}, hi = Σ_{i<deg} ρ_i·g^{τ^{i+1}} over one group's
+// table; 0 if some power is not a point on the curve, or where the group
+// has a cofactor (ptcheck_folds) not in G
+static int rlc_sums(pool_t *pool, ptau_t *pt, int g2, const unsigned char seed[32],
+                     element_t lo, element_t hi, pairing_t pairing)
+{
+    int nc = (pt->deg + POT_CHUNK - 1) / POT_CHUNK;
+    rlc_job_t job = {.pt = pt, .g2 = g2, .pairing = pairing,
+                     .per_point = !ptcheck_folds(g2 ? pairing->G2 : pairing->G1)};
+    memcpy(job.seed, seed, 32);
+    job.lo = malloc(sizeof(element_t) * (nc > 0 ? nc : 1));
+    job.hi = malloc(sizeof(element_t) * (nc > 0 ? nc : 1));
+    job.bad = calloc(nc > 0 ? nc : 1, sizeof(int));
+    for (int c = 0; c < nc; c++)
+    {
+        element_init_same_as(job.lo[c], lo);
+        element_init_same_as(job.hi[c], hi);
+    }
+    pool_for(pool, nc, rlc_task, &job);
+    element_set1(lo);
+    element_set1(hi);
+    int ok = 1;
+    for (int c = 0; c < nc; c++)
+    {
+        element_mul(lo, lo, job.lo[c]);
+        element_mul(hi, hi, job.hi[c]);
+        element_clear(job.lo[c]);
+        element_clear(job.hi[c]);
+        ok = ok && !job.bad[c];
+    }
+    free(job.lo);
+    free(job.hi);
+    free(job.bad);
+    return ok;
+}
+
+// e(a1, b1) == e(a2, b2)
+static int pairs_equal(element_t a1, element_t b1, element_t a2, element_t b2, pairing_t pairing)
+{
+    element_t l, r;
+    element_init_GT(l, pairing);
+    element_init_GT(r, pairing);
+    pairing_apply(l, a1, b1, pairing);
+    pairing_apply(r, a2, b2, pairing);
+    int eq = !element_cmp(l, r);
+    element_clear(l);
+    element_clear(r);
+    return eq;
+}
+
+// Transcript chain plus 6 pairings for the tables, whatever the degree:
+// with random ρ, Σρ_i·g1^{τ^{i+1}} = τ·Σρ_i·g1^{τ^i} holds for a table that is
+// not a geometric sequence only with probability about deg/r. The same sums
+// give the subgroup check: r·lo = r·hi = O (ptcheck.h), where the group has
+// cofactor 1; otherwise each power is checked as it is summed.
+static int pot_verify(const char *params, const char *path, const char *prev_path)
+{
+    fmt_banner("Powers of Tau (verify)");
+    pairing_t pairing;
+    ptau_t pt;
+    if (load_pairing(params, pairing) != 0 || ptau_open(&pt, path, pairing) != 0)
+        return 1;
+    fmt_pairing(pairing);
+    fmt_kv_i("degree", pt.deg);
+    fmt_kv_i("contributions", pt.n_contrib);
+    if (pt.n_contrib == 0)
     {
-        fprintf(stderr, "Short read: %zu of %ld", rd, sz);
-        free(buf);
+        fprintf(stderr, "'%s' has no contribution transcript\n", path);
+        ptau_close(&pt);
         return 1;
     }
-    buf[sz] = '\0';
-    pbc_param_t params;
-    pbc_param_init_set_buf(params, buf, sz + 1);
-    free(buf);
+
+    element_t g1, g2, g1t, g2t, prev, t1, s2;
+    element_init_G1(g1, pairing);
+    element_init_G2(g2, pairing);
+    element_init_G1(g1t, pairing);
+    element_init_G2(g2t, pairing);
+    element_init_G1(prev, pairing);
+    element_init_G1(t1, pairing);
+    element_init_G2(s2, pairing);
+    ptau_get_g1(g1, &pt, 0);
+    ptau_get_g2(g2, &pt, 0);
+    int ok = !element_is1(g1) && !element_is1(g2), pairings = 0;
+
+    // 1) every record extends the previous secret: e(g1^{τ_k}, g2) = e(g1^{τ_{k-1}}, g2^{s_k})
+    ptcheck_t chk;
+    ptcheck_init(&chk, pairing);
+    ptcheck_add(&chk, g1);
+    ptcheck_add(&chk, g2);
+    element_set(prev, g1);
+    for (int k = 0; k < pt.n_contrib && ok; k++)
+    {
+        ptau_get_contrib(t1, s2, &pt, k);
+        ptcheck_add(&chk, t1);
+        ptcheck_add(&chk, s2);
+        ok = !element_is1(s2) && pairs_equal(t1, g2, prev, s2, pairing);
+        pairings += 2;
+        element_set(prev, t1);
+    }
+    ok = ptcheck_run(&chk, rng_process()) && ok;
+    ptcheck_clear(&chk);
+    fmt_kv_s("transcript", ok ? "consistent" : "BROKEN");
+
+    // 2) the file extends an earlier one: same bases, same leading records
+    if (ok && prev_path)
+    {
+        ptau_t old;
+        if (ptau_open(&old, prev_path, pairing) != 0)
+            ok = 0;
+        else
+        {
+            size_t rec = pt.g1_stride + pt.g2_stride;
+            ok = old.deg == pt.deg && old.n_contrib < pt.n_contrib &&
+                 memcmp(old.g1, pt.g1, pt.g1_stride) == 0 &&
+                 memcmp(old.g2, pt.g2, pt.g2_stride) == 0 &&
+                 memcmp(old.contrib, pt.contrib, (size_t)old.n_contrib * rec) == 0;
+            fmt_kv_s("extends", ok ? prev_path : "NO");
+            ptau_close(&old);
+        }
+    }
+
+    // 3) tables: g^{τ^1} is the transcript's τ, and both tables are geometric
+    if (ok && pt.deg >= 1)
+    {
+        ptau_get_g1(g1t, &pt, 1);
+        ptau_get_g2(g2t, &pt, 1);
+        ok = !element_cmp(g1t, prev) && pairs_equal(g1t, g2, g1, g2t, pairing);
+        pairings += 2;
+
+        unsigned char seed[32];
+        rng_bytes(rng_process(), seed, sizeof seed);
+
+        pool_t *pool = pool_create(pool_default_threads());
+        fmt_kv_i("threads", pool_size(pool));
+        element_t lo1, hi1, lo2, hi2;
+        element_init_G1(lo1, pairing);
+        element_init_G1(hi1, pairing);
+        element_init_G2(lo2, pairing);
+        element_init_G2(hi2, pairing);
+        int points = rlc_sums(pool, &pt, 0, seed, lo1, hi1, pairing) &&
+                     rlc_sums(pool, &pt, 1, seed, lo2, hi2, pairing) &&
+                     ptcheck_one(lo1) && ptcheck_one(hi1) && ptcheck_one(lo2) && ptcheck_one(hi2);
+        fmt_kv_s("points", points ? "on the curve, in G1/G2" : "INVALID");
+        ok = ok && points && pairs_equal(hi1, g2, lo1, g2t, pairing) &&
+             pairs_equal(g1, hi2, g1t, lo2, pairing);
+        pairings += 4;
+        pool_destroy(pool);
+        element_clear(lo1);
+        element_clear(hi1);
+        element_clear(lo2);
+        element_clear(hi2);
+    }
+    fmt_kv_i("pairings", pairings);
+    fmt_kv_s("result", ok ? "VALID" : "INVALID");
+
+    element_clear(g1);
+    element_clear(g2);
+    element_clear(g1t);
+    element_clear(g2t);
+    element_clear(prev);
+    element_clear(t1);
+    element_clear(s2);
+    ptau_close(&pt);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+    memstat_init();
+    if (argc < 2 || (strcmp(argv[1], "--snapshot") == 0 && argc < 4) ||
+        (strcmp(argv[1], "--contribute") == 0 && argc < 5) ||
+        (strcmp(argv[1], "--verify") == 0 && argc < 4))
+    {
+        fprintf(stderr, "Usage: %s pairing.params [deg] [out.ptau]\n"
+                        "       %s --snapshot pairing.params out.ctx\n"
+                        "       %s --contribute pairing.params in.ptau out.ptau\n"
+                        "       %s --verify pairing.params file.ptau [previous.ptau]\n",
+                argv[0], argv[0], argv[0], argv[0]);
+        return 1;
+    }
+    fmt_init(1, stdout);
+    if (rng_install() != 0)
+        return 1;
+    memstat_stage(argv[1][0] == '-' ? argv[1] + 2 : "powers");
+    if (strcmp(argv[1], "--contribute") == 0)
+        return pot_contribute(argv[2], argv[3], argv[4]);
+    if (strcmp(argv[1], "--verify") == 0)
+        return pot_verify(argv[2], argv[3], argc > 4 ? argv[4] : NULL);
     pairing_t pairing;
-    pairing_init_pbc_param(pairing, params);
-    generate_pot(deg, pairing);
-    return 0;
-}
\ No newline at end of file
+    pctx_t ctx;
+    if (strcmp(argv[1], "--snapshot") == 0)
+    {
+        // params + bases + fixed-base tables, loadable by every binary
+        fmt_banner("Pairing snapshot");
+        if (pctx_open(&ctx, argv[2], pairing) != 0)
+            return 1;
+        fmt_pairing(pairing);
+        fmt_kv_i("window bits", FB_WINDOW);
+        fmt_kv_i("table entries", 2LL * ctx.t1.windows * FB_DIGITS);
+        int rc = pctx_write(argv[3], argv[2], &ctx);
+        if (rc == 0)
+            fmt_kv_s("snapshot", argv[3]);
+        pctx_close(&ctx);
+        return rc ? 1 : 0;
+    }
+    int deg = (argc > 2 ? atoi(argv[2]) : 8);
+    if (pctx_open(&ctx, argv[1], pairing) != 0)
+        return 1;
+    int rc = generate_pot(deg, &ctx, pairing, argc > 3 ? argv[3] : NULL);
+    pctx_close(&ctx);
+    return rc;
+}
@@ -3,82 +3,391 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
-#include <arpa/inet.h>   // htonl
 #include <pbc/pbc.h>
 #include "../include/circuit.h"
+#include "../include/r1cs_opt.h"
+#include "../include/cbuild.h"
+#include "../include/r1csfile.h"
 #include "../include/poly.h"
+#include "../include/subprod.h"
+#include "../include/qap.h"
+#include "../include/pool.h"
+#include "../include/qapcache.h"
+#include "../include/witness.h"
+#include "../include/pctx.h"
+#include "../include/rng.h"
 #include "../include/fmt.h"
-
-// Horner eval: out = sum_{i=0..m-1} coeffs[i] * t^i
-static void poly_eval(element_t out, element_t *coeffs, int m, element_t t) {
-    element_set0(out);
-    for (int i = m - 1; i >= 0; i--) {
-        element_mul(out, out, t);
-        element_add(out, out, coeffs[i]);
+#include "../include/io.h"
+#include "../include/bundle.h"
+#include "../include/keys.h"
+#include "../include/memstat.h"
+#include "../include/metrics.h"
+
+// --- batch mode: one proof per "x y" line of a witness file, same polynomial ---
+// Everything that depends only on the circuit (τ, bases, column values,
+// Z(τ), the g2^{τ^i} tail of the proof file) is computed once; the
+// per-instance state lives in parallel arrays indexed by witness.
+typedef struct {
+    int d, n, off, pub;             // wires [pub, n) are the public x and y
+    element_t *coeffs, *valA, *valB, *valC;
+    element_ptr invZ;
+    const fb_table_t *t1, *t2;      // fixed-base tables shared by every proof
+    element_t *xs, *ys;             // inputs [batch]
+    element_t **wires;              // witnesses of the current chunk
+    int base;                       // batch index of the chunk's first witness
+    element_t *piA, *piB, *piC, *piH; // outputs [batch]
+    char *ok;                       // s_d == y
+    element_t **scratch;            // per worker: a, b, c, t
+    pairing_ptr pairing;
+} batch_job_t;
+
+static void batch_task(int i, int worker, void *ctx) {
+    batch_job_t *job = (batch_job_t*)ctx;
+    uint64_t t0 = metrics_now();
+    element_t *s = job->scratch[worker];
+    element_t *wires = job->wires[i];
+    int k = job->base + i;
+    element_set0(s[0]); element_set0(s[1]); element_set0(s[2]);
+    for (int j = 0; j < job->pub; j++) {
+        element_mul(s[3], wires[j], job->valA[j]); element_add(s[0], s[0], s[3]);
+        element_mul(s[3], wires[j], job->valB[j]); element_add(s[1], s[1], s[3]);
+        element_mul(s[3], wires[j], job->valC[j]); element_add(s[2], s[2], s[3]);
     }
+    job->ok[k] = !element_cmp(wires[job->off + job->d], job->ys[k]);
+    fb_pow(job->piC[k], job->t1, s[2]); // private part; the verifier adds x·IC_x + y·IC_y
+
+    for (int j = job->pub; j < job->n; j++) { element_mul(s[3], wires[j], job->valC[j]); element_add(s[2], s[2], s[3]); }
+    fb_pow(job->piA[k], job->t1, s[0]);
+    fb_pow(job->piB[k], job->t2, s[1]);
+    element_mul(s[3], s[0], s[1]); element_sub(s[3], s[3], s[2]); element_mul(s[3], s[3], job->invZ);
+    fb_pow(job->piH[k], job->t1, s[3]);
+    metrics_since(METRICS_MSM, t0);
+    metrics_add(METRICS_REQUESTS, 1);
+    metrics_queue_add(-1);
 }
 
-static int write_exact(FILE *f, const void *p, size_t n) {
-    const unsigned char *b = (const unsigned char*)p;
-    size_t w = 0;
-    while (w < n) {
-        size_t r = fwrite(b + w, 1, n - w, f);
-        if (r == 0) return -1;
-        w += r;
-    }
-    return 0;
+// [u32 len][bytes] of e at p; returns the end
+static unsigned char *frame_elem(unsigned char *p, element_t e) {
+    uint32_t len = (uint32_t)element_length_in_bytes(e);
+    p[0] = (unsigned char)(len >> 24); p[1] = (unsigned char)(len >> 16); p[2] = (unsigned char)(len >> 8); p[3] = (unsigned char)len;
+    return p + 4 + element_to_bytes(p + 4, e);
 }
 
-static int write_u32(FILE *f, uint32_t v_host) {
-    uint32_t v = htonl(v_host);
-    return write_exact(f, &v, 4);
+// --vk out.key: the verifying key (g2, g2^{τ^0..τ^m}, IC) of this run's
+// setup as a key file, for `verifier --vk` to pin proofs, bundles and
+// aggregates to. The demo prover samples τ itself, so it is the only party
+// that can publish it.
+static int write_vk(const char *path, int n, int m, pctx_t *ctx, element_t tau, element_t *ic, int l, pairing_t pairing) {
+    vk_t vk = {.m = m, .l = l, .ic = ic};
+    vk.g2_tau = (element_t*)malloc(sizeof(element_t)*(m+1));
+    element_t tp; element_init_Zr(tp, pairing); element_set1(tp);
+    for (int i = 0; i <= m; i++) {
+        element_init_G2(vk.g2_tau[i], pairing);
+        fb_pow(vk.g2_tau[i], &ctx->t2, tp); element_mul(tp, tp, tau);
+    }
+    element_init_G2(vk.g2, pairing); element_set(vk.g2, ctx->g2);
+    int rc = keys_write_vk(path, n, m, ctx->g1, &vk);
+    if (rc == 0) fmt_kv_s("verifying key", path);
+    for (int i = 0; i <= m; i++) element_clear(vk.g2_tau[i]);
+    free(vk.g2_tau); element_clear(vk.g2); element_clear(tp);
+    return rc;
 }
 
-static int write_elem(FILE *f, element_t e) {
-    int len = element_length_in_bytes(e);
-    unsigned char *buf = (unsigned char*)malloc(len);
-    element_to_bytes(buf, e);
-    int ok = (write_u32(f, (uint32_t)len) == 0 && write_exact(f, buf, (size_t)len) == 0);
-    free(buf);
-    return ok ? 0 : -1;
+// argv = pairing.params d a0…ad [-o prefix | --bundle out.g16b] [--vk out.key]
+static int prove_batch(const char *wit_path, int argc, char **argv) {
+    if (argc < 3 || argc < 3 + atoi(argv[1])) {
+        fprintf(stderr, "Usage: prover --batch witnesses.txt pairing.params d a0…ad [-o prefix | --bundle out.g16b] [--vk out.key]\n");
+        return 1;
+    }
+    fmt_init(1, stdout);
+    fmt_banner("Prover (batch)");
+    if (rng_install() != 0) return 1;
+    pairing_t pairing;
+    pctx_t ctx;
+    if (pctx_open(&ctx, argv[0], pairing) != 0) return 1;
+    fmt_pairing(pairing);
+    fmt_kv_s("randomness", rng_source());
+
+    int d = atoi(argv[1]);
+    element_t *coeffs = (element_t*)malloc((d+1) * sizeof(element_t));
+    for (int i = 0; i <= d; i++) { element_init_Zr(coeffs[i], pairing); element_set_str(coeffs[i], argv[2+i], 10); }
+    const char *prefix = "proof_batch", *bundle_path = NULL, *vk_path = NULL;
+    for (int a = 3 + d; a + 1 < argc; a++) {
+        if (strcmp(argv[a], "-o") == 0) prefix = argv[a+1];
+        else if (strcmp(argv[a], "--bundle") == 0) bundle_path = argv[a+1];
+        else if (strcmp(argv[a], "--vk") == 0) vk_path = argv[a+1];
+    }
+
+    // --- witnesses: "x y" per line, '#' comments ---
+    uint64_t t0 = metrics_now();
+    FILE *wf = fopen(wit_path, "r");
+    if (!wf) { fprintf(stderr, "Error opening '%s': %s\n", wit_path, strerror(errno)); return 1; }
+    int cap = 64, B = 0;
+    element_t *xs = (element_t*)malloc(sizeof(element_t)*cap);
+    element_t *ys = (element_t*)malloc(sizeof(element_t)*cap);
+    char *line = NULL; size_t lcap = 0;
+    for (int ln = 1; getline(&line, &lcap, wf) != -1; ln++) {
+        char *hash = strchr(line, '#'); if (hash) *hash = '\0';
+        char *xt = strtok(line, " \t\r\n,"), *yt = strtok(NULL, " \t\r\n,");
+        if (!xt) continue;
+        if (!yt) { fprintf(stderr, "%s:%d: expected 'x y'\n", wit_path, ln); return 1; }
+        if (B == cap) {
+            cap *= 2;
+            xs = (element_t*)realloc(xs, sizeof(element_t)*cap);
+            ys = (element_t*)realloc(ys, sizeof(element_t)*cap);
+        }
+        element_init_Zr(xs[B], pairing); element_set_str(xs[B], xt, 10);
+        element_init_Zr(ys[B], pairing); element_set_str(ys[B], yt, 10);
+        B++;
+    }
+    free(line); fclose(wf);
+    metrics_record(METRICS_DECODE, B ? (metrics_now() - t0) / (uint64_t)B : 0, B); // amortized over the batch
+
+    int m, n; r1cs_shape(d, &n, &m);
+    fmt_kv_s("witnesses", wit_path);
+    fmt_kv_i("batch size", B);
+    fmt_kv_i("constraints (m)", m);
+    fmt_kv_i("variables (n)", n);
+
+    // --- shared setup: τ, bases, column values, Z(τ), IC ---
+    memstat_stage("setup");
+    element_t tau_secret; element_init_Zr(tau_secret, pairing); element_random(tau_secret);
+    fmt_kv_e("tau", tau_secret);
+    fmt_kv_e("g1", ctx.g1);
+    fmt_kv_e("g2", ctx.g2);
+
+    element_t *L = (element_t*)malloc(sizeof(element_t)*m);
+    qap_lagrange_at(L, m, tau_secret, pairing);
+    element_t *valA = (element_t*)malloc(sizeof(element_t)*n);
+    element_t *valB = (element_t*)malloc(sizeof(element_t)*n);
+    element_t *valC = (element_t*)malloc(sizeof(element_t)*n);
+    eval_r1cs_columns(d, coeffs, L, valA, valB, valC, pairing);
+    int pub = r1cs_pub(d);
+    element_t ic[CIRCUIT_N_PUB];
+    for (int i = 0; i < CIRCUIT_N_PUB; i++) { element_init_G1(ic[i], pairing); fb_pow(ic[i], &ctx.t1, valC[pub + i]); }
+
+    element_t Ztau, diff, invZ;
+    element_init_Zr(Ztau, pairing); element_init_Zr(diff, pairing); element_init_Zr(invZ, pairing);
+    element_set1(Ztau);
+    for (int k = 1; k <= m; k++) { element_set_si(diff, k); element_sub(diff, tau_secret, diff); element_mul(Ztau, Ztau, diff); }
+    element_invert(invZ, Ztau);
+    fmt_kv_e("Z(τ)", Ztau);
+
+    // proof tail (g2, m, g2^{τ^0..τ^m}, IC) is identical for every instance: serialize once
+    char *tail = NULL; size_t tail_len = 0;
+    FILE *ms = open_memstream(&tail, &tail_len);
+    element_t tp, g2p; element_init_Zr(tp, pairing); element_set1(tp); element_init_G2(g2p, pairing);
+    int err = write_elem(ms, ctx.g2) || write_u32(ms, (uint32_t)m);
+    for (int i = 0; i <= m && !err; i++) {
+        fb_pow(g2p, &ctx.t2, tp); element_mul(tp, tp, tau_secret);
+        err = write_elem(ms, g2p);
+    }
+    err = err || write_u32(ms, CIRCUIT_N_PUB);
+    for (int i = 0; i < CIRCUIT_N_PUB && !err; i++) err = write_elem(ms, ic[i]);
+    fclose(ms);
+    if (err) { fprintf(stderr, "Error serializing proof tail\n"); return 1; }
+
+
+    // --- per-instance work, parallel over witnesses ---
+    memstat_stage("proofs");
+    metrics_queue(B);
+    pool_t *pool = pool_create(pool_default_threads());
+    fmt_kv_i("threads", pool_size(pool));
+    int nw = pool_size(pool);
+    batch_job_t job = {.d = d, .n = n, .off = d + 1, .pub = pub, .coeffs = coeffs,
+                       .valA = valA, .valB = valB, .valC = valC,
+                       .invZ = invZ, .t1 = &ctx.t1, .t2 = &ctx.t2,
+                       .xs = xs, .ys = ys, .pairing = pairing};
+    job.piA = (element_t*)malloc(sizeof(element_t)*(B ? B : 1));
+    job.piB = (element_t*)malloc(sizeof(element_t)*(B ? B : 1));
+    job.piC = (element_t*)malloc(sizeof(element_t)*(B ? B : 1));
+    job.piH = (element_t*)malloc(sizeof(element_t)*(B ? B : 1));
+    job.ok = (char*)malloc(B ? B : 1);
+    for (int k = 0; k < B; k++) {
+        element_init_G1(job.piA[k], pairing); element_init_G2(job.piB[k], pairing);
+        element_init_G1(job.piC[k], pairing); element_init_G1(job.piH[k], pairing);
+    }
+    job.scratch = (element_t**)malloc(sizeof(element_t*)*nw);
+    for (int w = 0; w < nw; w++) {
+        job.scratch[w] = (element_t*)malloc(sizeof(element_t)*4);
+        for (int i = 0; i < 4; i++) element_init_Zr(job.scratch[w][i], pairing);
+    }
+    // witnesses are built chunk by chunk so only a chunk's wires are live
+    int chunk = 64 * nw;
+    job.wires = (element_t**)malloc(sizeof(element_t*)*chunk);
+    for (job.base = 0; job.base < B; job.base += chunk) {
+        int nc = (B - job.base < chunk ? B - job.base : chunk);
+        t0 = metrics_now();
+        witness_build_batch(pool, d, coeffs, xs + job.base, nc, job.wires, pairing);
+        metrics_record(METRICS_WITNESS, (metrics_now() - t0) / (uint64_t)nc, nc); // amortized over the chunk
+        pool_for(pool, nc, batch_task, &job);
+        for (int i = 0; i < nc; i++) poly_free(job.wires[i], n);
+    }
+    free(job.wires);
+
+    // --- write proofs in witness order: a file each, or head-only records of
+    //     one bundle after the shared tail ---
+    int written = 0, rejected = 0;
+    char *path = (char*)malloc(strlen(prefix) + 24);
+    size_t head_len = 20 + 3 * (size_t)pairing_length_in_bytes_G1(pairing) + (size_t)pairing_length_in_bytes_G2(pairing)
+                    + CIRCUIT_N_PUB * (4 + (size_t)pairing_length_in_bytes_Zr(pairing));
+    unsigned char *heads = NULL, id[32];
+    bundle_writer_t bw;
+    if (bundle_path) {
+        if (bundle_create(&bw, bundle_path) != 0) return 1;
+        heads = (unsigned char*)malloc(head_len * (B ? B : 1));
+        if (bundle_add_tail(&bw, tail, tail_len, id) != 0) { fprintf(stderr, "Error writing '%s'\n", bundle_path); return 1; }
+        metrics_add(METRICS_BYTES, (long long)tail_len);
+    }
+    for (int k = 0; k < B; k++) {
+        if (!job.ok[k]) {
+            if (rejected++ == 0) fprintf(stderr, "witness %d: y != f(x), no proof\n", k);
+            metrics_add(METRICS_REJECTED, 1);
+            continue;
+        }
+        t0 = metrics_now();
+        if (bundle_path) {
+            unsigned char *h = heads + head_len * k, *e = h;
+            e = frame_elem(e, job.piA[k]); e = frame_elem(e, job.piB[k]);
+            e = frame_elem(e, job.piC[k]); e = frame_elem(e, job.piH[k]);
+            e[0] = e[1] = e[2] = 0; e[3] = CIRCUIT_N_PUB; e += 4;
+            e = frame_elem(e, xs[k]); e = frame_elem(e, ys[k]);
+            struct iovec part = {h, (size_t)(e - h)};
+            if (bundle_add(&bw, &part, 1, id) != 0) { fprintf(stderr, "Error writing '%s'\n", bundle_path); return 1; }
+            written++;
+            metrics_since(METRICS_SERIALIZE, t0);
+            metrics_add(METRICS_ACCEPTED, 1); metrics_add(METRICS_BYTES, (long long)part.iov_len);
+            continue;
+        }
+        sprintf(path, "%s_%d.bin", prefix, k);
+        FILE *pf = fopen(path, "wb");
+        if (!pf) { fprintf(stderr, "Error opening '%s' for write: %s\n", path, strerror(errno)); return 1; }
+        err = write_elem(pf, job.piA[k]) || write_elem(pf, job.piB[k])
+           || write_elem(pf, job.piC[k]) || write_elem(pf, job.piH[k])
+           || write_u32(pf, CIRCUIT_N_PUB) || write_elem(pf, xs[k]) || write_elem(pf, ys[k])
+           || write_exact(pf, tail, tail_len);
+        if (fclose(pf) != 0 || err) { fprintf(stderr, "Error writing '%s'\n", path); return 1; }
+        written++;
+        metrics_since(METRICS_SERIALIZE, t0);
+        metrics_add(METRICS_ACCEPTED, 1); metrics_add(METRICS_BYTES, (long long)(head_len + tail_len));
+    }
+    if (bundle_path && bundle_finish(&bw) != 0) { fprintf(stderr, "Error writing '%s'\n", bundle_path); return 1; }
+    fmt_sub("Batch");
+    fmt_kv_i("proofs written", written);
+    fmt_kv_i("rejected", rejected);
+    if (bundle_path) fmt_kv_s("bundle", bundle_path);
+    else if (written) { sprintf(path, "%s_<k>.bin", prefix); fmt_kv_s("proof files", path); }
+    if (vk_path && write_vk(vk_path, n, m, &ctx, tau_secret, ic, CIRCUIT_N_PUB, pairing) != 0) return 1;
+
+    // Cleanup
+    for (int w = 0; w < nw; w++) { for (int i = 0; i < 4; i++) element_clear(job.scratch[w][i]); free(job.scratch[w]); }
+    for (int k = 0; k < B; k++) {
+        element_clear(job.piA[k]); element_clear(job.piB[k]); element_clear(job.piC[k]); element_clear(job.piH[k]);
+        element_clear(xs[k]); element_clear(ys[k]);
+    }
+    free(job.scratch); free(job.piA); free(job.piB); free(job.piC); free(job.piH); free(job.ok);
+    free(xs); free(ys); free(path); free(tail); free(heads);
+    pool_destroy(pool);
+    for (int j = 0; j < n; j++) { element_clear(valA[j]); element_clear(valB[j]); element_clear(valC[j]); }
+    free(valA); free(valB); free(valC);
+    poly_free(L, m); poly_free(coeffs, d + 1);
+    for (int i = 0; i < CIRCUIT_N_PUB; i++) element_clear(ic[i]);
+    element_clear(Ztau); element_clear(diff); element_clear(invZ);
+    element_clear(tp); element_clear(g2p); element_clear(tau_secret);
+    pctx_close(&ctx);
+    return rejected ? 1 : 0;
 }
 
 int main(int argc, char **argv) {
-    if (argc < 5) {
-        fprintf(stderr, "Usage: %s pairing.params d x y a0…ad\n", argv[0]);
+    memstat_init();
+    metrics_init("prover");
+    // --batch witnesses.txt: many (x, y) instances of one polynomial
+    if (argc > 2 && strcmp(argv[1], "--batch") == 0) return prove_batch(argv[2], argc - 3, argv + 3);
+    // -o proof.bin, --vk out.key: output paths (trailing pairs)
+    const char *proof_path = "proof_demo.bin", *vk_path = NULL;
+    while (argc > 3 && (strcmp(argv[argc-2], "-o") == 0 || strcmp(argv[argc-2], "--vk") == 0)) {
+        if (argv[argc-2][1] == 'o') proof_path = argv[argc-1]; else vk_path = argv[argc-1];
+        argc -= 2;
+    }
+    // --dense: interpolate the materialized A/B/C instead of the implicit path
+    int dense = (argc > 1 && strcmp(argv[1], "--dense") == 0);
+    if (dense) { argv[1] = argv[0]; argv++; argc--; }
+    // --circuit file.cir: compile a DSL circuit instead (always dense)
+    // --r1cs file.r1cs file.wtns: a saved constraint system and witness
+    const char *cir = NULL, *r1cs_path = NULL, *wtns_path = NULL;
+    if (argc > 2 && strcmp(argv[1], "--circuit") == 0) {
+        cir = argv[2]; dense = 1;
+        argv[2] = argv[0]; argv += 2; argc -= 2;
+    } else if (argc > 3 && strcmp(argv[1], "--r1cs") == 0) {
+        r1cs_path = argv[2]; wtns_path = argv[3]; dense = 1;
+        argv[3] = argv[0]; argv += 3; argc -= 3;
+    }
+    int external = cir || r1cs_path;
+    if (argc < (external ? 2 : 5)) {
+        fprintf(stderr, "Usage: %s [--dense] pairing.params d x y a0…ad [-o proof.bin] [--vk out.key]\n"
+                        "       %s --circuit file.cir pairing.params name=value… [-o proof.bin] [--vk out.key]\n"
+                        "       %s --r1cs file.r1cs file.wtns pairing.params [-o proof.bin] [--vk out.key]\n"
+                        "       %s --batch witnesses.txt pairing.params d a0…ad [-o prefix | --bundle out.g16b] [--vk out.key]\n",
+                argv[0], argv[0], argv[0], argv[0]);
         return 1;
     }
 
     fmt_init(1, stdout);
     fmt_banner("Prover (QAP-aware demo)");
+    if (rng_install() != 0) return 1;
 
-    // --- load pairing params ---
-    FILE *fp = fopen(argv[1], "r");
-    if (!fp) { fprintf(stderr, "Error opening '%s': %s\n", argv[1], strerror(errno)); return 1; }
-    fseek(fp, 0, SEEK_END); long sz = ftell(fp); fseek(fp, 0, SEEK_SET);
-    char *pbuf = (char*)malloc(sz + 1);
-    size_t rd = fread(pbuf, 1, sz, fp); fclose(fp);
-    if (rd != (size_t)sz) { fprintf(stderr, "Short read: %zu of %ld\n", rd, sz); free(pbuf); return 1; }
-    pbuf[sz] = '\0';
-
-    pbc_param_t params; pbc_param_init_set_buf(params, pbuf, sz + 1); free(pbuf);
-    pairing_t pairing; pairing_init_pbc_param(pairing, params);
+    // --- load pairing params (or a snapshot) with bases and fixed-base tables ---
+    memstat_stage("setup");
+    pairing_t pairing; pctx_t ctx;
+    if (pctx_open(&ctx, argv[1], pairing) != 0) return 1;
+    fmt_pairing(pairing);
+    fmt_kv_s("randomness", rng_source());
 
     // --- parse polynomial inputs ---
-    int argi = 2;
-    int d = atoi(argv[argi++]);
+    uint64_t t_req = metrics_now(), t0 = t_req;
+    int argi = 2, d = 0;
     element_t x, y; element_init_Zr(x, pairing); element_init_Zr(y, pairing);
-    element_set_str(x, argv[argi++], 10);
-    element_set_str(y, argv[argi++], 10);
-    element_t *coeffs = (element_t*)malloc((d+1) * sizeof(element_t));
-    for (int i = 0; i <= d; i++) { element_init_Zr(coeffs[i], pairing); element_set_str(coeffs[i], argv[argi++], 10); }
+    element_t *coeffs = NULL;
+    if (!external) {
+        d = atoi(argv[argi++]);
+        element_set_str(x, argv[argi++], 10);
+        element_set_str(y, argv[argi++], 10);
+        coeffs = (element_t*)malloc((d+1) * sizeof(element_t));
+        for (int i = 0; i <= d; i++) { element_init_Zr(coeffs[i], pairing); element_set_str(coeffs[i], argv[argi++], 10); }
+    }
 
-    // --- build R1CS & wires (witness) ---
+    metrics_since(METRICS_DECODE, t0);
+    pool_t *pool = pool_create(pool_default_threads());
+
+    // --- wires (witness); R1CS matrices only on the dense path ---
+    memstat_stage("circuit");
+    t0 = metrics_now(); // circuit and witness files count here too
     r1cs_t r; element_t *wires;
-    build_r1cs(d, coeffs, x, y, &r, &wires, pairing);
-    int m = r.n_cons, n = r.n_vars;
+    int m, n; r1cs_shape(d, &n, &m);
+    if (cir) {
+        if (cb_load(cir, argc - 2, argv + 2, pairing, &r, &wires) != 0) return 1;
+        fmt_kv_s("circuit", cir);
+    }
+    else if (r1cs_path) {
+        if (r1cs_load_files(r1cs_path, wtns_path, pairing, &r, &wires) != 0) return 1;
+        fmt_kv_s("circuit", r1cs_path);
+    }
+    else if (dense) build_r1cs(d, coeffs, x, y, &r, &wires, pairing);
+    else {
+        witness_build(pool, d, coeffs, x, &wires, pairing);
+        element_set(wires[r1cs_pub(d) + 1], y); // the claim, as build_r1cs does
+    }
+    int n_pub = CIRCUIT_N_PUB;
+    if (dense) {
+        r1cs_maybe_optimize(&r, &wires, pairing);
+        m = r.n_cons; n = r.n_vars; n_pub = r.n_pub;
+    }
+    int priv = n - n_pub; // wires [priv, n) are public inputs
+    metrics_since(METRICS_WITNESS, t0);
     fmt_kv_i("constraints (m)", m);
     fmt_kv_i("variables (n)", n);
+    fmt_kv_i("public inputs", n_pub);
+    fmt_kv_s("QAP path", dense ? "dense" : "implicit");
 
     // --- interpolation points τ_k = 1..m ---
     element_t *tau_pts = (element_t*)malloc(sizeof(element_t)*m);
@@ -86,58 +395,57 @@ int main(int argc, char **argv) {
 
     // --- toxic waste tau (demo) + bases ---
     element_t tau_secret; element_init_Zr(tau_secret, pairing); element_random(tau_secret);
-    element_t g1, g2; element_init_G1(g1, pairing); element_random(g1);
-    element_init_G2(g2, pairing); element_random(g2);
+    element_ptr g1 = ctx.g1, g2 = ctx.g2;
     fmt_kv_e("tau", tau_secret);
     fmt_kv_e("g1", g1);
     fmt_kv_e("g2", g2);
+    fmt_kv_s("bases", ctx.snapshot ? "snapshot" : "random");
 
-    // --- column polys and aggregates ---
-    element_t *Ae = (element_t*)malloc(sizeof(element_t)*m);
-    element_t *Be = (element_t*)malloc(sizeof(element_t)*m);
-    element_t *Ce = (element_t*)malloc(sizeof(element_t)*m);
-    element_t *pA = (element_t*)malloc(sizeof(element_t)*m);
-    element_t *pB = (element_t*)malloc(sizeof(element_t)*m);
-    element_t *pC = (element_t*)malloc(sizeof(element_t)*m);
-
-    element_t valA, valB, valC;
-    element_init_Zr(valA, pairing); element_init_Zr(valB, pairing); element_init_Zr(valC, pairing);
-
-    element_t Aagg, Bagg, Cagg;
-    element_init_Zr(Aagg, pairing); element_set0(Aagg);
-    element_init_Zr(Bagg, pairing); element_set0(Bagg);
-    element_init_Zr(Cagg, pairing); element_set0(Cagg);
+    // --- column scalars A_j(τ),B_j(τ),C_j(τ) and aggregates (parallel over columns) ---
+    memstat_stage("columns");
+    t0 = metrics_now();
+    fmt_kv_i("threads", pool_size(pool));
+    element_t *valA = (element_t*)malloc(sizeof(element_t)*n);
+    element_t *valB = (element_t*)malloc(sizeof(element_t)*n);
+    element_t *valC = (element_t*)malloc(sizeof(element_t)*n);
 
     fmt_sub("Per-variable scalars and aggregation");
-    for (int j = 0; j < n; j++) {
-        for (int k = 0; k < m; k++) {
-            element_init_Zr(Ae[k], pairing); element_set(Ae[k], r.A[k][j]);
-            element_init_Zr(Be[k], pairing); element_set(Be[k], r.B[k][j]);
-            element_init_Zr(Ce[k], pairing); element_set(Ce[k], r.C[k][j]);
-        }
-        lagrange_interpolation(pA, tau_pts, Ae, m, pairing);
-        lagrange_interpolation(pB, tau_pts, Be, m, pairing);
-        lagrange_interpolation(pC, tau_pts, Ce, m, pairing);
-
-        poly_eval(valA, pA, m, tau_secret);
-        poly_eval(valB, pB, m, tau_secret);
-        poly_eval(valC, pC, m, tau_secret);
-
-        // accumulate A(τ),B(τ),C(τ)
-        element_t t; element_init_Zr(t, pairing);
-        element_mul(t, wires[j], valA); element_add(Aagg, Aagg, t);
-        element_mul(t, wires[j], valB); element_add(Bagg, Bagg, t);
-        element_mul(t, wires[j], valC); element_add(Cagg, Cagg, t);
-        element_clear(t);
-
-        for (int k = 0; k < m; k++) { element_clear(Ae[k]); element_clear(Be[k]); element_clear(Ce[k]); element_clear(pA[k]); element_clear(pB[k]); element_clear(pC[k]); }
+    qap_cache_t cache;
+    if (dense && m <= POLY_SMALL) {
+        // small domain: summed against L_k(τ), no tree or cached coefficients
+        qap_eval_columns(pool, &r, NULL, tau_secret, valA, valB, valC, pairing);
+    } else if (dense && qap_cache_open(&cache, &r, pairing) == 0) {
+        fmt_kv_s("QAP cache", "hit");
+        qap_cache_eval(pool, &cache, tau_secret, valA, valB, valC, pairing);
+        qap_cache_close(&cache);
+    } else if (dense) {
+        // subproduct tree over the domain (shared by every column)
+        subprod_tree_t tree; subprod_tree_init(&tree, tau_pts, m, pairing);
+        qap_eval_columns(pool, &r, &tree, tau_secret, valA, valB, valC, pairing);
+        subprod_tree_clear(&tree);
+    } else {
+        element_t *L = (element_t*)malloc(sizeof(element_t)*m);
+        qap_lagrange_at(L, m, tau_secret, pairing);
+        eval_r1cs_columns(d, coeffs, L, valA, valB, valC, pairing);
+        poly_free(L, m);
     }
 
+    // public columns are zero in A and B; C splits into the private part
+    // (piC) and Σ x_i·C_i(τ), which the verifier rebuilds from the IC query
+    element_t Aagg, Bagg, Cagg, Cpub;
+    element_init_Zr(Aagg, pairing); element_init_Zr(Bagg, pairing); element_init_Zr(Cagg, pairing); element_init_Zr(Cpub, pairing);
+    qap_inner_product(pool, Aagg, wires, valA, priv, pairing);
+    qap_inner_product(pool, Bagg, wires, valB, priv, pairing);
+    qap_inner_product(pool, Cagg, wires, valC, priv, pairing);
+    qap_inner_product(pool, Cpub, wires + priv, valC + priv, n_pub, pairing);
+
     fmt_kv_e("A(τ)", Aagg);
     fmt_kv_e("B(τ)", Bagg);
-    fmt_kv_e("C(τ)", Cagg);
+    fmt_kv_e("C(τ) private", Cagg);
+    fmt_kv_e("C(τ) public", Cpub);
 
     // --- compute Z(τ) and H(τ) = (A·B − C)/Z(τ) ---
+    memstat_stage("proof");
     element_t Ztau; element_init_Zr(Ztau, pairing); element_set1(Ztau);
     for (int k = 0; k < m; k++) {
         element_t diff; element_init_Zr(diff, pairing);
@@ -146,11 +454,13 @@ int main(int argc, char **argv) {
         element_clear(diff);
     }
     element_t D; element_init_Zr(D, pairing);
-    element_mul(D, Aagg, Bagg); element_sub(D, D, Cagg);
+    element_mul(D, Aagg, Bagg); element_sub(D, D, Cagg); element_sub(D, D, Cpub);
 
     element_t invZ; element_init_Zr(invZ, pairing); element_invert(invZ, Ztau);
     element_t Htau; element_init_Zr(Htau, pairing); element_mul(Htau, D, invZ);
 
+    metrics_since(METRICS_QAP, t0);
+
     fmt_sub("QAP divisibility (prover)");
     fmt_kv_e("Z(τ)", Ztau);
     fmt_kv_e("H(τ)", Htau);
@@ -162,10 +472,12 @@ int main(int argc, char **argv) {
     element_init_G1(piC, pairing);
     element_init_G1(piH, pairing);
 
-    element_pow_zn(piA, g1, Aagg);
-    element_pow_zn(piB, g2, Bagg);
-    element_pow_zn(piC, g1, Cagg);
-    element_pow_zn(piH, g1, Htau);
+    t0 = metrics_now();
+    fb_pow(piA, &ctx.t1, Aagg);
+    fb_pow(piB, &ctx.t2, Bagg);
+    fb_pow(piC, &ctx.t1, Cagg);
+    fb_pow(piH, &ctx.t1, Htau);
+    uint64_t msm_ns = metrics_now() - t0;
 
     fmt_sub("Proof elements");
     fmt_kv_e("piA (G1)", piA);
@@ -173,17 +485,31 @@ int main(int argc, char **argv) {
     fmt_kv_e("piC (G1)", piC);
     fmt_kv_e("piH (G1)", piH);
 
+    // --- public inputs and their verifier-key query IC_i = g1^{C_i(τ)} ---
+    element_t *ic = (element_t*)malloc(sizeof(element_t)*(n_pub ? n_pub : 1));
+    t0 = metrics_now();
+    for (int i = 0; i < n_pub; i++) { element_init_G1(ic[i], pairing); fb_pow(ic[i], &ctx.t1, valC[priv + i]); }
+    msm_ns += metrics_now() - t0;
+    fmt_sub("Public inputs");
+    for (int i = 0; i < n_pub; i++) {
+        printf("  input %d\n", i);
+        fmt_kv_e("    x", wires[priv + i]);
+        fmt_kv_e("    IC (G1)", ic[i]);
+    }
+
     // --- publish g2^{τ^i} for i=0..m (lets verifier build g2^{Z(τ)} ) ---
     element_t *g2_tau = (element_t*)malloc(sizeof(element_t)*(m+1));
     element_t tp; element_init_Zr(tp, pairing); element_set1(tp);
+    t0 = metrics_now();
     for (int i = 0; i <= m; i++) {
         element_init_G2(g2_tau[i], pairing);
-        element_pow_zn(g2_tau[i], g2, tp);    // g2^{τ^i}
+        fb_pow(g2_tau[i], &ctx.t2, tp);       // g2^{τ^i}
         element_mul(tp, tp, tau_secret);      // τ^{i+1}
     }
+    metrics_record(METRICS_MSM, msm_ns + (metrics_now() - t0), 1);
 
-    // --- serialize proof: piA,piB,piC,piH,g2, m, g2^{τ^0..τ^m} ---
-    const char *proof_path = "proof_demo.bin";
+    // --- serialize proof: piA,piB,piC,piH, l, x_1..x_l | g2, m, g2^{τ^0..τ^m}, l, IC_1..IC_l ---
+    t0 = metrics_now();
     FILE *pf = fopen(proof_path, "wb");
     if (!pf) { fprintf(stderr, "Error opening '%s' for write: %s\n", proof_path, strerror(errno)); return 1; }
 
@@ -192,28 +518,41 @@ int main(int argc, char **argv) {
       || write_elem(pf, piB)
       || write_elem(pf, piC)
       || write_elem(pf, piH)
-      || write_elem(pf, g2)
-      || write_u32(pf, (uint32_t)m);
+      || write_u32(pf, (uint32_t)n_pub);
+    for (int i = 0; i < n_pub && !ok; i++) ok = write_elem(pf, wires[priv + i]);
+    ok = ok || write_elem(pf, g2) || write_u32(pf, (uint32_t)m);
     if (ok) { fprintf(stderr, "Error writing proof header\n"); fclose(pf); return 1; }
 
     for (int i = 0; i <= m; i++) if (write_elem(pf, g2_tau[i])) { fprintf(stderr, "Error writing g2^tau^i\n"); fclose(pf); return 1; }
+    ok = write_u32(pf, (uint32_t)n_pub);
+    for (int i = 0; i < n_pub && !ok; i++) ok = write_elem(pf, ic[i]);
+    if (ok) { fprintf(stderr, "Error writing IC\n"); fclose(pf); return 1; }
+    long proof_bytes = ftell(pf);
     fclose(pf);
+    metrics_since(METRICS_SERIALIZE, t0);
+    metrics_since(METRICS_REQUEST, t_req);
+    metrics_add(METRICS_REQUESTS, 1); metrics_add(METRICS_ACCEPTED, 1); metrics_add(METRICS_BYTES, proof_bytes);
     fmt_kv_s("proof file", proof_path);
+    fmt_kv_i("proof bytes", proof_bytes);
+    if (vk_path && write_vk(vk_path, n, m, &ctx, tau_secret, ic, n_pub, pairing) != 0) return 1;
 
     // preview pairing that SHOULD pass with g2^{Z(τ)} and piH (verifier reconstructs g2^{Z(τ)})
     fmt_sub("Preview done. (Verifier will do final check)");
 
     // Cleanup minimal (demo)
     element_clear(invZ); element_clear(Htau); element_clear(D); element_clear(Ztau);
-    element_clear(Aagg); element_clear(Bagg); element_clear(Cagg);
-    element_clear(valA); element_clear(valB); element_clear(valC);
+    element_clear(Aagg); element_clear(Bagg); element_clear(Cagg); element_clear(Cpub);
+    for (int i = 0; i < n_pub; i++) element_clear(ic[i]);
+    free(ic);
+    for (int j = 0; j < n; j++) { element_clear(valA[j]); element_clear(valB[j]); element_clear(valC[j]); }
+    free(valA); free(valB); free(valC);
+    pool_destroy(pool);
     element_clear(piA); element_clear(piB); element_clear(piC); element_clear(piH);
-    element_clear(g1); element_clear(g2); element_clear(tau_secret);
+    element_clear(tau_secret); pctx_close(&ctx);
     element_clear(tp);
     for (int i = 0; i < m; i++) element_clear(tau_pts[i]);
     for (int i = 0; i <= m; i++) element_clear(g2_tau[i]);
     free(tau_pts); free(g2_tau);
-    free(Ae); free(Be); free(Ce); free(pA); free(pB); free(pC);
     // (r1cs matrices and wires clearing omitted)
     return 0;
 }
@@ -0,0 +1,86 @@
+// src/ptau.c
+#include <stdio.h>
+#include <string.h>
+#include <pbc/pbc.h>
+#include "../include/ptau.h"
+
+#define PTAU_HEADER 12
+
+int ptau_write_header(FILE *f, int deg)
+{
+    if (write_exact(f, PTAU_MAGIC, 4) || write_u32(f, PTAU_VERSION) || write_u32(f, (uint32_t)deg))
+        return -1;
+    return 0;
+}
+
+int ptau_open(ptau_t *pt, const char *path, pairing_t pairing)
+{
+    if (io_map_open(&pt->map, path) != 0)
+        return -1;
+    unsigned char *b = pt->map.base;
+    size_t size = pt->map.size;
+    uint32_t ver = size >= PTAU_HEADER ? io_get_u32(b + 4) : 0;
+    if (size < PTAU_HEADER || memcmp(b, PTAU_MAGIC, 4) != 0 || ver < 1 || ver > PTAU_VERSION)
+    {
+        fprintf(stderr, "Error: '%s' is not a powers-of-tau file\n", path);
+        ptau_close(pt);
+        return -1;
+    }
+    pt->deg = (int)io_get_u32(b + 8);
+
+    size_t n = (size_t)pt->deg + 1;
+    pt->g1_stride = 4 + (size_t)pairing_length_in_bytes_G1(pairing);
+    pt->g2_stride = 4 + (size_t)pairing_length_in_bytes_G2(pairing);
+    pt->g1 = b + PTAU_HEADER;
+    pt->g2 = pt->g1 + n * pt->g1_stride;
+    size_t tables = PTAU_HEADER + n * (pt->g1_stride + pt->g2_stride);
+    pt->n_contrib = 0;
+    pt->contrib = NULL;
+    int bad = size < tables;
+    if (!bad && ver >= 2)
+    {
+        bad = size < tables + 4;
+        if (!bad)
+        {
+            pt->n_contrib = (int)io_get_u32(b + tables);
+            pt->contrib = b + tables + 4;
+            tables += 4 + (size_t)pt->n_contrib * (pt->g1_stride + pt->g2_stride);
+            for (int k = 0; k < pt->n_contrib && size == tables && !bad; k++)
+            {
+                unsigned char *rec = pt->contrib + (size_t)k * (pt->g1_stride + pt->g2_stride);
+                bad = io_get_u32(rec) + 4 != pt->g1_stride ||
+                      io_get_u32(rec + pt->g1_stride) + 4 != pt->g2_stride;
+            }
+        }
+    }
+    if (bad || size != tables ||
+        io_get_u32(pt->g1) + 4 != pt->g1_stride || io_get_u32(pt->g2) + 4 != pt->g2_stride)
+    {
+        fprintf(stderr, "Error: '%s' is truncated or was made with other pairing params\n", path);
+        ptau_close(pt);
+        return -1;
+    }
+    return 0;
+}
+
+void ptau_close(ptau_t *pt)
+{
+    io_map_close(&pt->map);
+}
+
+void ptau_get_g1(element_t out, ptau_t *pt, int i)
+{
+    element_from_bytes(out, pt->g1 + (size_t)i * pt->g1_stride + 4);
+}
+
+void ptau_get_g2(element_t out, ptau_t *pt, int i)
+{
+    element_from_bytes(out, pt->g2 + (size_t)i * pt->g2_stride + 4);
+}
+
+void ptau_get_contrib(element_t g1tau, element_t s2, ptau_t *pt, int k)
+{
+    unsigned char *rec = pt->contrib + (size_t)k * (pt->g1_stride + pt->g2_stride);
+    element_from_bytes(g1tau, rec + 4);
+    element_from_bytes(s2, rec + pt->g1_stride + 4);
+}
@@ -0,0 +1,138 @@
+// src/ptcheck.c
+#include <stdlib.h>
+#include <gmp.h>
+#include <pbc/pbc.h>
+#include "../include/io.h"
+#include "../include/msm.h"
+#include "../include/ptcheck.h"
+
+void ptcheck_init(ptcheck_t *c, pairing_t pairing)
+{
+    c->pairing = pairing;
+    for (int g = 0; g < 2; g++)
+    {
+        c->n[g] = c->cap[g] = 0;
+        c->pt[g] = NULL;
+    }
+    c->fold[0] = ptcheck_folds(pairing->G1);
+    c->fold[1] = ptcheck_folds(pairing->G2);
+    c->bad = 0;
+}
+
+static void drop(ptcheck_t *c)
+{
+    for (int g = 0; g < 2; g++)
+    {
+        for (int i = 0; i < c->n[g]; i++)
+            element_clear(c->pt[g][i]);
+        c->n[g] = 0;
+    }
+    c->bad = 0;
+}
+
+void ptcheck_clear(ptcheck_t *c)
+{
+    drop(c);
+    for (int g = 0; g < 2; g++)
+    {
+        free(c->pt[g]);
+        c->pt[g] = NULL;
+        c->cap[g] = 0;
+    }
+}
+
+void ptcheck_add(ptcheck_t *c, element_t e)
+{
+    int g = (e->field == c->pairing->G1 ? 0 : e->field == c->pairing->G2 ? 1 : -1);
+    if (g < 0 || !elem_on_curve(e))
+    {
+        c->bad = 1;
+        return;
+    }
+    if (c->n[g] == c->cap[g])
+    {
+        c->cap[g] = c->cap[g] ? 2 * c->cap[g] : 16;
+        c->pt[g] = realloc(c->pt[g], sizeof(element_t) * c->cap[g]);
+    }
+    element_init_same_as(c->pt[g][c->n[g]], e);
+    element_set(c->pt[g][c->n[g]++], e);
+}
+
+void ptcheck_add_vec(ptcheck_t *c, element_t *v, int n)
+{
+    for (int i = 0; i < n; i++)
+        ptcheck_add(c, v[i]);
+}
+
+// r·Σ ρ_i·P_i = O, or r·P_i = O for each point when fold is 0
+static int group_ok(element_t *pt, int n, int fold, rng_t *r, pairing_t pairing)
+{
+    if (!fold)
+    {
+        int ok = 1;
+        for (int i = 0; i < n && ok; i++)
+            ok = ptcheck_one(pt[i]);
+        return ok;
+    }
+    element_t *rho = malloc(sizeof(element_t) * n);
+    unsigned char b[PTCHECK_BITS / 8];
+    mpz_t z;
+    mpz_init(z);
+    for (int i = 0; i < n; i++)
+    {
+        rng_bytes(r, b, sizeof b);
+        mpz_import(z, sizeof b, 1, 1, 0, 0, b);
+        element_init_Zr(rho[i], pairing);
+        element_set_mpz(rho[i], z);
+    }
+    element_t s;
+    element_init_same_as(s, pt[0]);
+    msm(s, pt, rho, n);
+    int ok = ptcheck_one(s);
+    element_clear(s);
+    for (int i = 0; i < n; i++)
+        element_clear(rho[i]);
+    free(rho);
+    mpz_clear(z);
+    return ok;
+}
+
+int ptcheck_one(element_t e)
+{
+    element_t t;
+    element_init_same_as(t, e);
+    element_pow_mpz(t, e, e->field->order);
+    int ok = element_is0(t);
+    element_clear(t);
+    return ok;
+}
+
+int ptcheck_folds(field_ptr g)
+{
+    element_t e;
+    element_init(e, g);
+    mpz_ptr q = element_x(e)->field->order;
+    mpz_t bound, r2;
+    mpz_init(bound);
+    mpz_init(r2);
+    mpz_sqrt(bound, q); // ⌊√Q⌋, so Q + 3 + 2⌊√Q⌋ > Q + 1 + 2√Q
+    mpz_mul_2exp(bound, bound, 1);
+    mpz_add(bound, bound, q);
+    mpz_add_ui(bound, bound, 3);
+    mpz_mul_2exp(r2, g->order, 1);
+    int folds = mpz_cmp(bound, r2) < 0;
+    mpz_clear(bound);
+    mpz_clear(r2);
+    element_clear(e);
+    return folds;
+}
+
+int ptcheck_run(ptcheck_t *c, rng_t *r)
+{
+    int ok = !c->bad;
+    for (int g = 0; g < 2 && ok; g++)
+        if (c->n[g] > 0)
+            ok = group_ok(c->pt[g], c->n[g], c->fold[g], r, c->pairing);
+    drop(c);
+    return ok;
+}
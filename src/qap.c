@@ -0,0 +1,287 @@
+// src/qap.c
+#include <stdlib.h>
+#include <pthread.h>
+#include <pbc/pbc.h>
+#include "../include/poly.h"
+#include "../include/qap.h"
+
+// terms per partial sum in qap_inner_product
+#define DOT_CHUNK 64
+
+typedef struct {
+    const r1cs_t *r;
+    subprod_tree_t *tree;
+    int j0;
+    const int *cols;         // explicit column list, or NULL for j0, j0+1, …
+    element_ptr tau;         // evaluation point (eval jobs only)
+    element_t *L;            // small eval jobs: L_k(τ), no tree
+    element_t *val[3];       // eval jobs: outputs [n]
+    element_t **poly[3];     // interp jobs: outputs [j1-j0][m]
+    element_t **ev, **coef;  // per-worker scratch, m slots each
+} column_job_t;
+
+static element_t **matrix(const r1cs_t *r, int which)
+{
+    return which == 0 ? r->A : (which == 1 ? r->B : r->C);
+}
+
+// task = 3·column + matrix
+static void column_task(int task, int worker, void *ctx)
+{
+    column_job_t *job = (column_job_t *)ctx;
+    int slot = task / 3, which = task % 3;
+    int j = job->cols ? job->cols[slot] : job->j0 + slot;
+    element_t **M = matrix(job->r, which);
+    if (job->L)
+    {
+        // A_j(τ) = Σ_k A[k][j]·L_k(τ), straight from the sparse column
+        element_ptr out = job->val[which][j];
+        element_t t;
+        element_init_same_as(t, out);
+        element_set0(out);
+        for (int k = 0; k < job->r->n_cons; k++)
+            if (!element_is0(M[k][j]))
+            {
+                element_mul(t, M[k][j], job->L[k]);
+                element_add(out, out, t);
+            }
+        element_clear(t);
+        return;
+    }
+    int m = job->tree->m;
+    element_t *ev = job->ev[worker];
+
+    for (int k = 0; k < m; k++)
+    {
+        element_init_Zr(ev[k], job->tree->pairing);
+        element_set(ev[k], M[k][j]);
+    }
+    if (job->tau)
+    {
+        element_t *coef = job->coef[worker];
+        subprod_interpolate(coef, ev, job->tree);
+        poly_eval(job->val[which][j], coef, m, job->tau);
+        for (int k = 0; k < m; k++)
+            element_clear(coef[k]);
+    }
+    else
+    {
+        subprod_interpolate(job->poly[which][slot], ev, job->tree);
+    }
+    for (int k = 0; k < m; k++)
+        element_clear(ev[k]);
+}
+
+static void run_columns(pool_t *pool, column_job_t *job, int ncols)
+{
+    int nw = pool_size(pool), m = job->tree->m;
+    job->ev = malloc(sizeof(element_t *) * nw);
+    job->coef = malloc(sizeof(element_t *) * nw);
+    for (int w = 0; w < nw; w++)
+    {
+        job->ev[w] = malloc(sizeof(element_t) * (m > 0 ? m : 1));
+        job->coef[w] = malloc(sizeof(element_t) * (m > 0 ? m : 1));
+    }
+
+    pool_for(pool, 3 * ncols, column_task, job);
+
+    for (int w = 0; w < nw; w++)
+    {
+        free(job->ev[w]);
+        free(job->coef[w]);
+    }
+    free(job->ev);
+    free(job->coef);
+}
+
+void qap_eval_columns(pool_t *pool, const r1cs_t *r, subprod_tree_t *tree,
+                      element_t tau, element_t *valA, element_t *valB,
+                      element_t *valC, pairing_t pairing)
+{
+    for (int j = 0; j < r->n_vars; j++)
+    {
+        element_init_Zr(valA[j], pairing);
+        element_init_Zr(valB[j], pairing);
+        element_init_Zr(valC[j], pairing);
+    }
+    int m = r->n_cons;
+    if (m <= POLY_SMALL)
+    {
+        element_t L[POLY_SMALL];
+        qap_lagrange_at(L, m, tau, pairing);
+        column_job_t job = {.r = r, .tau = tau, .L = L, .val = {valA, valB, valC}};
+        pool_for(pool, 3 * r->n_vars, column_task, &job);
+        for (int k = 0; k < m; k++)
+            element_clear(L[k]);
+        return;
+    }
+    column_job_t job = {.r = r, .tree = tree, .j0 = 0, .tau = tau,
+                        .val = {valA, valB, valC}};
+    run_columns(pool, &job, r->n_vars);
+}
+
+void qap_interp_columns(pool_t *pool, const r1cs_t *r, subprod_tree_t *tree,
+                        int j0, int j1, element_t **polyA, element_t **polyB,
+                        element_t **polyC)
+{
+    column_job_t job = {.r = r, .tree = tree, .j0 = j0, .tau = NULL,
+                        .poly = {polyA, polyB, polyC}};
+    run_columns(pool, &job, j1 - j0);
+}
+
+void qap_interp_column_list(pool_t *pool, const r1cs_t *r, subprod_tree_t *tree,
+                            const int *cols, int ncols, element_t **polyA,
+                            element_t **polyB, element_t **polyC)
+{
+    column_job_t job = {.r = r, .tree = tree, .cols = cols, .tau = NULL,
+                        .poly = {polyA, polyB, polyC}};
+    run_columns(pool, &job, ncols);
+}
+
+// w[k] = 1 / ∏_{l≠k}(x_k − x_l) = (−1)^{m−1−k} / (k!·(m−1−k)!) for the
+// domain x_k = k+1; w has m slots, initialized here
+static void domain_weights(element_t *w, int m, pairing_t pairing)
+{
+    element_t *inv_fact = poly_alloc(m, pairing);
+    element_t t, c;
+    element_init_Zr(t, pairing);
+    element_init_Zr(c, pairing);
+
+    // inv_fact[k] = 1/k!: one inversion of (m−1)!, then walk down
+    element_set1(t);
+    for (int k = 2; k < m; k++)
+    {
+        element_set_si(c, k);
+        element_mul(t, t, c);
+    }
+    element_invert(inv_fact[m - 1], t);
+    for (int k = m - 1; k > 0; k--)
+    {
+        element_set_si(c, k);
+        element_mul(inv_fact[k - 1], inv_fact[k], c);
+    }
+
+    for (int k = 0; k < m; k++)
+    {
+        element_init_Zr(w[k], pairing);
+        element_mul(w[k], inv_fact[k], inv_fact[m - 1 - k]);
+        if ((m - 1 - k) & 1)
+            element_neg(w[k], w[k]);
+    }
+
+    element_clear(t);
+    element_clear(c);
+    poly_free(inv_fact, m);
+}
+
+// Weights of the small domains, computed on first use and kept for the life
+// of the process. They belong to the first pairing that asks; any other
+// pairing gets NULL and computes its own.
+static struct {
+    pairing_ptr pairing;
+    element_t *w[POLY_SMALL + 1];
+} small_w;
+static pthread_mutex_t small_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static element_t *small_weights(int m, pairing_t pairing)
+{
+    pthread_mutex_lock(&small_lock);
+    if (!small_w.pairing)
+        small_w.pairing = pairing;
+    element_t *w = NULL;
+    if (small_w.pairing == pairing)
+    {
+        if (!small_w.w[m])
+        {
+            small_w.w[m] = malloc(sizeof(element_t) * m);
+            domain_weights(small_w.w[m], m, pairing);
+        }
+        w = small_w.w[m];
+    }
+    pthread_mutex_unlock(&small_lock);
+    return w;
+}
+
+void qap_lagrange_at(element_t *L, int m, element_t tau, pairing_t pairing)
+{
+    // L_k(τ) = w_k·∏_{l≠k}(τ − x_l) with x_k = k+1; the product is
+    // prefix·suffix. Small domains reuse cached weights and stack scratch.
+    element_t suf_small[POLY_SMALL + 1];
+    int small = m <= POLY_SMALL;
+    element_t *w = small ? small_weights(m, pairing) : NULL;
+    int own_w = !w;
+    if (own_w)
+    {
+        w = malloc(sizeof(element_t) * m);
+        domain_weights(w, m, pairing);
+    }
+    // suf[k] = ∏_{l≥k}(τ − x_l)
+    element_t *suf = small ? suf_small : malloc(sizeof(element_t) * (m + 1));
+    element_t t, pre;
+    element_init_Zr(t, pairing);
+    element_init_Zr(pre, pairing);
+
+    element_init_Zr(suf[m], pairing);
+    element_set1(suf[m]);
+    for (int k = m - 1; k >= 0; k--)
+    {
+        element_init_Zr(suf[k], pairing);
+        element_set_si(t, k + 1);
+        element_sub(t, tau, t);
+        element_mul(suf[k], suf[k + 1], t);
+    }
+
+    element_set1(pre);
+    for (int k = 0; k < m; k++)
+    {
+        element_init_Zr(L[k], pairing);
+        element_mul(L[k], pre, suf[k + 1]);
+        element_mul(L[k], L[k], w[k]);
+        element_set_si(t, k + 1);
+        element_sub(t, tau, t);
+        element_mul(pre, pre, t);
+    }
+
+    element_clear(t);
+    element_clear(pre);
+    for (int k = 0; k <= m; k++)
+        element_clear(suf[k]);
+    if (!small)
+        free(suf);
+    if (own_w)
+        poly_free(w, m);
+}
+
+typedef struct {
+    element_t *a, *b, *part;
+    int n;
+} dot_job_t;
+
+static void dot_task(int chunk, int worker, void *ctx)
+{
+    (void)worker;
+    dot_job_t *job = (dot_job_t *)ctx;
+    int lo = chunk * DOT_CHUNK;
+    int hi = (lo + DOT_CHUNK < job->n ? lo + DOT_CHUNK : job->n);
+    element_t t;
+    element_init_same_as(t, job->part[chunk]);
+    element_set0(job->part[chunk]);
+    for (int i = lo; i < hi; i++)
+    {
+        element_mul(t, job->a[i], job->b[i]);
+        element_add(job->part[chunk], job->part[chunk], t);
+    }
+    element_clear(t);
+}
+
+void qap_inner_product(pool_t *pool, element_t out, element_t *a, element_t *b,
+                       int n, pairing_t pairing)
+{
+    int nc = (n + DOT_CHUNK - 1) / DOT_CHUNK;
+    dot_job_t job = {.a = a, .b = b, .n = n, .part = poly_alloc(nc, pairing)};
+    pool_for(pool, nc, dot_task, &job);
+    element_set0(out);
+    for (int c = 0; c < nc; c++)
+        element_add(out, out, job.part[c]);
+    poly_free(job.part, nc);
+}
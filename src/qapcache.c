@@ -0,0 +1,245 @@
+// src/qapcache.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <gmp.h>
+#include <pbc/pbc.h>
+#include "../include/qapcache.h"
+#include "../include/sha256.h"
+#include "../include/poly.h"
+
+#define QAP_CACHE_HEADER (4 + 4 * 4 + 32)
+
+static size_t zr_bytes(pairing_t pairing)
+{
+    element_t e;
+    element_init_Zr(e, pairing);
+    size_t len = (size_t)element_length_in_bytes(e);
+    element_clear(e);
+    return len;
+}
+
+static void put_u32(sha256_t *s, uint32_t v)
+{
+    unsigned char b[4] = {(unsigned char)(v >> 24), (unsigned char)(v >> 16),
+                          (unsigned char)(v >> 8), (unsigned char)v};
+    sha256_update(s, b, 4);
+}
+
+void qap_circuit_hash(unsigned char out[32], const r1cs_t *r, pairing_t pairing)
+{
+    sha256_t s;
+    sha256_init(&s);
+    sha256_update(&s, QAP_CACHE_MAGIC, 4);
+    put_u32(&s, QAP_CACHE_VERSION);
+
+    size_t rlen = (mpz_sizeinbase(pairing->r, 2) + 7) / 8;
+    unsigned char *rb = malloc(rlen);
+    mpz_export(rb, NULL, 1, 1, 0, 0, pairing->r);
+    put_u32(&s, (uint32_t)rlen);
+    sha256_update(&s, rb, rlen);
+    free(rb);
+
+    put_u32(&s, r->n_vars);
+    put_u32(&s, r->n_cons);
+    size_t elem = zr_bytes(pairing);
+    unsigned char *buf = malloc(elem);
+    element_t **mats[3] = {r->A, r->B, r->C};
+    for (int w = 0; w < 3; w++)
+        for (int k = 0; k < r->n_cons; k++)
+            for (int j = 0; j < r->n_vars; j++)
+            {
+                if (element_is0(mats[w][k][j]))
+                    continue;
+                put_u32(&s, (uint32_t)w);
+                put_u32(&s, (uint32_t)k);
+                put_u32(&s, (uint32_t)j);
+                element_to_bytes(buf, mats[w][k][j]);
+                sha256_update(&s, buf, elem);
+            }
+    free(buf);
+    sha256_final(&s, out);
+}
+
+char *qap_cache_path(const unsigned char key[32])
+{
+    const char *dir = getenv("GROTH16_QAP_CACHE");
+    if (!dir)
+        dir = ".qap-cache";
+    if (!*dir)
+        return NULL;
+    char *path = malloc(strlen(dir) + 1 + 64 + 5);
+    int off = sprintf(path, "%s/", dir);
+    for (int i = 0; i < 32; i++)
+        off += sprintf(path + off, "%02x", key[i]);
+    strcpy(path + off, ".qap");
+    return path;
+}
+
+int qap_cache_open(qap_cache_t *c, const r1cs_t *r, pairing_t pairing)
+{
+    unsigned char key[32];
+    memset(c, 0, sizeof *c);
+    qap_circuit_hash(key, r, pairing);
+    char *path = qap_cache_path(key);
+    if (!path || access(path, R_OK) != 0)
+    {
+        free(path);
+        return -1;
+    }
+    int rc = io_map_open(&c->map, path);
+    if (rc == 0)
+    {
+        const unsigned char *b = c->map.base;
+        c->n = r->n_vars;
+        c->m = r->n_cons;
+        c->elem = zr_bytes(pairing);
+        c->data = b + QAP_CACHE_HEADER;
+        size_t want = QAP_CACHE_HEADER + (size_t)3 * c->n * c->m * c->elem;
+        if (c->map.size != want || memcmp(b, QAP_CACHE_MAGIC, 4) != 0 ||
+            io_get_u32(b + 4) != QAP_CACHE_VERSION || io_get_u32(b + 8) != (uint32_t)c->n ||
+            io_get_u32(b + 12) != (uint32_t)c->m || io_get_u32(b + 16) != c->elem ||
+            memcmp(b + 20, key, 32) != 0)
+        {
+            fprintf(stderr, "Ignoring stale or truncated QAP cache '%s'\n", path);
+            qap_cache_close(c);
+            rc = -1;
+        }
+    }
+    free(path);
+    return rc;
+}
+
+void qap_cache_close(qap_cache_t *c)
+{
+    io_map_close(&c->map);
+    c->data = NULL;
+}
+
+void qap_cache_column(element_t *out, const qap_cache_t *c, int j, int which,
+                      pairing_t pairing)
+{
+    const unsigned char *p = c->data + ((size_t)3 * j + which) * c->m * c->elem;
+    for (int k = 0; k < c->m; k++)
+    {
+        element_init_Zr(out[k], pairing);
+        element_from_bytes(out[k], (unsigned char *)p + (size_t)k * c->elem);
+    }
+}
+
+typedef struct {
+    const qap_cache_t *c;
+    element_ptr tau;
+    element_t *val[3];
+    element_t **coef; // per-worker scratch, m slots each
+    pairing_ptr pairing;
+} cache_eval_t;
+
+// task = 3·column + matrix, matching the file order
+static void cache_eval_task(int task, int worker, void *ctx)
+{
+    cache_eval_t *job = (cache_eval_t *)ctx;
+    element_t *coef = job->coef[worker];
+    qap_cache_column(coef, job->c, task / 3, task % 3, job->pairing);
+    poly_eval(job->val[task % 3][task / 3], coef, job->c->m, job->tau);
+    for (int k = 0; k < job->c->m; k++)
+        element_clear(coef[k]);
+}
+
+void qap_cache_eval(pool_t *pool, const qap_cache_t *c, element_t tau,
+                    element_t *valA, element_t *valB, element_t *valC,
+                    pairing_t pairing)
+{
+    for (int j = 0; j < c->n; j++)
+    {
+        element_init_Zr(valA[j], pairing);
+        element_init_Zr(valB[j], pairing);
+        element_init_Zr(valC[j], pairing);
+    }
+    int nw = pool_size(pool);
+    cache_eval_t job = {.c = c, .tau = tau, .val = {valA, valB, valC},
+                        .pairing = pairing};
+    job.coef = malloc(sizeof(element_t *) * nw);
+    for (int w = 0; w < nw; w++)
+        job.coef[w] = malloc(sizeof(element_t) * (c->m > 0 ? c->m : 1));
+    pool_for(pool, 3 * c->n, cache_eval_task, &job);
+    for (int w = 0; w < nw; w++)
+        free(job.coef[w]);
+    free(job.coef);
+}
+
+int qap_cache_begin(qap_cache_writer_t *w, const r1cs_t *r, pairing_t pairing)
+{
+    unsigned char key[32];
+    memset(w, 0, sizeof *w);
+    qap_circuit_hash(key, r, pairing);
+    w->path = qap_cache_path(key);
+    if (!w->path)
+        return -1;
+    char *slash = strrchr(w->path, '/');
+    *slash = '\0';
+    if (mkdir(w->path, 0755) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Cannot create QAP cache dir '%s': %s\n", w->path, strerror(errno));
+        free(w->path);
+        w->path = NULL;
+        return -1;
+    }
+    *slash = '/';
+    w->tmp = malloc(strlen(w->path) + 32);
+    sprintf(w->tmp, "%s.%ld.tmp", w->path, (long)getpid());
+    w->f = fopen(w->tmp, "wb");
+    if (!w->f)
+    {
+        fprintf(stderr, "Error opening '%s' for write: %s\n", w->tmp, strerror(errno));
+        free(w->path);
+        free(w->tmp);
+        w->path = w->tmp = NULL;
+        return -1;
+    }
+    w->n = r->n_vars;
+    w->m = r->n_cons;
+    w->err = write_exact(w->f, QAP_CACHE_MAGIC, 4) || write_u32(w->f, QAP_CACHE_VERSION) ||
+             write_u32(w->f, w->n) || write_u32(w->f, w->m) ||
+             write_u32(w->f, (uint32_t)zr_bytes(pairing)) || write_exact(w->f, key, 32);
+    return 0;
+}
+
+void qap_cache_append(qap_cache_writer_t *w, element_t *A, element_t *B, element_t *C)
+{
+    element_t *col[3] = {A, B, C};
+    unsigned char buf[256];
+    for (int x = 0; x < 3 && !w->err; x++)
+        for (int k = 0; k < w->m && !w->err; k++)
+        {
+            int len = element_length_in_bytes(col[x][k]);
+            if (len > (int)sizeof buf)
+            {
+                w->err = 1;
+                break;
+            }
+            element_to_bytes(buf, col[x][k]);
+            w->err = write_exact(w->f, buf, len);
+        }
+    w->next++;
+}
+
+int qap_cache_finish(qap_cache_writer_t *w)
+{
+    int err = w->err || w->next != w->n;
+    if (fclose(w->f) != 0)
+        err = 1;
+    if (!err && rename(w->tmp, w->path) != 0)
+        err = 1;
+    if (err)
+    {
+        fprintf(stderr, "Error writing QAP cache '%s'\n", w->path);
+        unlink(w->tmp);
+    }
+    free(w->path);
+    free(w->tmp);
+    return err ? -1 : 0;
+}
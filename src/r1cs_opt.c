@@ -0,0 +1,392 @@
+// src/r1cs_opt.c
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pbc/pbc.h>
+#include "../include/r1cs_opt.h"
+#include "../include/fmt.h"
+
+int r1cs_opt_requested(void)
+{
+    const char *s = getenv("GROTH16_R1CS_OPT");
+    return s && *s && strcmp(s, "0") != 0;
+}
+
+static element_t **matrix(r1cs_t *r, int which)
+{
+    return which == 0 ? r->A : (which == 1 ? r->B : r->C);
+}
+
+// nonzero only at wire 0 (or all zero)
+static int row_is_const(element_t *row, int n)
+{
+    for (int j = 1; j < n; j++)
+        if (!element_is0(row[j]))
+            return 0;
+    return 1;
+}
+
+static int row_is_zero(element_t *row, int n)
+{
+    return element_is0(row[0]) && row_is_const(row, n);
+}
+
+static int rows_equal(element_t *a, element_t *b, int n)
+{
+    for (int j = 0; j < n; j++)
+        if (element_cmp(a[j], b[j]))
+            return 0;
+    return 1;
+}
+
+// L = b0·A − C when B is constant, a0·B − C when A is; 0 if not linear
+static int linear_form(r1cs_t *r, int c, element_t *L)
+{
+    int n = r->n_vars;
+    element_t *lhs, *k;
+    if (row_is_const(r->B[c], n))
+        lhs = r->A[c], k = &r->B[c][0];
+    else if (row_is_const(r->A[c], n))
+        lhs = r->B[c], k = &r->A[c][0];
+    else
+        return 0;
+    for (int j = 0; j < n; j++)
+    {
+        element_mul(L[j], *k, lhs[j]);
+        element_sub(L[j], L[j], r->C[c][j]);
+    }
+    return 1;
+}
+
+// rows among the live constraints (other than skip) that mention wire j
+static int occurrences(r1cs_t *r, const char *alive, int skip, int j)
+{
+    int cnt = 0;
+    for (int c = 0; c < r->n_cons; c++)
+    {
+        if (!alive[c] || c == skip)
+            continue;
+        for (int w = 0; w < 3; w++)
+            if (!element_is0(matrix(r, w)[c][j]))
+            {
+                cnt++;
+                break;
+            }
+    }
+    return cnt;
+}
+
+// Solve L·w = 0 for wire p and substitute it into every other live row.
+static void substitute(r1cs_t *r, const char *alive, int skip, int p, element_t *L,
+                       pairing_t pairing)
+{
+    int n = r->n_vars;
+    element_t inv, f, t;
+    element_init_Zr(inv, pairing);
+    element_init_Zr(f, pairing);
+    element_init_Zr(t, pairing);
+    // w_p = Σ_{j≠p} s_j·w_j with s_j = −L_j / L_p; store s in L
+    element_invert(inv, L[p]);
+    element_neg(inv, inv);
+    for (int j = 0; j < n; j++)
+        if (j != p)
+            element_mul(L[j], L[j], inv);
+
+    for (int c = 0; c < r->n_cons; c++)
+    {
+        if (!alive[c] || c == skip)
+            continue;
+        for (int w = 0; w < 3; w++)
+        {
+            element_t *row = matrix(r, w)[c];
+            if (element_is0(row[p]))
+                continue;
+            element_set(f, row[p]);
+            for (int j = 0; j < n; j++)
+            {
+                if (j == p || element_is0(L[j]))
+                    continue;
+                element_mul(t, f, L[j]);
+                element_add(row[j], row[j], t);
+            }
+            element_set0(row[p]);
+        }
+    }
+    element_clear(inv);
+    element_clear(f);
+    element_clear(t);
+}
+
+// substituting a row that mentions a public wire would move it into A or B
+static int touches_public(r1cs_t *r, element_t *L)
+{
+    for (int j = r->n_vars - r->n_pub; j < r->n_vars; j++)
+        if (!element_is0(L[j]))
+            return 1;
+    return 0;
+}
+
+static void eliminate_linear(r1cs_t *r, char *alive, r1cs_opt_stats_t *st, pairing_t pairing)
+{
+    int n = r->n_vars, live = r->n_cons;
+    element_t *L = (element_t *)malloc(sizeof(element_t) * n);
+    for (int j = 0; j < n; j++)
+        element_init_Zr(L[j], pairing);
+
+    int changed = 1;
+    while (changed && live > 1)
+    {
+        changed = 0;
+        for (int c = 0; c < r->n_cons && live > 1; c++)
+        {
+            if (!alive[c] || !linear_form(r, c, L) || touches_public(r, L))
+                continue;
+            // sparsest pivot keeps the fill-in down
+            int p = -1, best = 0;
+            for (int j = 1; j < n; j++)
+            {
+                if (element_is0(L[j]))
+                    continue;
+                int occ = occurrences(r, alive, c, j);
+                if (p < 0 || occ < best)
+                    p = j, best = occ;
+            }
+            if (p < 0)
+            {
+                // 0 = 0 goes; k = 0 with k ≠ 0 is unsatisfiable and stays
+                if (element_is0(L[0]))
+                {
+                    alive[c] = 0;
+                    live--;
+                    st->dup_cons++;
+                    changed = 1;
+                }
+                continue;
+            }
+            substitute(r, alive, c, p, L, pairing);
+            alive[c] = 0;
+            live--;
+            st->linear++;
+            changed = 1;
+        }
+    }
+
+    for (int j = 0; j < n; j++)
+        element_clear(L[j]);
+    free(L);
+}
+
+static void drop_duplicate_rows(r1cs_t *r, char *alive, r1cs_opt_stats_t *st)
+{
+    int n = r->n_vars, live = 0;
+    for (int c = 0; c < r->n_cons; c++)
+        live += alive[c];
+    for (int c = 0; c < r->n_cons && live > 1; c++)
+    {
+        if (!alive[c])
+            continue;
+        int empty = (row_is_zero(r->A[c], n) || row_is_zero(r->B[c], n)) &&
+                    row_is_zero(r->C[c], n);
+        int dup = 0;
+        for (int e = 0; e < c && !empty && !dup; e++)
+            dup = alive[e] && rows_equal(r->A[c], r->A[e], n) &&
+                  rows_equal(r->B[c], r->B[e], n) && rows_equal(r->C[c], r->C[e], n);
+        if (empty || dup)
+        {
+            alive[c] = 0;
+            live--;
+            st->dup_cons++;
+        }
+    }
+}
+
+typedef struct {
+    uint64_t h;
+    int j;
+} col_key_t;
+
+static int cmp_col_key(const void *a, const void *b)
+{
+    const col_key_t *x = (const col_key_t *)a, *y = (const col_key_t *)b;
+    if (x->h != y->h)
+        return x->h < y->h ? -1 : 1;
+    return x->j - y->j;
+}
+
+static uint64_t column_hash(r1cs_t *r, const char *alive, int j)
+{
+    uint64_t h = 14695981039346656037ULL;
+    unsigned char buf[512];
+    for (int w = 0; w < 3; w++)
+        for (int c = 0; c < r->n_cons; c++)
+        {
+            element_ptr e = matrix(r, w)[c][j];
+            if (!alive[c] || element_is0(e))
+                continue;
+            int len = element_length_in_bytes(e);
+            unsigned char *p = len <= (int)sizeof buf ? buf : malloc(len);
+            element_to_bytes(p, e);
+            h = (h ^ (uint64_t)(3 * c + w)) * 1099511628211ULL;
+            for (int i = 0; i < len; i++)
+                h = (h ^ p[i]) * 1099511628211ULL;
+            if (p != buf)
+                free(p);
+        }
+    return h;
+}
+
+static int columns_equal(r1cs_t *r, const char *alive, int a, int b)
+{
+    for (int w = 0; w < 3; w++)
+        for (int c = 0; c < r->n_cons; c++)
+            if (alive[c] && element_cmp(matrix(r, w)[c][a], matrix(r, w)[c][b]))
+                return 0;
+    return 1;
+}
+
+// map[j]: new wire index, or -1; returns the new wire count
+static int plan_columns(r1cs_t *r, const char *alive, int *map, r1cs_opt_stats_t *st)
+{
+    int n = r->n_vars, pub = r->n_vars - r->n_pub;
+    col_key_t *key = (col_key_t *)malloc(sizeof(col_key_t) * n);
+    int nk = 0;
+    for (int j = 1; j < pub; j++)
+    {
+        int used = 0;
+        for (int w = 0; w < 3 && !used; w++)
+            for (int c = 0; c < r->n_cons && !used; c++)
+                used = alive[c] && !element_is0(matrix(r, w)[c][j]);
+        if (!used)
+        {
+            map[j] = -1;
+            st->dead_wires++;
+            continue;
+        }
+        key[nk].h = column_hash(r, alive, j);
+        key[nk].j = j;
+        nk++;
+    }
+    qsort(key, nk, sizeof(col_key_t), cmp_col_key);
+
+    // representative = lowest index of each class; numbering keeps wire order
+    int *rep = (int *)malloc(sizeof(int) * n);
+    for (int j = 0; j < n; j++)
+        rep[j] = j;
+    for (int a = 0; a < nk; a++)
+        for (int b = a + 1; b < nk && key[b].h == key[a].h; b++)
+            if (rep[key[b].j] == key[b].j && columns_equal(r, alive, key[a].j, key[b].j))
+            {
+                rep[key[b].j] = rep[key[a].j];
+                st->merged++;
+            }
+
+    int out = 1;
+    map[0] = 0;
+    for (int j = 1; j < n; j++)
+    {
+        if (map[j] == -1 && rep[j] == j)
+            continue;
+        map[j] = (rep[j] == j ? out++ : map[rep[j]]);
+    }
+    free(rep);
+    free(key);
+    return out;
+}
+
+void r1cs_optimize(r1cs_t *r, int **map_out, r1cs_opt_stats_t *st_out, pairing_t pairing)
+{
+    int m = r->n_cons, n = r->n_vars;
+    r1cs_opt_stats_t st;
+    memset(&st, 0, sizeof st);
+    st.cons_in = m;
+    st.vars_in = n;
+
+    char *alive = (char *)malloc(m);
+    memset(alive, 1, m);
+    eliminate_linear(r, alive, &st, pairing);
+    drop_duplicate_rows(r, alive, &st);
+
+    int *map = (int *)malloc(sizeof(int) * n);
+    for (int j = 0; j < n; j++)
+        map[j] = 0;
+    int n_out = plan_columns(r, alive, map, &st);
+
+    // --- compact rows and columns ---
+    int m_out = 0;
+    for (int c = 0; c < m; c++)
+    {
+        for (int w = 0; w < 3; w++)
+        {
+            element_t *row = matrix(r, w)[c];
+            element_t *nrow = NULL;
+            if (alive[c])
+            {
+                nrow = (element_t *)malloc(sizeof(element_t) * n_out);
+                for (int k = 0; k < n_out; k++)
+                    element_init_Zr(nrow[k], pairing);
+                for (int j = 0; j < n; j++)
+                    if (map[j] >= 0)
+                        element_set(nrow[map[j]], row[j]); // merged columns are equal
+                matrix(r, w)[m_out] = nrow;
+            }
+            for (int j = 0; j < n; j++)
+                element_clear(row[j]);
+            free(row);
+        }
+        if (alive[c])
+            m_out++;
+    }
+    r->n_cons = m_out;
+    r->n_vars = n_out;
+    free(alive);
+
+    st.cons_out = m_out;
+    st.vars_out = n_out;
+    if (st_out)
+        *st_out = st;
+    if (map_out)
+        *map_out = map;
+    else
+        free(map);
+}
+
+void r1cs_remap_witness(element_t *out, int n_out, const int *map,
+                        element_t *in, int n_in, pairing_t pairing)
+{
+    for (int k = 0; k < n_out; k++)
+    {
+        element_init_Zr(out[k], pairing);
+        element_set0(out[k]);
+    }
+    for (int j = 0; j < n_in; j++)
+        if (map[j] >= 0)
+            element_add(out[map[j]], out[map[j]], in[j]);
+}
+
+void r1cs_maybe_optimize(r1cs_t *r, element_t **wires, pairing_t pairing)
+{
+    if (!r1cs_opt_requested())
+        return;
+    int n_in = r->n_vars, *map;
+    r1cs_opt_stats_t st;
+    r1cs_optimize(r, &map, &st, pairing);
+
+    element_t *w = (element_t *)malloc(sizeof(element_t) * r->n_vars);
+    r1cs_remap_witness(w, r->n_vars, map, *wires, n_in, pairing);
+    for (int j = 0; j < n_in; j++)
+        element_clear((*wires)[j]);
+    free(*wires);
+    free(map);
+    *wires = w;
+
+    fmt_sub("R1CS optimizer");
+    fmt_kv_i("constraints in", st.cons_in);
+    fmt_kv_i("constraints out", st.cons_out);
+    fmt_kv_i("variables in", st.vars_in);
+    fmt_kv_i("variables out", st.vars_out);
+    fmt_kv_i("linear substituted", st.linear);
+    fmt_kv_i("rows dropped", st.dup_cons);
+    fmt_kv_i("wires dropped", st.dead_wires);
+    fmt_kv_i("wires merged", st.merged);
+}
@@ -0,0 +1,432 @@
+// src/r1csfile.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <gmp.h>
+#include <pbc/pbc.h>
+#include "../include/r1csfile.h"
+
+static uint32_t field_n8(pairing_t pairing)
+{
+    size_t bits = mpz_sizeinbase(pairing->r, 2);
+    return (uint32_t)((bits + 63) / 64 * 8);
+}
+
+static int prime_matches(const unsigned char *p, uint32_t n8, pairing_t pairing)
+{
+    mpz_t z;
+    mpz_init(z);
+    mpz_import(z, n8, -1, 1, 0, 0, p);
+    int ok = mpz_cmp(z, pairing->r) == 0;
+    mpz_clear(z);
+    return ok;
+}
+
+// n8-byte little-endian p < prime (same encoding), most significant byte first
+static int below_prime(const unsigned char *p, const unsigned char *prime, uint32_t n8)
+{
+    for (uint32_t i = n8; i-- > 0;)
+        if (p[i] != prime[i])
+            return p[i] < prime[i];
+    return 0;
+}
+
+static void put_field(unsigned char *out, mpz_t z, uint32_t n8)
+{
+    size_t cnt = 0;
+    memset(out, 0, n8);
+    mpz_export(out, &cnt, -1, 1, 0, 0, z);
+}
+
+static int write_field(FILE *f, mpz_t z, uint32_t n8)
+{
+    unsigned char buf[64];
+    put_field(buf, z, n8);
+    return write_exact(f, buf, n8);
+}
+
+static int write_elem_le(FILE *f, element_t e, uint32_t n8, mpz_t tmp)
+{
+    element_to_mpz(tmp, e);
+    return write_field(f, tmp, n8);
+}
+
+// circom numbers the public wires right after the constant (1..n_pub), an
+// r1cs_t puts them last; the files are in circom's order. Wire c of a file
+// is wire from_circom(c) of the r1cs_t.
+static uint32_t from_circom(uint32_t c, uint32_t n, uint32_t n_pub)
+{
+    if (c == 0)
+        return 0;
+    return c <= n_pub ? n - n_pub + (c - 1) : c - n_pub;
+}
+
+static void get_field(element_t out, const unsigned char *p, uint32_t n8)
+{
+    mpz_t z;
+    mpz_init(z);
+    mpz_import(z, n8, -1, 1, 0, 0, p);
+    element_set_mpz(out, z);
+    mpz_clear(z);
+}
+
+// Locate section `type` after the 12-byte preamble; 0 if found.
+static int find_section(const io_map_t *m, uint32_t type, const unsigned char **data,
+                        uint64_t *size)
+{
+    uint32_t ns = io_get_u32le(m->base + 8);
+    size_t off = 12;
+    for (uint32_t s = 0; s < ns; s++)
+    {
+        if (off + 12 > m->size)
+            return -1;
+        uint32_t t = io_get_u32le(m->base + off);
+        uint64_t sz = io_get_u64le(m->base + off + 4);
+        off += 12;
+        if (sz > m->size - off)
+            return -1;
+        if (t == type)
+        {
+            *data = m->base + off;
+            *size = sz;
+            return 0;
+        }
+        off += sz;
+    }
+    return -1;
+}
+
+static int open_mapped(io_map_t *m, const char *path, const char *magic, uint32_t version)
+{
+    if (io_map_open(m, path) != 0)
+        return -1;
+    if (m->size < 12 || memcmp(m->base, magic, 4) != 0 || io_get_u32le(m->base + 4) != version)
+    {
+        fprintf(stderr, "'%s' is not a %s v%u file\n", path, magic, version);
+        io_map_close(m);
+        return -1;
+    }
+    return 0;
+}
+
+int r1cs_file_open(r1cs_file_t *f, const char *path, pairing_t pairing)
+{
+    memset(f, 0, sizeof *f);
+    if (open_mapped(&f->map, path, "r1cs", 1) != 0)
+        return -1;
+    const unsigned char *h, *c;
+    uint64_t hs, cs;
+    if (find_section(&f->map, 1, &h, &hs) != 0 || find_section(&f->map, 2, &c, &cs) != 0 || hs < 4)
+    {
+        fprintf(stderr, "'%s': missing or truncated header/constraint section\n", path);
+        goto fail;
+    }
+    f->n8 = io_get_u32le(h);
+    if (f->n8 != field_n8(pairing) || hs != 4 + (uint64_t)f->n8 + 28)
+    {
+        fprintf(stderr, "'%s': field size %u does not match the pairing\n", path, f->n8);
+        goto fail;
+    }
+    if (!prime_matches(h + 4, f->n8, pairing))
+    {
+        fprintf(stderr, "'%s': prime differs from the pairing's group order\n", path);
+        goto fail;
+    }
+    const unsigned char *prime = h + 4;
+    h += 4 + f->n8;
+    f->n_wires = io_get_u32le(h);
+    f->n_pub_out = io_get_u32le(h + 4);
+    f->n_pub_in = io_get_u32le(h + 8);
+    f->n_prv_in = io_get_u32le(h + 12);
+    f->n_cons = io_get_u32le(h + 24);
+    f->cons = c;
+    if (f->n_cons == 0 || f->n_wires == 0)
+    {
+        fprintf(stderr, "'%s': empty constraint system (%u constraints, %u wires)\n", path,
+                f->n_cons, f->n_wires);
+        goto fail;
+    }
+    if ((uint64_t)f->n_pub_out + f->n_pub_in >= f->n_wires)
+    {
+        fprintf(stderr, "'%s': %u public wires out of %u\n", path, f->n_pub_out + f->n_pub_in,
+                f->n_wires);
+        goto fail;
+    }
+    f->n_pub = f->n_pub_out + f->n_pub_in;
+
+    // one validating pass over the variable-length constraints
+    f->row = (uint64_t *)malloc(sizeof(uint64_t) * (f->n_cons ? f->n_cons : 1));
+    uint64_t off = 0, term = 4 + (uint64_t)f->n8;
+    for (uint32_t k = 0; k < f->n_cons; k++)
+    {
+        f->row[k] = off;
+        for (int w = 0; w < 3; w++)
+        {
+            if (off + 4 > cs)
+                goto bad;
+            uint32_t nt = io_get_u32le(c + off);
+            off += 4;
+            if ((uint64_t)nt * term > cs - off)
+                goto bad;
+            for (uint32_t t = 0; t < nt; t++)
+            {
+                uint32_t j = io_get_u32le(c + off + t * term);
+                if (j >= f->n_wires || !below_prime(c + off + t * term + 4, prime, f->n8))
+                    goto bad;
+                // the verifier adds public inputs on the C side only (IC)
+                if (w < 2 && j >= 1 && j <= f->n_pub)
+                {
+                    fprintf(stderr, "'%s': public wire %u appears in %c of constraint %u\n", path,
+                            j, "AB"[w], k);
+                    goto fail;
+                }
+            }
+            off += nt * term;
+        }
+    }
+    return 0;
+bad:
+    fprintf(stderr, "'%s': malformed constraint section\n", path);
+fail:
+    r1cs_file_close(f);
+    return -1;
+}
+
+void r1cs_file_close(r1cs_file_t *f)
+{
+    free(f->row);
+    f->row = NULL;
+    io_map_close(&f->map);
+}
+
+void r1cs_file_lc(const r1cs_file_t *f, int k, int which, r1cs_lc_view_t *lc)
+{
+    const unsigned char *p = f->cons + f->row[k];
+    uint64_t term = 4 + (uint64_t)f->n8;
+    for (int w = 0; w < which; w++)
+        p += 4 + io_get_u32le(p) * term;
+    lc->n = io_get_u32le(p);
+    lc->n8 = f->n8;
+    lc->terms = p + 4;
+}
+
+uint32_t r1cs_lc_wire(const r1cs_lc_view_t *lc, int t)
+{
+    return io_get_u32le(lc->terms + (size_t)t * (4 + lc->n8));
+}
+
+void r1cs_lc_coef(element_t out, const r1cs_lc_view_t *lc, int t)
+{
+    get_field(out, lc->terms + (size_t)t * (4 + lc->n8) + 4, lc->n8);
+}
+
+void r1cs_file_to_dense(const r1cs_file_t *f, r1cs_t *r, pairing_t pairing)
+{
+    int m = f->n_cons, n = f->n_wires;
+    r->n_cons = m;
+    r->n_pub = (int)f->n_pub;
+    r->n_vars = n;
+    r->A = malloc(sizeof(element_t *) * m);
+    r->B = malloc(sizeof(element_t *) * m);
+    r->C = malloc(sizeof(element_t *) * m);
+    element_t **mats[3] = {r->A, r->B, r->C};
+    r1cs_lc_view_t lc;
+    for (int k = 0; k < m; k++)
+        for (int w = 0; w < 3; w++)
+        {
+            element_t *row = mats[w][k] = malloc(sizeof(element_t) * n);
+            for (int j = 0; j < n; j++)
+            {
+                element_init_Zr(row[j], pairing);
+                element_set0(row[j]);
+            }
+            r1cs_file_lc(f, k, w, &lc);
+            for (uint32_t t = 0; t < lc.n; t++)
+                r1cs_lc_coef(row[from_circom(r1cs_lc_wire(&lc, t), n, f->n_pub)], &lc, t);
+        }
+}
+
+int wtns_file_open(wtns_file_t *w, const char *path, pairing_t pairing)
+{
+    memset(w, 0, sizeof *w);
+    if (open_mapped(&w->map, path, "wtns", 2) != 0)
+        return -1;
+    const unsigned char *h, *v;
+    uint64_t hs, vs;
+    if (find_section(&w->map, 1, &h, &hs) != 0 || find_section(&w->map, 2, &v, &vs) != 0 || hs < 4)
+    {
+        fprintf(stderr, "'%s': missing or truncated sections\n", path);
+        goto fail;
+    }
+    w->n8 = io_get_u32le(h);
+    if (w->n8 != field_n8(pairing) || hs != 4 + (uint64_t)w->n8 + 4 ||
+        !prime_matches(h + 4, w->n8, pairing))
+    {
+        fprintf(stderr, "'%s': field does not match the pairing\n", path);
+        goto fail;
+    }
+    w->n = io_get_u32le(h + 4 + w->n8);
+    if (vs != (uint64_t)w->n * w->n8)
+    {
+        fprintf(stderr, "'%s': expected %u values\n", path, w->n);
+        goto fail;
+    }
+    for (uint32_t i = 0; i < w->n; i++)
+        if (!below_prime(v + (size_t)i * w->n8, h + 4, w->n8))
+        {
+            fprintf(stderr, "'%s': value %u is not below the field order\n", path, i);
+            goto fail;
+        }
+    w->values = v;
+    return 0;
+fail:
+    io_map_close(&w->map);
+    return -1;
+}
+
+void wtns_file_close(wtns_file_t *w)
+{
+    io_map_close(&w->map);
+}
+
+void wtns_file_get(element_t out, const wtns_file_t *w, int i)
+{
+    get_field(out, w->values + (size_t)i * w->n8, w->n8);
+}
+
+static FILE *create(const char *path)
+{
+    FILE *f = fopen(path, "wb");
+    if (!f)
+        fprintf(stderr, "Error opening '%s' for write: %s\n", path, strerror(errno));
+    return f;
+}
+
+static int finish(FILE *f, const char *path, int err)
+{
+    if (fclose(f) != 0)
+        err = 1;
+    if (err)
+        fprintf(stderr, "Error writing '%s'\n", path);
+    return err ? -1 : 0;
+}
+
+int r1cs_file_write(const char *path, const r1cs_t *r, pairing_t pairing)
+{
+    if (r->n_pub >= r->n_vars)
+    {
+        fprintf(stderr, "'%s': %d public wires out of %d\n", path, r->n_pub, r->n_vars);
+        return -1;
+    }
+    FILE *f = create(path);
+    if (!f)
+        return -1;
+    uint32_t n8 = field_n8(pairing);
+    element_t **mats[3] = {r->A, r->B, r->C};
+    uint64_t nnz = 0;
+    for (int k = 0; k < r->n_cons; k++)
+        for (int w = 0; w < 3; w++)
+            for (int j = 0; j < r->n_vars; j++)
+                nnz += !element_is0(mats[w][k][j]);
+    uint64_t cons_size = (uint64_t)r->n_cons * 3 * 4 + nnz * (4 + n8);
+
+    mpz_t z;
+    mpz_init(z);
+    int err = write_exact(f, "r1cs", 4) || write_u32le(f, 1) || write_u32le(f, 3) ||
+              // header
+              write_u32le(f, 1) || write_u64le(f, 4 + n8 + 28) || write_u32le(f, n8) ||
+              write_field(f, pairing->r, n8) || write_u32le(f, r->n_vars) ||
+              write_u32le(f, 0) || write_u32le(f, r->n_pub) || write_u32le(f, 0) ||
+              write_u64le(f, r->n_vars) || write_u32le(f, r->n_cons) ||
+              // constraints
+              write_u32le(f, 2) || write_u64le(f, cons_size);
+    uint32_t n = (uint32_t)r->n_vars, n_pub = (uint32_t)r->n_pub;
+    for (int k = 0; k < r->n_cons && !err; k++)
+        for (int w = 0; w < 3 && !err; w++)
+        {
+            uint32_t nt = 0;
+            for (int j = 0; j < r->n_vars; j++)
+                nt += !element_is0(mats[w][k][j]);
+            err = write_u32le(f, nt);
+            // terms in circom's wire order
+            for (uint32_t c = 0; c < n && !err; c++)
+            {
+                element_ptr e = mats[w][k][from_circom(c, n, n_pub)];
+                if (!element_is0(e))
+                    err = write_u32le(f, c) || write_elem_le(f, e, n8, z);
+            }
+        }
+    // wire → label: the wire's index in the r1cs_t
+    err = err || write_u32le(f, 3) || write_u64le(f, 8 * (uint64_t)n);
+    for (uint32_t c = 0; c < n && !err; c++)
+        err = write_u64le(f, from_circom(c, n, n_pub));
+    mpz_clear(z);
+    return finish(f, path, err);
+}
+
+int wtns_file_write(const char *path, element_t *wires, int n, int n_pub, pairing_t pairing)
+{
+    FILE *f = create(path);
+    if (!f)
+        return -1;
+    uint32_t n8 = field_n8(pairing);
+    mpz_t z;
+    mpz_init(z);
+    int err = write_exact(f, "wtns", 4) || write_u32le(f, 2) || write_u32le(f, 2) ||
+              write_u32le(f, 1) || write_u64le(f, 4 + n8 + 4) || write_u32le(f, n8) ||
+              write_field(f, pairing->r, n8) || write_u32le(f, n) ||
+              write_u32le(f, 2) || write_u64le(f, (uint64_t)n * n8);
+    for (int c = 0; c < n && !err; c++)
+        err = write_elem_le(f, wires[from_circom(c, n, n_pub)], n8, z);
+    mpz_clear(z);
+    return finish(f, path, err);
+}
+
+int r1cs_load_files(const char *r1cs_path, const char *wtns_path, pairing_t pairing,
+                    r1cs_t *r, element_t **wires)
+{
+    r1cs_file_t rf;
+    wtns_file_t wf;
+    if (r1cs_file_open(&rf, r1cs_path, pairing) != 0)
+        return -1;
+    if (wtns_file_open(&wf, wtns_path, pairing) != 0)
+    {
+        r1cs_file_close(&rf);
+        return -1;
+    }
+    int rc = 0;
+    if (wf.n < rf.n_wires)
+    {
+        fprintf(stderr, "'%s' has %u values, '%s' needs %u\n", wtns_path, wf.n, r1cs_path,
+                rf.n_wires);
+        rc = -1;
+    }
+    else
+    {
+        // wire 0 is the constant one; the optimizer and the QAP rely on it
+        element_t one;
+        element_init_Zr(one, pairing);
+        wtns_file_get(one, &wf, 0);
+        if (!element_is1(one))
+        {
+            fprintf(stderr, "'%s': wire 0 must be 1\n", wtns_path);
+            rc = -1;
+        }
+        element_clear(one);
+    }
+    if (rc == 0)
+    {
+        r1cs_file_to_dense(&rf, r, pairing);
+        *wires = malloc(sizeof(element_t) * rf.n_wires);
+        for (uint32_t i = 0; i < rf.n_wires; i++)
+        {
+            element_ptr w = (*wires)[from_circom(i, rf.n_wires, rf.n_pub)];
+            element_init_Zr(w, pairing);
+            wtns_file_get(w, &wf, i);
+        }
+    }
+    wtns_file_close(&wf);
+    r1cs_file_close(&rf);
+    return rc;
+}
@@ -0,0 +1,210 @@
+// src/rng.c
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/random.h>
+#include "../include/sha256.h"
+#include "../include/rng.h"
+
+#define ROTL(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+#define QR(a, b, c, d)                                                                    \
+    do                                                                                    \
+    {                                                                                     \
+        a += b; d ^= a; d = ROTL(d, 16);                                                  \
+        c += d; b ^= c; b = ROTL(b, 12);                                                  \
+        a += b; d ^= a; d = ROTL(d, 8);                                                   \
+        c += d; b ^= c; b = ROTL(b, 7);                                                   \
+    } while (0)
+
+static void wipe(void *p, size_t n)
+{
+    volatile unsigned char *v = p;
+    while (n--)
+        *v++ = 0;
+}
+
+// RFC 8439 block function, nonce 0
+static void chacha20_block(unsigned char out[64], const uint32_t key[8], uint32_t counter)
+{
+    uint32_t in[16] = {0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+                       key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+                       counter, 0, 0, 0};
+    uint32_t x[16];
+    memcpy(x, in, sizeof x);
+    for (int i = 0; i < 10; i++)
+    {
+        QR(x[0], x[4], x[8], x[12]);
+        QR(x[1], x[5], x[9], x[13]);
+        QR(x[2], x[6], x[10], x[14]);
+        QR(x[3], x[7], x[11], x[15]);
+        QR(x[0], x[5], x[10], x[15]);
+        QR(x[1], x[6], x[11], x[12]);
+        QR(x[2], x[7], x[8], x[13]);
+        QR(x[3], x[4], x[9], x[14]);
+    }
+    for (int i = 0; i < 16; i++)
+    {
+        uint32_t v = x[i] + in[i];
+        out[4 * i] = (unsigned char)v;
+        out[4 * i + 1] = (unsigned char)(v >> 8);
+        out[4 * i + 2] = (unsigned char)(v >> 16);
+        out[4 * i + 3] = (unsigned char)(v >> 24);
+    }
+    wipe(x, sizeof x);
+}
+
+static void load_key(uint32_t key[8], const unsigned char *b)
+{
+    for (int i = 0; i < 8; i++)
+        key[i] = (uint32_t)b[4 * i] | (uint32_t)b[4 * i + 1] << 8 |
+                 (uint32_t)b[4 * i + 2] << 16 | (uint32_t)b[4 * i + 3] << 24;
+}
+
+// new buffer; its first 32 bytes become the next key and are erased
+static void refill(rng_t *r)
+{
+    for (uint32_t b = 0; b < RNG_BLOCKS; b++)
+        chacha20_block(r->buf + 64 * b, r->key, b);
+    load_key(r->key, r->buf);
+    wipe(r->buf, 32);
+    r->pos = 32;
+}
+
+void rng_seed(rng_t *r, const unsigned char seed[32])
+{
+    load_key(r->key, seed);
+    r->pos = sizeof r->buf; // refill on first use
+}
+
+int rng_seed_os(rng_t *r)
+{
+    unsigned char seed[32];
+    size_t got = 0;
+    while (got < sizeof seed)
+    {
+        ssize_t k = getrandom(seed + got, sizeof seed - got, 0);
+        if (k < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+        got += (size_t)k;
+    }
+    if (got < sizeof seed)
+    {
+        FILE *f = fopen("/dev/urandom", "rb");
+        int ok = f && fread(seed, 1, sizeof seed, f) == sizeof seed;
+        if (f)
+            fclose(f);
+        if (!ok)
+            return -1;
+    }
+    rng_seed(r, seed);
+    wipe(seed, sizeof seed);
+    return 0;
+}
+
+void rng_wipe(rng_t *r)
+{
+    wipe(r, sizeof *r);
+}
+
+void rng_bytes(rng_t *r, void *out, size_t n)
+{
+    unsigned char *o = out;
+    while (n > 0)
+    {
+        if (r->pos == sizeof r->buf)
+            refill(r);
+        size_t k = sizeof r->buf - r->pos;
+        if (k > n)
+            k = n;
+        memcpy(o, r->buf + r->pos, k);
+        wipe(r->buf + r->pos, k);
+        r->pos += k;
+        o += k;
+        n -= k;
+    }
+}
+
+void rng_mpz(rng_t *r, mpz_t z, mpz_t limit)
+{
+    size_t bits = mpz_sizeinbase(limit, 2);
+    size_t len = (bits + 7) / 8;
+    unsigned char *b = malloc(len);
+    unsigned char top = (unsigned char)(0xff >> (8 * len - bits));
+    do
+    {
+        rng_bytes(r, b, len);
+        b[0] &= top;
+        mpz_import(z, len, 1, 1, 0, 0, b);
+    } while (mpz_cmp(z, limit) >= 0);
+    wipe(b, len);
+    free(b);
+}
+
+void rng_scalars(rng_t *r, element_t *out, int n)
+{
+    mpz_t z;
+    mpz_init(z);
+    for (int i = 0; i < n; i++)
+    {
+        rng_mpz(r, z, out[i]->field->order);
+        element_set_mpz(out[i], z);
+    }
+    mpz_set_ui(z, 0);
+    mpz_clear(z);
+}
+
+static rng_t process_rng;
+static int installed;
+static const char *source;
+
+static void pbc_hook(mpz_t z, mpz_t limit, void *data)
+{
+    rng_mpz((rng_t *)data, z, limit);
+}
+
+int rng_install(void)
+{
+    if (installed)
+        return 0;
+    const char *env = getenv("GROTH16_SEED");
+    if (env && *env)
+    {
+        static const char tag[] = "groth16 rng seed";
+        unsigned char seed[32];
+        sha256_t sh;
+        sha256_init(&sh);
+        sha256_update(&sh, tag, sizeof tag - 1);
+        sha256_update(&sh, env, strlen(env));
+        sha256_final(&sh, seed);
+        rng_seed(&process_rng, seed);
+        wipe(seed, sizeof seed);
+        source = "ChaCha20, GROTH16_SEED (deterministic)";
+    }
+    else
+    {
+        if (rng_seed_os(&process_rng) != 0)
+        {
+            fprintf(stderr, "Error: no OS entropy source for the random generator\n");
+            return -1;
+        }
+        source = "ChaCha20, seeded from OS";
+    }
+    pbc_random_set_function(pbc_hook, &process_rng);
+    installed = 1;
+    return 0;
+}
+
+rng_t *rng_process(void)
+{
+    return &process_rng;
+}
+
+const char *rng_source(void)
+{
+    return installed ? source : "PBC default";
+}
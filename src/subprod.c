@@ -0,0 +1,244 @@
+// src/subprod.c
+#include <stdlib.h>
+#include <gmp.h>
+#include <pbc/pbc.h>
+#include "../include/poly.h"
+#include "../include/subprod.h"
+
+// ranges at most this wide are evaluated directly with Horner
+#define EVAL_LEAF 8
+
+static void build_rec(subprod_tree_t *t, int idx, int lo, int hi, element_t *pts)
+{
+    if (hi - lo == 1)
+    {
+        // leaf: x − τ_lo
+        t->len[idx] = 2;
+        t->node[idx] = poly_alloc(2, t->pairing);
+        element_neg(t->node[idx][0], pts[lo]);
+        element_set1(t->node[idx][1]);
+        return;
+    }
+    int mid = (lo + hi) / 2;
+    build_rec(t, 2 * idx, lo, mid, pts);
+    build_rec(t, 2 * idx + 1, mid, hi, pts);
+
+    t->len[idx] = hi - lo + 1;
+    t->node[idx] = poly_alloc(hi - lo + 1, t->pairing);
+    poly_mul(t->node[idx], t->node[2 * idx], t->len[2 * idx],
+             t->node[2 * idx + 1], t->len[2 * idx + 1], t->pairing);
+}
+
+// p[0..np-1] is already reduced modulo node idx (np ≤ hi − lo)
+static void eval_rec(subprod_tree_t *t, int idx, int lo, int hi,
+                     element_t *p, int np, element_t *pts, element_t *out)
+{
+    if (hi - lo <= EVAL_LEAF)
+    {
+        for (int k = lo; k < hi; k++)
+        {
+            element_set0(out[k]);
+            for (int i = np - 1; i >= 0; i--)
+            {
+                element_mul(out[k], out[k], pts[k]);
+                element_add(out[k], out[k], p[i]);
+            }
+        }
+        return;
+    }
+    int mid = (lo + hi) / 2;
+    int bounds[3] = {lo, mid, hi};
+    for (int c = 0; c < 2; c++)
+    {
+        int child = 2 * idx + c;
+        int nr = t->len[child] - 1;
+        element_t *rem = poly_alloc(nr, t->pairing);
+        if (np < t->len[child])
+        {
+            for (int i = 0; i < np; i++)
+                element_set(rem[i], p[i]);
+        }
+        else
+        {
+            element_t *q = poly_alloc(np - nr, t->pairing);
+            poly_divrem(q, rem, p, np, t->node[child], t->len[child], t->pairing);
+            poly_free(q, np - nr);
+        }
+        eval_rec(t, child, bounds[c], bounds[c + 1], rem, (np < nr ? np : nr), pts, out);
+        poly_free(rem, nr);
+    }
+}
+
+void subprod_multi_eval(element_t *out, element_t *coeffs, int n, subprod_tree_t *t)
+{
+    int m = t->m;
+    for (int k = 0; k < m; k++)
+        element_init_Zr(out[k], t->pairing);
+    if (m == 0)
+        return;
+
+    int np = (n < m ? n : m);
+    element_t *p = poly_alloc(np > 0 ? np : 1, t->pairing);
+    if (n > m)
+    {
+        element_t *q = poly_alloc(n - m, t->pairing);
+        poly_divrem(q, p, coeffs, n, t->node[1], t->len[1], t->pairing);
+        poly_free(q, n - m);
+    }
+    else
+    {
+        for (int i = 0; i < n; i++)
+            element_set(p[i], coeffs[i]);
+    }
+    eval_rec(t, 1, 0, m, p, np, t->pts, out);
+
+    poly_free(p, np > 0 ? np : 1);
+}
+
+// res[0..hi-lo-1] (zeroed) = Σ_k w_k ∏_{j≠k} (x − τ_j) over the node's range.
+// Returns 0 when every weight in range is zero, so sparse R1CS columns
+// skip most of the tree.
+static int interp_rec(subprod_tree_t *t, int idx, int lo, int hi,
+                      element_t *w, element_t *res)
+{
+    if (hi - lo == 1)
+    {
+        element_set(res[0], w[lo]);
+        return !element_is0(w[lo]);
+    }
+    int mid = (lo + hi) / 2;
+    int nl = mid - lo, nr = hi - mid;
+    element_t *L = poly_alloc(nl, t->pairing);
+    element_t *R = poly_alloc(nr, t->pairing);
+    int fl = interp_rec(t, 2 * idx, lo, mid, w, L);
+    int fr = interp_rec(t, 2 * idx + 1, mid, hi, w, R);
+
+    if (fl || fr)
+    {
+        element_t *tmp = poly_alloc(hi - lo, t->pairing);
+        if (fl)
+        {
+            poly_mul(tmp, L, nl, t->node[2 * idx + 1], nr + 1, t->pairing);
+            for (int i = 0; i < hi - lo; i++)
+                element_add(res[i], res[i], tmp[i]);
+        }
+        if (fr)
+        {
+            poly_mul(tmp, R, nr, t->node[2 * idx], nl + 1, t->pairing);
+            for (int i = 0; i < hi - lo; i++)
+                element_add(res[i], res[i], tmp[i]);
+        }
+        poly_free(tmp, hi - lo);
+    }
+    poly_free(L, nl);
+    poly_free(R, nr);
+    return fl || fr;
+}
+
+void subprod_interpolate(element_t *out, element_t *eval, subprod_tree_t *t)
+{
+    int m = t->m;
+    for (int i = 0; i < m; i++)
+    {
+        element_init_Zr(out[i], t->pairing);
+        element_set0(out[i]);
+    }
+    if (m == 0)
+        return;
+
+    element_t *w = poly_alloc(m, t->pairing);
+    for (int k = 0; k < m; k++)
+        element_mul(w[k], eval[k], t->inv_w[k]);
+    interp_rec(t, 1, 0, m, w, out);
+    poly_free(w, m);
+}
+
+void subprod_Z(element_t *out, subprod_tree_t *t)
+{
+    for (int i = 0; i <= t->m; i++)
+    {
+        element_init_Zr(out[i], t->pairing);
+        if (t->m == 0)
+            element_set1(out[i]);
+        else
+            element_set(out[i], t->node[1][i]);
+    }
+}
+
+void subprod_Z_range(element_t *out, int m, pairing_t pairing)
+{
+    if (m > POLY_SMALL)
+    {
+        element_t *pts = poly_alloc(m, pairing);
+        for (int k = 0; k < m; k++)
+            element_set_si(pts[k], k + 1);
+        subprod_tree_t t;
+        subprod_tree_init(&t, pts, m, pairing);
+        subprod_Z(out, &t);
+        subprod_tree_clear(&t);
+        poly_free(pts, m);
+        return;
+    }
+    // integer coefficients (at most log2(m!) bits), multiplied out one
+    // factor x − k at a time and reduced once at the end
+    mpz_t c[POLY_SMALL + 1], t;
+    mpz_init(t);
+    for (int i = 0; i <= m; i++)
+        mpz_init_set_ui(c[i], i == 0);
+    for (int k = 1; k <= m; k++)
+    {
+        for (int i = k; i > 0; i--)
+        {
+            mpz_mul_ui(t, c[i], (unsigned long)k);
+            mpz_sub(c[i], c[i - 1], t);
+        }
+        mpz_mul_ui(c[0], c[0], (unsigned long)k);
+        mpz_neg(c[0], c[0]);
+    }
+    for (int i = 0; i <= m; i++)
+    {
+        mpz_mod(c[i], c[i], pairing->r);
+        element_init_Zr(out[i], pairing);
+        element_set_mpz(out[i], c[i]);
+        mpz_clear(c[i]);
+    }
+    mpz_clear(t);
+}
+
+void subprod_tree_init(subprod_tree_t *t, element_t *pts, int m, pairing_t pairing)
+{
+    t->m = m;
+    t->pairing = pairing;
+    t->node = calloc(4 * (size_t)m + 2, sizeof(element_t *));
+    t->len = calloc(4 * (size_t)m + 2, sizeof(int));
+    t->inv_w = NULL;
+    t->pts = poly_alloc(m, pairing);
+    for (int i = 0; i < m; i++)
+        element_set(t->pts[i], pts[i]);
+    if (m == 0)
+        return;
+    build_rec(t, 1, 0, m, pts);
+
+    // barycentric weights 1 / Z'(τ_k)
+    element_t *dZ = poly_alloc(m, pairing);
+    for (int i = 0; i < m; i++)
+        element_mul_si(dZ[i], t->node[1][i + 1], i + 1);
+    element_t *vals = malloc(sizeof(element_t) * m);
+    subprod_multi_eval(vals, dZ, m, t);
+    t->inv_w = poly_alloc(m, pairing);
+    poly_batch_invert(t->inv_w, vals, m, pairing);
+    poly_free(vals, m);
+    poly_free(dZ, m);
+}
+
+void subprod_tree_clear(subprod_tree_t *t)
+{
+    for (int i = 0; i < 4 * t->m + 2; i++)
+        if (t->node[i])
+            poly_free(t->node[i], t->len[i]);
+    free(t->node);
+    free(t->len);
+    poly_free(t->pts, t->m);
+    if (t->inv_w)
+        poly_free(t->inv_w, t->m);
+}
@@ -3,101 +3,271 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
-#include <arpa/inet.h>   // ntohl
 #include <pbc/pbc.h>
 #include "fmt.h"
+#include "io.h"
+#include "subprod.h"
+#include "msm.h"
+#include "ptau.h"
+#include "agg.h"
+#include "rng.h"
+#include "ptcheck.h"
+#include "sha256.h"
+#include "bundle.h"
+#include "ic.h"
+#include "keys.h"
+#include "memstat.h"
+#include "metrics.h"
 
-// robust readers -------------------------------------------------
-static int read_exact(FILE *f, void *p, size_t n) {
-    unsigned char *b = (unsigned char*)p;
-    size_t rtot = 0;
-    while (rtot < n) {
-        size_t r = fread(b + rtot, 1, n - rtot, f);
-        if (r == 0) return -1;
-        rtot += r;
-    }
-    return 0;
+// g2Z = g2^{Z(τ)} from the m+1 powers g2^{τ^i} (initialized here)
+static void compute_g2Z(element_t g2Z, element_t *g2_tau, uint32_t m, pairing_t pairing) {
+    element_t *coef = (element_t*)malloc(sizeof(element_t)*(m+1));
+    subprod_Z_range(coef, (int)m, pairing); // Z(x) = ∏_{k=1}^m (x − k), degree m
+    element_init_G2(g2Z, pairing);
+    msm(g2Z, g2_tau, coef, (int)m + 1); // Σ coef[i]·g2^{τ^i}, bucketed
+    for (uint32_t i = 0; i <= m; i++) element_clear(coef[i]);
+    free(coef);
 }
-static int read_u32(FILE *f, uint32_t *out_host) {
-    uint32_t v_be;
-    if (read_exact(f, &v_be, 4) != 0) return -1;
-    *out_host = ntohl(v_be);
+
+// --vk key: the verifier section of a key file (keys.h), which pins the
+// tail every proof, bundle record or aggregate must carry; without it that
+// tail is taken from the proof on trust
+static int load_vk(const char *path, vk_t *vk, unsigned char id[32], pairing_t pairing) {
+    pk_t pk;
+    if (keys_read(path, &pk, vk, pairing) != 0) return -1;
+    keys_clear(&pk, NULL);
+    if (vk->m == 0) { fprintf(stderr, "Error: '%s' has no verifier section\n", path); keys_clear(&pk, vk); return -1; }
+    keys_vk_id(vk, id);
     return 0;
 }
-static int read_elem_G1(FILE *f, pairing_t pairing, element_t out) {
-    uint32_t len; if (read_u32(f, &len) != 0) return -1;
-    unsigned char *buf = (unsigned char*)malloc(len);
-    if (!buf) return -1;
-    if (read_exact(f, buf, len) != 0) { free(buf); return -1; }
-    element_init_G1(out, pairing);
-    element_from_bytes(out, buf);
-    free(buf);
-    return 0;
+
+// 1 if the tail (g2, g2^{τ^0..τ^m}, IC) is the key's
+static int tail_is_vk(const vk_t *vk, element_t g2, int m, element_t *g2_tau, int l, element_t *ic) {
+    int same = element_cmp(g2, (element_ptr)vk->g2) == 0 && m == vk->m && l == vk->l;
+    for (int i = 0; i <= m && same; i++) same = element_cmp(g2_tau[i], vk->g2_tau[i]) == 0;
+    for (int i = 0; i < l && same; i++) same = element_cmp(ic[i], vk->ic[i]) == 0;
+    return same;
 }
-static int read_elem_G2(FILE *f, pairing_t pairing, element_t out) {
-    uint32_t len; if (read_u32(f, &len) != 0) return -1;
-    unsigned char *buf = (unsigned char*)malloc(len);
-    if (!buf) return -1;
-    if (read_exact(f, buf, len) != 0) { free(buf); return -1; }
-    element_init_G2(out, pairing);
-    element_from_bytes(out, buf);
-    free(buf);
+
+// --aggregate: one check for a whole batch of proofs (see agg.h)
+static int verify_aggregate(const char *agg_path, char **ptau_paths, const vk_t *vk, pairing_t pairing) {
+    uint64_t t_req = metrics_now(), t0 = t_req;
+    agg_t a;
+    if (agg_read(agg_path, &a, pairing) != 0) return 1;
+    ptau_t pt[2], *srs[2] = {&pt[0], &pt[1]};
+    if (ptau_open(&pt[0], ptau_paths[0], pairing) != 0) { agg_clear(&a); return 1; }
+    if (ptau_open(&pt[1], ptau_paths[1], pairing) != 0) { ptau_close(&pt[0]); agg_clear(&a); return 1; }
+    metrics_since(METRICS_DECODE, t0);
+    fmt_kv_s("aggregate file", agg_path);
+    fmt_kv_i("proofs", a.n_proofs);
+    fmt_kv_i("rounds", a.rounds);
+    fmt_kv_i("m", a.m);
+    fmt_kv_i("public inputs", a.l);
+    if (vk && !tail_is_vk(vk, a.g2, a.m, a.g2_tau, a.l, a.ic)) {
+        fprintf(stderr, "Error: '%s' aggregates proofs made under another key\n", agg_path);
+        fmt_kv_s("result", "REJECT");
+        ptau_close(&pt[0]); ptau_close(&pt[1]); agg_clear(&a);
+        return 1;
+    }
+
+    element_t g2Z;
+    t0 = metrics_now();
+    compute_g2Z(g2Z, a.g2_tau, (uint32_t)a.m, pairing);
+    metrics_since(METRICS_MSM, t0);
+    fmt_sub("Aggregate check");
+    fmt_kv_e("g2^{Z(τ)}", g2Z);
+    fmt_kv_i("pairings", 17);
+    t0 = metrics_now();
+    int ok = agg_verify(&a, g2Z, srs, pairing); // mostly its pairings; the MSMs are small
+    metrics_since(METRICS_PAIRING, t0);
+    metrics_since(METRICS_REQUEST, t_req);
+    metrics_add(METRICS_REQUESTS, 1); metrics_add(ok ? METRICS_ACCEPTED : METRICS_REJECTED, 1);
+    fmt_kv_s("result", ok ? "ACCEPT" : "REJECT");
+
+    element_clear(g2Z);
+    ptau_close(&pt[0]); ptau_close(&pt[1]);
+    agg_clear(&a);
+    return ok ? 0 : 1;
+}
+
+// e(A, B) == e(C, g2)·e(H, g2Z)
+static int proof_ok(element_t A, element_t B, element_t C, element_t H, element_t g2, element_t g2Z, pairing_t pairing) {
+    element_t L, R, T;
+    element_init_GT(L, pairing); element_init_GT(R, pairing); element_init_GT(T, pairing);
+    pairing_apply(L, A, B, pairing);
+    pairing_apply(R, C, g2, pairing);
+    pairing_apply(T, H, g2Z, pairing);
+    element_mul(R, R, T);
+    int ok = (element_cmp(L, R) == 0);
+    element_clear(L); element_clear(R); element_clear(T);
+    return ok;
+}
+
+// u32 l | l framed elements at *p into (*v)[0..l), which grows (new slots
+// initialized like proto)
+static int get_vec(const unsigned char **p, const unsigned char *end, element_t **v, int *cap, int *l, element_t proto) {
+    if (end - *p < 4) return -1;
+    uint32_t n = io_get_u32(*p); *p += 4;
+    if (n > (uint64_t)(end - *p) / 4) return -1;
+    if ((int)n > *cap) {
+        *v = (element_t*)realloc(*v, sizeof(element_t)*n);
+        for (; *cap < (int)n; (*cap)++) element_init_same_as((*v)[*cap], proto);
+    }
+    for (uint32_t i = 0; i < n; i++) if (io_get_point((*v)[i], p, end) != 0) return -1;
+    *l = (int)n;
     return 0;
 }
-// ----------------------------------------------------------------
-
-// Compute Z(x) = ∏_{k=1}^m (x - k) coefficients in F_r (degree m)
-static void compute_Z_coeffs(element_t *coef, int m, pairing_t pairing) {
-    // coef has length m+1, initialize to 0; start with P(x) = 1
-    for (int i = 0; i <= m; i++) { element_init_Zr(coef[i], pairing); element_set0(coef[i]); }
-    element_set1(coef[0]); // degree 0: 1
-
-    // temp buffer
-    element_t *next = (element_t*)malloc(sizeof(element_t)*(m+1));
-    for (int step = 1; step <= m; step++) {
-        for (int i = 0; i <= m; i++) { element_init_Zr(next[i], pairing); element_set0(next[i]); }
-        // multiply current poly by (x - step)
-        // next[i+1] += coef[i]      (× x)
-        for (int i = 0; i <= m-1; i++) element_add(next[i+1], next[i+1], coef[i]);
-        // next[i] += coef[i] * (-step)
-        element_t negk; element_init_Zr(negk, pairing); element_set_si(negk, -step);
-        for (int i = 0; i <= m; i++) {
-            if (!element_is0(coef[i])) {
-                element_t t; element_init_Zr(t, pairing);
-                element_mul(t, coef[i], negk);
-                element_add(next[i], next[i], t);
-                element_clear(t);
-            }
+
+// tail g2 | m | g2^{τ^0..τ^m} | l | IC of a bundle record: g2, g2^{Z(τ)}
+// (both initialized) and the IC tables; its points queued on chk
+static int load_tail(const unsigned char *p, const unsigned char *end, element_t g2, element_t g2Z, ic_table_t *ict, ptcheck_t *chk, pairing_t pairing) {
+    if (io_get_point(g2, &p, end) != 0 || end - p < 4) return -1;
+    uint32_t m = io_get_u32(p); p += 4;
+    if ((uint64_t)(m + 1ULL) * 4 > (uint64_t)(end - p)) return -1;
+    element_t *g2_tau = (element_t*)malloc(sizeof(element_t)*(m+1));
+    uint32_t i = 0; int err = 0;
+    for (; i <= m && !err; i++) { element_init_G2(g2_tau[i], pairing); err = io_get_point(g2_tau[i], &p, end); }
+    element_t *ic = NULL, proto; int cap = 0, l = 0;
+    element_init_G1(proto, pairing);
+    if (!err) err = get_vec(&p, end, &ic, &cap, &l, proto);
+    if (!err && p != end) err = -1;
+    if (!err) {
+        element_t z;
+        ptcheck_add(chk, g2);
+        ptcheck_add_vec(chk, g2_tau, (int)m + 1);
+        ptcheck_add_vec(chk, ic, l);
+        compute_g2Z(z, g2_tau, m, pairing);
+        element_set(g2Z, z); element_clear(z);
+        ic_table_init(ict, ic, l, pairing);
+    }
+    while (i > 0) element_clear(g2_tau[--i]);
+    while (cap > 0) element_clear(ic[--cap]);
+    free(g2_tau); free(ic); element_clear(proto);
+    return err ? -1 : 0;
+}
+
+// --bundle: every proof of a bundle, streamed from the mapping. The tail is
+// looked up, checked against its circuit id and decoded, with g2^{Z(τ)} and
+// the IC tables, only when the id changes, and the points of the whole
+// bundle share one subgroup check (ptcheck.h). With pin (a --vk circuit id)
+// records under any other id are rejected. A bundle without records verifies
+// nothing and is rejected.
+static int verify_bundle(const char *path, const unsigned char *pin, pairing_t pairing) {
+    bundle_t b;
+    if (bundle_open(&b, path) != 0) return 1;
+    fmt_kv_s("bundle", path);
+    fmt_kv_i("proofs", b.n);
+
+    element_t A, B, C, H, g2, g2Z, vkx, zr;
+    element_init_G1(A, pairing); element_init_G2(B, pairing); element_init_G1(C, pairing); element_init_G1(H, pairing);
+    element_init_G2(g2, pairing); element_init_G2(g2Z, pairing); element_init_G1(vkx, pairing); element_init_Zr(zr, pairing);
+    element_t *x = NULL; int xcap = 0, l = 0;
+    ic_table_t ict = {0, NULL};
+    ptcheck_t chk; ptcheck_init(&chk, pairing);
+    unsigned char id[32], h[32];
+    int have = 0, circuits = 0, accepted = 0, rejected = 0, pairings = 0;
+    metrics_queue(b.n);
+    for (int i = 0; i < b.n; i++) {
+        uint64_t t_req = metrics_now(), t0 = t_req;
+        bundle_entry_t e; const unsigned char *rec;
+        bundle_get(&b, i, &e, &rec);
+        const unsigned char *p = rec, *end = rec + e.length, *tail;
+        size_t tail_len;
+        sha256_t sh;
+        sha256_init(&sh); sha256_update(&sh, rec, e.length); sha256_final(&sh, h);
+        int ok = memcmp(h, e.hash, 32) == 0 && (!pin || memcmp(e.id, pin, 32) == 0);
+        ok = ok && io_get_point(A, &p, end) == 0 && io_get_point(B, &p, end) == 0
+                && io_get_point(C, &p, end) == 0 && io_get_point(H, &p, end) == 0
+                && get_vec(&p, end, &x, &xcap, &l, zr) == 0 && p == end;
+        if (ok && (!have || memcmp(id, e.id, 32) != 0)) {
+            ic_table_clear(&ict);
+            have = bundle_find_tail(&b, e.id, &tail, &tail_len) == 0;
+            if (have) { sha256_init(&sh); sha256_update(&sh, tail, tail_len); sha256_final(&sh, h); have = memcmp(h, e.id, 32) == 0; }
+            have = have && load_tail(tail, tail + tail_len, g2, g2Z, &ict, &chk, pairing) == 0;
+            if (have) { memcpy(id, e.id, 32); circuits++; }
+            ok = have;
+        }
+        ok = ok && l == ict.l;
+        metrics_since(METRICS_DECODE, t0); // with the tail and g2^{Z(τ)} when the circuit changes
+        if (ok) {
+            ptcheck_add(&chk, A); ptcheck_add(&chk, B); ptcheck_add(&chk, C); ptcheck_add(&chk, H);
+            t0 = metrics_now();
+            ic_table_eval(vkx, &ict, x);
+            element_mul(C, C, vkx);
+            metrics_since(METRICS_MSM, t0);
+            t0 = metrics_now();
+            ok = proof_ok(A, B, C, H, g2, g2Z, pairing);
+            metrics_since(METRICS_PAIRING, t0);
+            pairings += 3;
         }
-        element_clear(negk);
-        // swap into coef
-        for (int i = 0; i <= m; i++) { element_set(coef[i], next[i]); element_clear(next[i]); }
+        if (ok) accepted++;
+        else if (rejected++ < 8) fprintf(stderr, "proof %d: REJECT\n", i);
+        metrics_since(METRICS_REQUEST, t_req);
+        metrics_add(METRICS_REQUESTS, 1); metrics_add(METRICS_BYTES, (long long)e.length);
+        metrics_add(ok ? METRICS_ACCEPTED : METRICS_REJECTED, 1);
+        metrics_queue_add(-1);
     }
-    free(next);
+    int in_group = ptcheck_run(&chk, rng_process());
+    fmt_kv_i("circuits", circuits);
+    fmt_kv_i("pairings", pairings);
+    fmt_kv_i("accepted", accepted);
+    fmt_kv_i("rejected", rejected);
+    fmt_kv_s("points", in_group ? "in G1/G2" : "OUTSIDE G1/G2");
+    if (b.n == 0) fprintf(stderr, "Error: '%s' holds no proofs\n", path);
+    int ok = in_group && rejected == 0 && accepted > 0;
+    fmt_kv_s("result", ok ? "ACCEPT" : "REJECT");
+
+    ptcheck_clear(&chk);
+    ic_table_clear(&ict);
+    while (xcap > 0) element_clear(x[--xcap]);
+    free(x);
+    element_clear(A); element_clear(B); element_clear(C); element_clear(H); element_clear(g2); element_clear(g2Z);
+    element_clear(vkx); element_clear(zr);
+    bundle_close(&b);
+    return ok ? 0 : 1;
 }
 
 int main(int argc, char **argv) {
+    memstat_init();
+    metrics_init("verifier");
     if (argc < 2) {
-        fprintf(stderr, "Usage: %s pairing.params [proof.bin]\n", argv[0]);
+        fprintf(stderr, "Usage: %s pairing.params [--vk key] [proof.bin [x_1 … x_l]]\n"
+                        "       %s pairing.params [--vk key] --aggregate proofs.agg pot1.ptau pot2.ptau\n"
+                        "       %s pairing.params [--vk key] --bundle proofs.g16b\n", argv[0], argv[0], argv[0]);
         return 1;
     }
+    const char *vk_path = NULL;
+    if (argc > 3 && strcmp(argv[2], "--vk") == 0) {
+        vk_path = argv[3];
+        argv[3] = argv[1]; argv[2] = argv[0]; argv += 2; argc -= 2;
+    }
     const char *proof_path = (argc > 2 ? argv[2] : "proof_demo.bin");
 
     fmt_init(1, stdout);
     fmt_banner("Verifier (QAP-aware demo)");
+    if (rng_install() != 0) return 1;
 
-    // --- load pairing params ---
-    FILE *fp = fopen(argv[1], "r");
-    if (!fp) { fprintf(stderr, "Error opening '%s': %s\n", argv[1], strerror(errno)); return 1; }
-    fseek(fp, 0, SEEK_END); long sz = ftell(fp); fseek(fp, 0, SEEK_SET);
-    char *pbuf = (char*)malloc(sz + 1);
-    size_t rd = fread(pbuf, 1, sz, fp); fclose(fp);
-    if (rd != (size_t)sz) { fprintf(stderr, "Short read: %zu of %ld\n", rd, sz); free(pbuf); return 1; }
-    pbuf[sz] = '\0';
-    pbc_param_t params; pbc_param_init_set_buf(params, pbuf, sz + 1); free(pbuf);
-    pairing_t pairing; pairing_init_pbc_param(pairing, params);
+    // --- load pairing params (or a pairing snapshot) ---
+    pairing_t pairing;
+    if (load_pairing(argv[1], pairing) != 0) return 1;
+    fmt_pairing(pairing);
+    vk_t vk; unsigned char vk_id[32];
+    if (vk_path && load_vk(vk_path, &vk, vk_id, pairing) != 0) return 1;
+    fmt_kv_s("verifying key", vk_path ? vk_path : "from the proof (unpinned)");
+    if (argc > 2 && strcmp(argv[2], "--aggregate") == 0) {
+        if (argc < 6) { fprintf(stderr, "Usage: %s pairing.params [--vk key] --aggregate proofs.agg pot1.ptau pot2.ptau\n", argv[0]); return 1; }
+        memstat_stage("aggregate");
+        return verify_aggregate(argv[3], argv + 4, vk_path ? &vk : NULL, pairing);
+    }
+    if (argc > 2 && strcmp(argv[2], "--bundle") == 0) {
+        if (argc < 4) { fprintf(stderr, "Usage: %s pairing.params [--vk key] --bundle proofs.g16b\n", argv[0]); return 1; }
+        memstat_stage("bundle");
+        return verify_bundle(argv[3], vk_path ? vk_id : NULL, pairing);
+    }
 
     // --- read proof file contents ---
+    memstat_stage("read");
+    uint64_t t_req = metrics_now(), t0 = t_req;
     FILE *pf = fopen(proof_path, "rb");
     if (!pf) { fprintf(stderr, "Error opening '%s': %s\n", proof_path, strerror(errno)); return 1; }
 
@@ -106,16 +276,48 @@ int main(int argc, char **argv) {
     if (read_elem_G2(pf, pairing, piB) != 0) { fprintf(stderr, "read piB failed\n"); fclose(pf); return 1; }
     if (read_elem_G1(pf, pairing, piC) != 0) { fprintf(stderr, "read piC failed\n"); fclose(pf); return 1; }
     if (read_elem_G1(pf, pairing, piH) != 0) { fprintf(stderr, "read piH failed\n"); fclose(pf); return 1; }
+
+    // public inputs x_1..x_l: the statement this proof is for
+    uint32_t l;
+    if (read_u32(pf, &l) != 0 || l > (1u << 20) || !io_fits(pf, l, pairing_length_in_bytes_Zr(pairing))) { fprintf(stderr, "read public-input count failed\n"); fclose(pf); return 1; }
+    element_t *x = (element_t*)malloc(sizeof(element_t)*(l ? l : 1));
+    for (uint32_t i = 0; i < l; i++) {
+        if (read_elem_Zr(pf, pairing, x[i]) != 0) { fprintf(stderr, "read public input failed\n"); fclose(pf); return 1; }
+    }
     if (read_elem_G2(pf, pairing, g2)  != 0) { fprintf(stderr, "read g2 failed\n");  fclose(pf); return 1; }
 
     uint32_t m;
-    if (read_u32(pf, &m) != 0) { fprintf(stderr, "read m failed\n"); fclose(pf); return 1; }
+    if (read_u32(pf, &m) != 0 || !io_fits(pf, m + 1ULL, pairing_length_in_bytes_G2(pairing))) {
+        fprintf(stderr, "read m failed: more powers than the file holds\n"); fclose(pf); return 1;
+    }
 
     element_t *g2_tau = (element_t*)malloc(sizeof(element_t)*(m+1));
     for (uint32_t i = 0; i <= m; i++) {
         if (read_elem_G2(pf, pairing, g2_tau[i]) != 0) { fprintf(stderr, "read g2^tau^i failed\n"); fclose(pf); return 1; }
     }
+    uint32_t l_ic;
+    if (read_u32(pf, &l_ic) != 0 || l_ic != l) { fprintf(stderr, "read IC failed: the key has another number of public inputs\n"); fclose(pf); return 1; }
+    element_t *ic = (element_t*)malloc(sizeof(element_t)*(l ? l : 1));
+    for (uint32_t i = 0; i < l; i++) {
+        if (read_elem_G1(pf, pairing, ic[i]) != 0) { fprintf(stderr, "read IC failed\n"); fclose(pf); return 1; }
+    }
+    long proof_bytes = ftell(pf);
     fclose(pf);
+    if (vk_path && !tail_is_vk(&vk, g2, (int)m, g2_tau, (int)l, ic)) {
+        fprintf(stderr, "Error: '%s' was made under another key than '%s'\n", proof_path, vk_path);
+        fmt_kv_s("result", "REJECT");
+        return 1;
+    }
+
+    // --- untrusted points: one batched subgroup check for the whole file ---
+    ptcheck_t chk; ptcheck_init(&chk, pairing);
+    ptcheck_add(&chk, piA); ptcheck_add(&chk, piB); ptcheck_add(&chk, piC); ptcheck_add(&chk, piH); ptcheck_add(&chk, g2);
+    ptcheck_add_vec(&chk, g2_tau, (int)m + 1);
+    ptcheck_add_vec(&chk, ic, (int)l);
+    int in_group = ptcheck_run(&chk, rng_process());
+    ptcheck_clear(&chk);
+    if (!in_group) { fprintf(stderr, "Error: '%s' holds points outside G1/G2\n", proof_path); return 1; }
+    metrics_since(METRICS_DECODE, t0);
 
     fmt_kv_s("proof file", proof_path);
     fmt_sub("Proof elements (decoded)");
@@ -126,42 +328,67 @@ int main(int argc, char **argv) {
     fmt_kv_e("g2  (G2)", g2);
     fmt_kv_i("m", m);
 
-    // --- build g2^{Z(τ)} from g2^{τ^i} and Z(x) coefficients ---
-    element_t *coef = (element_t*)malloc(sizeof(element_t)*(m+1));
-    compute_Z_coeffs(coef, (int)m, pairing);
-
-    element_t g2Z; element_init_G2(g2Z, pairing); element_set0(g2Z); // identity
-    element_t tmp; element_init_G2(tmp, pairing);
-    for (uint32_t i = 0; i <= m; i++) {
-        // tmp = (g2^{τ^i})^{coef[i]}
-        element_pow_zn(tmp, g2_tau[i], coef[i]);
-        element_add(g2Z, g2Z, tmp); // additive notation → sums exponents
+    // --- statement: the proof's public inputs, optionally against the claim
+    //     on the command line ---
+    fmt_sub("Public inputs");
+    int claim_ok = 1;
+    if (argc > 3 && argc - 3 != (int)l) { fprintf(stderr, "Error: the proof has %u public inputs, %d given\n", l, argc - 3); claim_ok = 0; }
+    element_t want; element_init_Zr(want, pairing);
+    for (uint32_t i = 0; i < l; i++) {
+        printf("  input %u\n", i);
+        fmt_kv_e("    x", x[i]);
+        if (claim_ok && argc > 3) {
+            element_set_str(want, argv[3 + i], 10);
+            if (element_cmp(want, x[i]) != 0) { fprintf(stderr, "Error: public input %u differs from the claim %s\n", i, argv[3 + i]); claim_ok = 0; }
+        }
     }
+    element_clear(want);
+    if (argc > 3) fmt_kv_s("claim", claim_ok ? "matches" : "MISMATCH");
+
+    // --- build g2^{Z(τ)} from g2^{τ^i} and Z(x) coefficients ---
+    memstat_stage("check");
+    element_t g2Z;
+    t0 = metrics_now();
+    compute_g2Z(g2Z, g2_tau, m, pairing);
+    uint64_t msm_ns = metrics_now() - t0;
     fmt_sub("Reconstructed");
     fmt_kv_e("g2^{Z(τ)}", g2Z);
 
-    // --- pairing check: e(piA,piB) ?= e(piC,g2) * e(piH, g2^{Z(τ)}) ---
+    // --- vk_x = Σ x_i·IC_i: the public part of C(τ) (one MSM; see ic.h) ---
+    element_t vkx; element_init_G1(vkx, pairing);
+    t0 = metrics_now();
+    msm(vkx, ic, x, (int)l);
+    metrics_record(METRICS_MSM, msm_ns + (metrics_now() - t0), 1);
+    fmt_kv_e("vk_x = Σ x_i·IC_i", vkx);
+    element_mul(vkx, vkx, piC);
+
+    // --- pairing check: e(piA,piB) ?= e(piC + vk_x,g2) * e(piH, g2^{Z(τ)}) ---
     fmt_sub("Pairing check");
     element_t L, R, T;
     element_init_GT(L, pairing); element_init_GT(R, pairing); element_init_GT(T, pairing);
+    t0 = metrics_now();
     pairing_apply(L, piA, piB, pairing);
-    pairing_apply(R, piC, g2, pairing);
+    pairing_apply(R, vkx, g2, pairing);
     pairing_apply(T, piH, g2Z, pairing);
     element_mul(R, R, T);
+    metrics_since(METRICS_PAIRING, t0);
 
     fmt_kv_e("e(piA, piB)", L);
     fmt_kv_e("RHS",          R);
 
-    int ok = (element_cmp(L, R) == 0);
+    int ok = (element_cmp(L, R) == 0) && claim_ok;
     fmt_kv_s("result", ok ? "ACCEPT" : "REJECT");
+    metrics_since(METRICS_REQUEST, t_req);
+    metrics_add(METRICS_REQUESTS, 1); metrics_add(METRICS_BYTES, proof_bytes);
+    metrics_add(ok ? METRICS_ACCEPTED : METRICS_REJECTED, 1);
 
     // cleanup (demo)
-    element_clear(L); element_clear(R); element_clear(T);
-    element_clear(g2Z); element_clear(tmp);
+    element_clear(L); element_clear(R); element_clear(T); element_clear(vkx);
+    for (uint32_t i = 0; i < l; i++) { element_clear(x[i]); element_clear(ic[i]); }
+    free(x); free(ic);
+    element_clear(g2Z);
     for (uint32_t i = 0; i <= m; i++) element_clear(g2_tau[i]);
     free(g2_tau);
-    for (uint32_t i = 0; i <= m; i++) element_clear(coef[i]);
-    free(coef);
     element_clear(piA); element_clear(piB); element_clear(piC); element_clear(piH); element_clear(g2);
     return ok ? 0 : 1;
 }
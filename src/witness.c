@@ -0,0 +1,126 @@
+// src/witness.c
+#include <stdlib.h>
+#include <gmp.h>
+#include <pbc/pbc.h>
+#include "../include/circuit.h"
+#include "../include/witness.h"
+
+// fewest powers per block worth a seeding exponentiation
+#define WITNESS_MIN_BLOCK 64
+
+typedef struct {
+    int d, nb;
+    element_t *coeffs, *w;
+    element_ptr x;
+    element_t *carry; // block totals, then their inclusive prefix sums
+} scan_job_t;
+
+static void block_range(const scan_job_t *job, int b, int *lo, int *hi)
+{
+    long long n = job->d + 1;
+    *lo = (int)(n * b / job->nb);
+    *hi = (int)(n * (b + 1) / job->nb);
+}
+
+// block-local powers from x^lo and sums from 0
+static void scan_local(int b, int worker, void *ctx)
+{
+    (void)worker;
+    scan_job_t *job = (scan_job_t *)ctx;
+    element_t *w = job->w;
+    int off = job->d + 1, lo, hi;
+    block_range(job, b, &lo, &hi);
+
+    mpz_t e;
+    mpz_init_set_si(e, lo);
+    element_pow_mpz(w[lo], job->x, e);
+    mpz_clear(e);
+    for (int i = lo + 1; i < hi; i++)
+        element_mul(w[i], w[i - 1], job->x);
+
+    element_t term;
+    element_init_same_as(term, w[lo]);
+    element_mul(w[off + lo], job->coeffs[lo], w[lo]);
+    for (int i = lo + 1; i < hi; i++)
+    {
+        element_mul(term, job->coeffs[i], w[i]);
+        element_add(w[off + i], w[off + i - 1], term);
+    }
+    element_clear(term);
+    element_set(job->carry[b], w[off + hi - 1]);
+}
+
+static void scan_carry(int b, int worker, void *ctx)
+{
+    (void)worker;
+    scan_job_t *job = (scan_job_t *)ctx;
+    int off = job->d + 1, lo, hi;
+    block_range(job, b + 1, &lo, &hi);
+    for (int i = lo; i < hi; i++)
+        element_add(job->w[off + i], job->w[off + i], job->carry[b]);
+}
+
+void witness_build(pool_t *pool, int d, element_t *coeffs, element_t x,
+                   element_t **wires, pairing_t pairing)
+{
+    int nb = (d + 1) / WITNESS_MIN_BLOCK;
+    if (nb > 4 * pool_size(pool))
+        nb = 4 * pool_size(pool);
+    if (nb <= 1 || pool_size(pool) == 1)
+    {
+        build_witness(d, coeffs, x, wires, pairing);
+        return;
+    }
+
+    int n_vars, n_cons;
+    r1cs_shape(d, &n_vars, &n_cons);
+    *wires = malloc(sizeof(element_t) * n_vars);
+    for (int i = 0; i < n_vars; i++)
+        element_init_Zr((*wires)[i], pairing);
+
+    scan_job_t job = {.d = d, .nb = nb, .coeffs = coeffs, .w = *wires, .x = x};
+    job.carry = malloc(sizeof(element_t) * nb);
+    for (int b = 0; b < nb; b++)
+        element_init_Zr(job.carry[b], pairing);
+
+    pool_for(pool, nb, scan_local, &job);
+    for (int b = 1; b < nb; b++)
+        element_add(job.carry[b], job.carry[b], job.carry[b - 1]);
+    pool_for(pool, nb - 1, scan_carry, &job);
+
+    for (int b = 0; b < nb; b++)
+        element_clear(job.carry[b]);
+    free(job.carry);
+
+    int pub = r1cs_pub(d);
+    element_set((*wires)[pub], x);
+    element_set((*wires)[pub + 1], (*wires)[d + 1 + d]);
+}
+
+typedef struct {
+    int d;
+    element_t *coeffs, *xs;
+    element_t **wires;
+    pairing_ptr pairing;
+} batch_job_t;
+
+static void batch_task(int k, int worker, void *ctx)
+{
+    (void)worker;
+    batch_job_t *job = (batch_job_t *)ctx;
+    build_witness(job->d, job->coeffs, job->xs[k], &job->wires[k], job->pairing);
+}
+
+void witness_build_batch(pool_t *pool, int d, element_t *coeffs, element_t *xs,
+                         int nx, element_t **wires, pairing_t pairing)
+{
+    if (nx >= pool_size(pool))
+    {
+        batch_job_t job = {.d = d, .coeffs = coeffs, .xs = xs, .wires = wires,
+                           .pairing = pairing};
+        pool_for(pool, nx, batch_task, &job);
+        return;
+    }
+    for (int k = 0; k < nx; k++)
+        witness_build(pool, d, coeffs, xs[k], &wires[k], pairing);
+}
@@ -0,0 +1,145 @@
+#!/bin/sh
+# Negative checks: an honest aggregate or bundle must ACCEPT, and aggregates
+# of bad proofs, tampered aggregates and bundles, shared SRSs, points
+# outside G1 and proofs checked against another run's verifying key must not.
+# Run by `make check` from the repository root.
+set -e
+ROOT=$(pwd)
+PARAM=$ROOT/src/a.param
+T=$(mktemp -d)
+trap 'rm -rf "$T"' EXIT
+cd "$T"
+export NO_COLOR=1 GROTH16_QAP_CACHE=
+fail=0
+
+# big-endian u32 at byte offset $2 of file $1
+u32() { od -An -tu1 -j "$2" -N4 "$1" | awk '{ print (($1 * 256 + $2) * 256 + $3) * 256 + $4 }'; }
+
+# byte offset of framed element $3 (0-based) of the run starting at offset $2
+elem() {
+    off=$2 k=$3
+    while [ "$k" -gt 0 ]; do
+        off=$((off + 4 + $(u32 "$1" "$off")))
+        k=$((k - 1))
+    done
+    echo "$off"
+}
+
+# swap framed elements $2 and $3 of file $1 (same encoded length)
+swap() {
+    len=$(u32 "$1" "$2")
+    dd if="$1" of=a.tmp bs=1 skip="$2" count=$((len + 4)) 2>/dev/null
+    dd if="$1" of=b.tmp bs=1 skip="$3" count=$((len + 4)) 2>/dev/null
+    dd if=b.tmp of="$1" bs=1 seek="$2" conv=notrunc 2>/dev/null
+    dd if=a.tmp of="$1" bs=1 seek="$3" conv=notrunc 2>/dev/null
+}
+
+# expect NAME ok|fail CMD…: whether CMD exits 0
+expect() {
+    name=$1 want=$2
+    shift 2
+    if "$@" >out.log 2>&1; then got=ok; else got=fail; fi
+    if [ "$got" = "$want" ]; then
+        echo "ok    $name"
+    else
+        echo "FAIL  $name (expected $want)"
+        cat out.log
+        fail=1
+    fi
+}
+
+printf '2 15\n1 6\n3 36\n0 3\n4 75\n' >w.txt
+"$ROOT/pot" "$PARAM" 16 p1.ptau >/dev/null
+"$ROOT/pot" "$PARAM" 16 p2.ptau >/dev/null
+"$ROOT/pot" --contribute "$PARAM" p1.ptau p3.ptau >/dev/null
+"$ROOT/prover" --batch w.txt "$PARAM" 3 3 2 0 1 -o pb >/dev/null
+
+expect "honest aggregate accepts" ok sh -c \
+    "'$ROOT/aggregate' '$PARAM' p1.ptau p2.ptau ok.agg pb_*.bin && \
+     '$ROOT/verifier' '$PARAM' --aggregate ok.agg p1.ptau p2.ptau"
+expect "one powers file twice is refused" fail \
+    "$ROOT/aggregate" "$PARAM" p1.ptau p1.ptau bad.agg pb_0.bin pb_1.bin
+expect "a file derived from the other is refused" fail \
+    "$ROOT/aggregate" "$PARAM" p1.ptau p3.ptau bad.agg pb_0.bin pb_1.bin
+expect "keys swapped at verification rejects" fail \
+    "$ROOT/verifier" "$PARAM" --aggregate ok.agg p2.ptau p1.ptau
+
+# proofs 0 and 1 trade piC: both fail the Groth16 check
+cp pb_0.bin c0.bin
+cp pb_1.bin c1.bin
+dd if=pb_1.bin of=c0.bin bs=1 skip="$(elem pb_1.bin 0 2)" seek="$(elem pb_0.bin 0 2)" \
+    count=$((4 + $(u32 pb_1.bin "$(elem pb_1.bin 0 2)"))) conv=notrunc 2>/dev/null
+dd if=pb_0.bin of=c1.bin bs=1 skip="$(elem pb_0.bin 0 2)" seek="$(elem pb_1.bin 0 2)" \
+    count=$((4 + $(u32 pb_0.bin "$(elem pb_0.bin 0 2)"))) conv=notrunc 2>/dev/null
+"$ROOT/aggregate" "$PARAM" p1.ptau p2.ptau bad.agg c0.bin c1.bin pb_2.bin >/dev/null
+expect "aggregate of bad proofs rejects" fail \
+    "$ROOT/verifier" "$PARAM" --aggregate bad.agg p1.ptau p2.ptau
+
+# aggregate header: 6 × u32, then g2, g2^{τ^0..m}, IC_1..l, x, commitments
+m=$(u32 ok.agg 16)
+l=$(u32 ok.agg 20)
+n=$(u32 ok.agg 8)
+x0=$((1 + m + 1 + l))
+cp ok.agg t.agg
+swap t.agg "$(elem t.agg 24 $x0)" "$(elem t.agg 24 $((x0 + l)))"
+expect "aggregate with swapped statements rejects" fail \
+    "$ROOT/verifier" "$PARAM" --aggregate t.agg p1.ptau p2.ptau
+zc=$((x0 + n * l + 6))
+cp ok.agg t.agg
+swap t.agg "$(elem t.agg 24 $zc)" "$(elem t.agg 24 $((zc + 1)))"
+expect "aggregate with swapped C and H sums rejects" fail \
+    "$ROOT/verifier" "$PARAM" --aggregate t.agg p1.ptau p2.ptau
+cp ok.agg t.agg
+swap t.agg "$(elem t.agg 24 $((zc - 6)))" "$(elem t.agg 24 $((zc - 5)))"
+expect "aggregate with swapped key commitments rejects" fail \
+    "$ROOT/verifier" "$PARAM" --aggregate t.agg p1.ptau p2.ptau
+
+# bundle: the shared tail comes first, right after the 8-byte header
+"$ROOT/prover" --batch w.txt "$PARAM" 3 3 2 0 1 --bundle ok.g16b >/dev/null
+expect "honest bundle accepts" ok "$ROOT/verifier" "$PARAM" --bundle ok.g16b
+cp ok.g16b t.g16b
+printf 'Z' | dd of=t.g16b bs=1 seek=40 conv=notrunc 2>/dev/null
+expect "bundle with a tampered tail rejects" fail "$ROOT/verifier" "$PARAM" --bundle t.g16b
+# header, then a trailer for no tails at 8 and no records at 8
+printf 'G16B\0\0\0\2\0\0\0\0\0\0\0\10\0\0\0\0\0\0\0\0\0\0\0\10\0\0\0\0G16X' >empty.g16b
+expect "bundle without proofs rejects" fail "$ROOT/verifier" "$PARAM" --bundle empty.g16b
+
+# --vk pins the verifying key; another run samples another τ
+"$ROOT/prover" --batch w.txt "$PARAM" 3 3 2 0 1 --bundle vk.g16b --vk run.key >/dev/null
+"$ROOT/prover" --batch w.txt "$PARAM" 3 3 2 0 1 -o pv --vk other.key >/dev/null
+expect "bundle under its key accepts" ok "$ROOT/verifier" "$PARAM" --vk run.key --bundle vk.g16b
+expect "bundle under another key rejects" fail \
+    "$ROOT/verifier" "$PARAM" --vk other.key --bundle vk.g16b
+expect "bundle without proofs rejects under a key" fail \
+    "$ROOT/verifier" "$PARAM" --vk run.key --bundle empty.g16b
+expect "proof under its key accepts" ok "$ROOT/verifier" "$PARAM" --vk other.key pv_0.bin 2 15
+expect "proof under another key rejects" fail "$ROOT/verifier" "$PARAM" --vk run.key pv_0.bin 2 15
+"$ROOT/aggregate" "$PARAM" p1.ptau p2.ptau vk.agg pv_*.bin >/dev/null
+expect "aggregate under its key accepts" ok \
+    "$ROOT/verifier" "$PARAM" --vk other.key --aggregate vk.agg p1.ptau p2.ptau
+expect "aggregate under another key rejects" fail \
+    "$ROOT/verifier" "$PARAM" --vk run.key --aggregate vk.agg p1.ptau p2.ptau
+
+# x and y stay public through a saved .r1cs/.wtns
+"$ROOT/build_circuit" "$PARAM" 3 2 15 3 2 0 1 -o poly >/dev/null
+"$ROOT/prover" --r1cs poly.r1cs poly.wtns "$PARAM" -o r1cs.bin >/dev/null
+expect "proof from a .r1cs accepts its statement" ok "$ROOT/verifier" "$PARAM" r1cs.bin 2 15
+expect "proof from a .r1cs rejects another statement" fail "$ROOT/verifier" "$PARAM" r1cs.bin 2 16
+
+# piA plus (0, 0): a point of order 2·r, which a fold with random
+# coefficients lets through half the time
+cp pv_0.bin t.bin
+set +e
+"$ROOT/tests/torsion" "$PARAM" t.bin 0 2>/dev/null
+rc=$?
+set -e
+if [ $rc -eq 77 ]; then
+    echo "skip  proof with a point of order 2r (no point of order 2 in these params)"
+elif [ $rc -ne 0 ]; then
+    echo "FAIL  proof with a point of order 2r (tests/torsion failed)"
+    fail=1
+else
+    expect "proof with a point of order 2r rejects" fail "$ROOT/verifier" "$PARAM" t.bin 2 15
+fi
+
+exit $fail
@@ -0,0 +1,57 @@
+// tests/torsion.c: add a point of order 2 to the framed G1 element at a
+// byte offset of a file, leaving a point of order 2·r in its place.
+// Exits 77 when the params have no such point (cofactor odd or 1).
+#include <stdio.h>
+#include <stdlib.h>
+#include <pbc/pbc.h>
+#include "../include/io.h"
+
+int main(int argc, char **argv)
+{
+    if (argc != 4)
+    {
+        fprintf(stderr, "Usage: %s pairing.params file offset\n", argv[0]);
+        return 1;
+    }
+    pairing_t pairing;
+    if (load_pairing(argv[1], pairing) != 0)
+        return 1;
+    long off = atol(argv[3]);
+    FILE *f = fopen(argv[2], "r+b");
+    if (!f)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+    element_t p, t;
+    element_init_G1(p, pairing);
+    element_init_G1(t, pairing);
+    int len = element_length_in_bytes(p);
+    unsigned char *buf = calloc(len, 1);
+
+    // (0, 0) lies on y² = x³ + x and has order 2
+    element_from_bytes(t, buf);
+    element_double(p, t);
+    if (element_is0(t) || !elem_on_curve(t) || !element_is0(p))
+    {
+        fprintf(stderr, "no point of order 2 on this curve\n");
+        return 77;
+    }
+    if (fseek(f, off + 4, SEEK_SET) != 0 || fread(buf, 1, len, f) != (size_t)len)
+    {
+        fprintf(stderr, "'%s' has no element at %ld\n", argv[2], off);
+        return 1;
+    }
+    element_from_bytes(p, buf);
+    element_add(p, p, t);
+    element_to_bytes(buf, p);
+    if (fseek(f, off + 4, SEEK_SET) != 0 || fwrite(buf, 1, len, f) != (size_t)len || fclose(f) != 0)
+    {
+        fprintf(stderr, "Error writing '%s'\n", argv[2]);
+        return 1;
+    }
+    free(buf);
+    element_clear(p);
+    element_clear(t);
+    return 0;
+}